@@ -165,6 +165,51 @@ namespace Dune
 
         }
 
+        /// @brief Volume and centroid of a cell bounded by six
+        /// quadrilateral faces, such as an unfaulted corner-point cell.
+        /// Uses the same tetrahedra as polygonCellVolume() and
+        /// polygonCellCentroid() applied to every face and summed, and
+        /// gives identical results, but computes each tetrahedron once.
+        /// @param face_pts the corners of each face, in face order
+        /// @param face_centroids the centroid of each face
+        /// @param cell_centroid the common apex of the tetrahedra
+        /// @param centroid the centroid of the cell on return
+        /// @return the volume of the cell
+        template <class Point>
+        double hexahedronCellVolumeCentroid(const Point (&face_pts)[6][4],
+                                            const Point (&face_centroids)[6],
+                                            const Point& cell_centroid,
+                                            Point& centroid)
+        {
+            centroid = 0.0;
+            double tot_volume = 0.0;
+            for (int face = 0; face < 6; ++face) {
+                Point face_contrib(0.0);
+                double face_volume = 0.0;
+                for (int i = 0; i < 4; ++i) {
+                    Point tet[4] = { cell_centroid, face_centroids[face], face_pts[face][i], face_pts[face][(i+1)%4] };
+                    double small_volume = std::fabs(simplex_volume(tet));
+                    assert(small_volume > 0);
+                    Point small_centroid = tet[0];
+                    for (int j = 1; j < 4; ++j) {
+                        small_centroid += tet[j];
+                    }
+                    small_centroid *= small_volume/4.0;
+                    face_contrib += small_centroid;
+                    face_volume += small_volume;
+                }
+                // Normalise per face as polygonCellCentroid() does,
+                // such that the rounding is the same.
+                face_contrib /= face_volume;
+                face_contrib *= face_volume;
+                centroid += face_contrib;
+                tot_volume += face_volume;
+            }
+            assert(tot_volume>0);
+            centroid /= tot_volume;
+            return tot_volume;
+        }
+
     } // namespace GeometryHelpers
 
 } // namespace Dune
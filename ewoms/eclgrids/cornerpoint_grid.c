@@ -162,8 +162,8 @@ void compute_geometry(struct UnstructuredGrid *g)
     }
 }
 
-struct UnstructuredGrid *
-create_grid_cornerpoint(const struct grdecl *in, double tol)
+static struct UnstructuredGrid *
+create_grid_cornerpoint_impl(const struct grdecl *in, double *zcorn, double tol)
 {
     struct UnstructuredGrid *g;
    int                      ok;
@@ -175,7 +175,18 @@ create_grid_cornerpoint(const struct grdecl *in, double tol)
        return NULL;
    }
 
-   process_grdecl(in, tol, &pg);
+   if (zcorn != NULL)
+   {
+       if (!process_grdecl_inplace(in, zcorn, tol, 1, &pg))
+       {
+           destroy_grid(g);
+           return NULL;
+       }
+   }
+   else
+   {
+       process_grdecl(in, tol, &pg);
+   }
 
    /*
     *  Convert "struct processed_grid" to "struct UnstructuredGrid".
@@ -235,3 +246,15 @@ create_grid_cornerpoint(const struct grdecl *in, double tol)
 
    return g;
 }
+
+struct UnstructuredGrid *
+create_grid_cornerpoint(const struct grdecl *in, double tol)
+{
+    return create_grid_cornerpoint_impl(in, NULL, tol);
+}
+
+struct UnstructuredGrid *
+create_grid_cornerpoint_inplace(const struct grdecl *in, double *zcorn, double tol)
+{
+    return create_grid_cornerpoint_impl(in, zcorn, tol);
+}
@@ -55,6 +55,24 @@ extern "C" {
     struct UnstructuredGrid *
     create_grid_cornerpoint(const struct grdecl *in, double tol);
 
+    /**
+     * Version of create_grid_cornerpoint() that does not copy the ZCORN
+     * values of the specification, see process_grdecl_inplace().
+     *
+     * @param[in]     in    Corner-point specification.
+     *
+     * @param[in,out] zcorn The writable array in->zcorn refers to.  It is
+     *                      reordered during the call and holds the original
+     *                      values again on return.
+     *
+     * @param[in]     tol   Absolute tolerance of node-coincidence.
+     *
+     * @return Fully formed grid data structure, see create_grid_cornerpoint(),
+     * or NULL if zcorn is not the array in->zcorn refers to.
+     */
+    struct UnstructuredGrid *
+    create_grid_cornerpoint_inplace(const struct grdecl *in, double *zcorn, double tol);
+
     /**
      * Compute derived geometric primitives in a grid.
      *
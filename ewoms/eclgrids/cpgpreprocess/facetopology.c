@@ -172,11 +172,34 @@ faceintersection(const int *a1, const int *a2,
     (! ((a1[i]   == INT_MIN) && (b1[j]   == INT_MIN)) &&        \
      ! ((a1[i+1] == INT_MAX) && (b1[j+1] == INT_MAX)))
 
-/* work should be pointer to 2n ints initialised to zero . */
-void findconnections(int n, int *pts[4],
-                     int *intersectionlist,
-                     int *work,
-                     struct processed_grid *out)
+/* Conclude a face whose nodes end at f.  When counting, the face is
+ * only tallied and the face and neighbour buffers are rewound for the
+ * next face. */
+static int *
+endface(int *f, int **c, int *fbuf, int *cbuf,
+        struct processed_grid *out, struct connection_count *count)
+{
+    if (count != NULL) {
+        count->faces      += 1;
+        count->face_nodes += (int) (f - fbuf);
+
+        *c = cbuf;
+        return fbuf;
+    }
+
+    out->face_ptr[++out->number_of_faces] = f - out->face_nodes;
+
+    return f;
+}
+
+/* Common implementation of findconnections() and countconnections().
+ * Connections are counted rather than stored if count != NULL. */
+static void
+connections(int n, int *pts[4],
+            int *intersectionlist,
+            int *work,
+            struct processed_grid *out,
+            struct connection_count *count)
 {
     /* vectors of point numbers for faces a(b) on pillar 1(2) */
     int *a1 = pts[0];
@@ -184,20 +207,39 @@ void findconnections(int n, int *pts[4],
     int *b1 = pts[2];
     int *b2 = pts[3];
 
+    /* Scratch space for a single face when counting */
+    int fbuf[8], cbuf[2], ibuf[4];
+
     /* Intersection record for top line and bottomline of a */
     int *itop    = work;
     int *ibottom = work + n;
-    int *f       = out->face_nodes + out->face_ptr[out->number_of_faces];
-    int *c       = out->face_neighbors + 2*out->number_of_faces;
+    int *f;
+    int *c;
+    int node;
 
     int k1  = 0;
     int k2  = 0;
 
+    /* Ranges of itop and ibottom written since they were last reset */
+    int top_lo = n, top_hi = -1;
+    int bot_lo = n, bot_hi = -1;
+
     int i,j=0;
     int intersect[4];
     int *tmp;
     /* for (i=0; i<2*n; work[i++]=-1); */
 
+    if (count != NULL) {
+        f    = fbuf;
+        c    = cbuf;
+        node = 0;
+    }
+    else {
+        f    = out->face_nodes + out->face_ptr[out->number_of_faces];
+        c    = out->face_neighbors + 2*out->number_of_faces;
+        node = out->number_of_nodes;
+    }
+
     for (i = 0; i < 4; i++) { intersect[i] = -1; }
 
     for (i = 0; i < n - 1; ++i) {
@@ -217,6 +259,8 @@ void findconnections(int n, int *pts[4],
                 (b2[j] == b2[j + 1])) {
 
                 itop[j+1] = itop[j];
+                top_lo = MIN(top_lo, j+1);
+                top_hi = MAX(top_hi, j+1);
                 ++j;
                 continue;
             }
@@ -247,7 +291,7 @@ void findconnections(int n, int *pts[4],
                             if (a2[i+1] != a2[i]) { *f++ = a2[i+1]; }
                             if (a1[i+1] != a1[i]) { *f++ = a1[i+1]; }
 
-                            out->face_ptr[++out->number_of_faces] = f - out->face_nodes;
+                            f = endface(f, &c, fbuf, cbuf, out, count);
 
                         }
                         else{
@@ -262,7 +306,11 @@ void findconnections(int n, int *pts[4],
                     /* Find new intersection */
                     if (LINE_INTERSECTION(a1[i+1], a2[i+1],
                                           b1[j+1], b2[j+1])) {
-                        itop[j+1] = out->number_of_nodes++;
+                        itop[j+1] = node++;
+
+                        if (count != NULL) {
+                            intersectionlist = ibuf;
+                        }
 
                         /* store point numbers of intersecting lines */
                         *intersectionlist++ = a1[i+1];
@@ -273,6 +321,8 @@ void findconnections(int n, int *pts[4],
                     }else{
                         itop[j+1] = -1;
                     }
+                    top_lo = MIN(top_lo, j+1);
+                    top_hi = MAX(top_hi, j+1);
 
                     /* Update intersection record */
                     intersect[0] = ibottom[j  ];  /* i   x j   */
@@ -297,7 +347,7 @@ void findconnections(int n, int *pts[4],
 
                             f = computeFaceTopology(a1+i, a2+i, b1+j, b2+j, intersect, f);
 
-                            out->face_ptr[++out->number_of_faces] = f - out->face_nodes;
+                            f = endface(f, &c, fbuf, cbuf, out, count);
                         }
                         else{
                             ;
@@ -316,13 +366,43 @@ void findconnections(int n, int *pts[4],
         /* Swap intersection records: top line of a[i,i+1] is bottom
          * line of a[i+1,i+2] */
         tmp = itop; itop = ibottom; ibottom = tmp;
+        j = top_lo; top_lo = bot_lo; bot_lo = j;
+        j = top_hi; top_hi = bot_hi; bot_hi = j;
 
-        /* Zero out the "new" itop */
-        for(j=0;j<n; ++j) { itop[j]=-1; }
+        /* Zero out the "new" itop.  Only the entries written while it
+         * was the top record may differ from -1, so resetting these
+         * keeps the sweep linear in the number of overlapping faces
+         * rather than quadratic in the number of layers. */
+        for (j = top_lo; j <= top_hi; ++j) { itop[j] = -1; }
+        top_lo = n; top_hi = -1;
 
         /* Set j to appropriate start position for next i */
         j = MIN(k1, k2);
     }
+
+    if (count != NULL) {
+        count->intersections += node;
+    }
+    else {
+        out->number_of_nodes = node;
+    }
+}
+
+/* work should be pointer to 2n ints initialised to zero . */
+void findconnections(int n, int *pts[4],
+                     int *intersectionlist,
+                     int *work,
+                     struct processed_grid *out)
+{
+    connections(n, pts, intersectionlist, work, out, NULL);
+}
+
+/* work should be pointer to 2n ints initialised to zero . */
+void countconnections(int n, int *pts[4],
+                      int *work,
+                      struct connection_count *count)
+{
+    connections(n, pts, NULL, work, NULL, count);
 }
 
 /* Local Variables:    */
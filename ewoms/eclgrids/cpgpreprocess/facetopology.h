@@ -19,11 +19,25 @@
 #ifndef EWOMS_FACETOPOLOGY_HEADER
 #define EWOMS_FACETOPOLOGY_HEADER
 
+/* Number of connections (faces), face nodes and new (intersection)
+ * nodes along a pillar pair. */
+struct connection_count {
+    int faces;
+    int face_nodes;
+    int intersections;
+};
+
 void findconnections(int n, int *pts[4],
                      int *intersectionlist,
                      int *work,
                      struct processed_grid *out);
 
+/* Accumulate the sizes of the connections that findconnections()
+ * would establish along a pillar pair in *count. */
+void countconnections(int n, int *pts[4],
+                      int *work,
+                      struct connection_count *count);
+
 #endif /* EWOMS_FACETOPOLOGY_HEADER */
 
 /* Local Variables:    */
@@ -22,6 +22,10 @@
 #include "geometry.h"
 #include <assert.h>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
 /* ------------------------------------------------------------------ */
 static void
 cross(const double u[3], const double v[3], double w[3])
@@ -40,6 +44,210 @@ norm(const double w[3])
    return sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
 }
 
+/*
+ * Batched kernels for quadrilateral faces and hexahedral cells.
+ *
+ * The faces and cells of corner-point grids are predominantly quadrilaterals
+ * and hexahedra.  These are processed GEOMETRY_LANES at a time with their
+ * node coordinates gathered into structure-of-arrays form, one lane per face
+ * or cell.  The arithmetic is the same sequence of operations as in the
+ * scalar triangle fans below, such that the results are bitwise identical
+ * unless the compiler contracts multiply-adds differently in the two paths
+ * (e.g. with FMA enabled), in which case they agree to within 1e-12 relative
+ * to the magnitude of the areas, volumes and coordinates involved.
+ *
+ * The lanes map to AVX registers if available, otherwise to plain arrays
+ * that the compiler is free to vectorise.
+ */
+#define GEOMETRY_LANES 4
+
+#if defined(__AVX__)
+typedef __m256d vreal;
+
+static vreal vset (double a)           { return _mm256_set1_pd(a);    }
+static vreal vload(const double *a)    { return _mm256_loadu_pd(a);   }
+static void  vstore(double *a, vreal b){ _mm256_storeu_pd(a, b);     }
+static vreal vadd (vreal a, vreal b)   { return _mm256_add_pd(a, b);  }
+static vreal vsub (vreal a, vreal b)   { return _mm256_sub_pd(a, b);  }
+static vreal vmul (vreal a, vreal b)   { return _mm256_mul_pd(a, b);  }
+static vreal vdiv (vreal a, vreal b)   { return _mm256_div_pd(a, b);  }
+static vreal vsqrt(vreal a)            { return _mm256_sqrt_pd(a);    }
+
+/* Negate the lanes of a for which s is negative. */
+static vreal
+vflip(vreal a, vreal s)
+{
+   const vreal neg = _mm256_cmp_pd(s, _mm256_setzero_pd(), _CMP_LT_OQ);
+   return _mm256_xor_pd(a, _mm256_and_pd(neg, _mm256_set1_pd(-0.0)));
+}
+#else
+typedef struct { double x[GEOMETRY_LANES]; } vreal;
+
+#define VREAL_OP(name, expr)                                      \
+   static vreal name(vreal a, vreal b)                            \
+   {                                                              \
+      vreal r; int l;                                             \
+      for (l=0; l<GEOMETRY_LANES; ++l) r.x[l] = (expr);           \
+      return r;                                                   \
+   }
+
+VREAL_OP(vadd, a.x[l] + b.x[l])
+VREAL_OP(vsub, a.x[l] - b.x[l])
+VREAL_OP(vmul, a.x[l] * b.x[l])
+VREAL_OP(vdiv, a.x[l] / b.x[l])
+VREAL_OP(vflip, b.x[l] < 0.0 ? -a.x[l] : a.x[l])
+
+#undef VREAL_OP
+
+static vreal
+vset(double a)
+{
+   vreal r; int l;
+   for (l=0; l<GEOMETRY_LANES; ++l) r.x[l] = a;
+   return r;
+}
+
+static vreal
+vload(const double *a)
+{
+   vreal r; int l;
+   for (l=0; l<GEOMETRY_LANES; ++l) r.x[l] = a[l];
+   return r;
+}
+
+static void
+vstore(double *a, vreal b)
+{
+   int l;
+   for (l=0; l<GEOMETRY_LANES; ++l) a[l] = b.x[l];
+}
+
+static vreal
+vsqrt(vreal a)
+{
+   vreal r; int l;
+   for (l=0; l<GEOMETRY_LANES; ++l) r.x[l] = sqrt(a.x[l]);
+   return r;
+}
+#endif
+
+/* ------------------------------------------------------------------ */
+static void
+vcross(const vreal u[3], const vreal v[3], vreal w[3])
+/* ------------------------------------------------------------------ */
+{
+   w[0] = vsub(vmul(u[1],v[2]), vmul(u[2],v[1]));
+   w[1] = vsub(vmul(u[2],v[0]), vmul(u[0],v[2]));
+   w[2] = vsub(vmul(u[0],v[1]), vmul(u[1],v[0]));
+}
+
+/* ------------------------------------------------------------------ */
+static vreal
+vdot(const vreal u[3], const vreal v[3])
+/* ------------------------------------------------------------------ */
+{
+   /* Accumulate from zero like the scalar loops. */
+   vreal d = vset(0.0);
+   int i;
+   for (i=0; i<3; ++i) d = vadd(d, vmul(u[i], v[i]));
+   return d;
+}
+
+/* ------------------------------------------------------------------ */
+static void
+gather_quad(const double *coords, const int *nodepos, const int *facenodes,
+            const int faces[GEOMETRY_LANES],
+            double p[4][3][GEOMETRY_LANES])
+/* ------------------------------------------------------------------ */
+{
+   int l, k, i, node;
+   for (l=0; l<GEOMETRY_LANES; ++l)
+   {
+      for (k=0; k<4; ++k)
+      {
+         node = facenodes[nodepos[faces[l]] + k];
+         for (i=0; i<3; ++i) p[k][i][l] = coords[3*node+i];
+      }
+   }
+}
+
+/* ------------------------------------------------------------------ */
+static void
+quad_centre(double p[4][3][GEOMETRY_LANES], vreal x[3])
+/* ------------------------------------------------------------------ */
+{
+   int i, k;
+   for (i=0; i<3; ++i)
+   {
+      x[i] = vset(0.0);
+      for (k=0; k<4; ++k) x[i] = vadd(x[i], vload(p[k][i]));
+      x[i] = vdiv(x[i], vset(4.0));
+   }
+}
+
+/* ------------------------------------------------------------------ */
+static void
+compute_quad_geometry_3d(double *coords, int *nodepos, int *facenodes,
+                         const int faces[GEOMETRY_LANES],
+                         double *fnormals, double *fcentroids,
+                         double *fareas)
+/* ------------------------------------------------------------------ */
+{
+   const vreal half = vset(0.5);
+   const vreal third = vset(0.666666666666666666666666666667*0.5);
+   double p[4][3][GEOMETRY_LANES];
+   double out[7][GEOMETRY_LANES];
+   vreal x[3], u[3], v[3], w[3];
+   vreal n[3], cface[3];
+   vreal a, area;
+   int i, k, l;
+
+   gather_quad(coords, nodepos, facenodes, faces, p);
+   quad_centre(p, x);
+
+   for (i=0; i<3; ++i)
+   {
+      u[i] = vsub(vload(p[3][i]), x[i]);
+      n[i] = vset(0.0);
+      cface[i] = vset(0.0);
+   }
+
+   area = vset(0.0);
+   for (k=0; k<4; ++k)
+   {
+      for (i=0; i<3; ++i) v[i] = vsub(vload(p[k][i]), x[i]);
+
+      vcross(u, v, w);
+      a = vmul(half, vsqrt(vdot(w, w)));
+      area = vadd(area, a);
+
+      for (i=0; i<3; ++i)
+      {
+         n[i] = vadd(n[i], w[i]);
+         cface[i] = vadd(cface[i],
+                         vmul(a, vadd(x[i], vmul(third, vadd(u[i], v[i])))));
+         u[i] = v[i];
+      }
+   }
+
+   for (i=0; i<3; ++i)
+   {
+      vstore(out[i],   vmul(half, n[i]));
+      vstore(out[3+i], vdiv(cface[i], area));
+   }
+   vstore(out[6], area);
+
+   for (l=0; l<GEOMETRY_LANES; ++l)
+   {
+      for (i=0; i<3; ++i)
+      {
+         fnormals  [3*faces[l]+i] = out[i][l];
+         fcentroids[3*faces[l]+i] = out[3+i][l];
+      }
+      fareas[faces[l]] = out[6][l];
+   }
+}
+
 /* ------------------------------------------------------------------ */
 static void
 compute_face_geometry_3d(double *coords, int nfaces,
@@ -65,8 +273,23 @@ compute_face_geometry_3d(double *coords, int nfaces,
    double a;
    int    num_face_nodes;
    double area;
+   int    quads[GEOMETRY_LANES];
+   int    nquads = 0;
    for (f=0; f<nfaces; ++f)
    {
+      /* Quadrilaterals are collected and processed in batches */
+      if (nodepos[f+1] - nodepos[f] == 4)
+      {
+         quads[nquads++] = f;
+         if (nquads == GEOMETRY_LANES)
+         {
+            compute_quad_geometry_3d(coords, nodepos, facenodes, quads,
+                                     fnormals, fcentroids, fareas);
+            nquads = 0;
+         }
+         continue;
+      }
+
       for(i=0; i<ndims; ++i) x[i] = 0.0;
       for(i=0; i<ndims; ++i) n[i] = 0.0;
       for(i=0; i<ndims; ++i) cface[i] = 0.0;
@@ -120,6 +343,14 @@ compute_face_geometry_3d(double *coords, int nfaces,
       }
       fareas[f] = area;
    }
+
+   /* Fill a partial last batch by repeating its last face */
+   if (nquads > 0)
+   {
+      for (i=nquads; i<GEOMETRY_LANES; ++i) quads[i] = quads[nquads-1];
+      compute_quad_geometry_3d(coords, nodepos, facenodes, quads,
+                               fnormals, fcentroids, fareas);
+   }
 }
 
 /* ------------------------------------------------------------------ */
@@ -212,6 +443,116 @@ compute_face_geometry(int ndims, double *coords, int nfaces,
    }
 }
 
+/* ------------------------------------------------------------------ */
+static int
+is_hexahedron(int *nodepos, int *facepos, int *cellfaces, int c)
+/* ------------------------------------------------------------------ */
+{
+   int f, face;
+   if (facepos[c+1] - facepos[c] != 6) return 0;
+   for (f=facepos[c]; f<facepos[c+1]; ++f)
+   {
+      face = cellfaces[f];
+      if (nodepos[face+1] - nodepos[face] != 4) return 0;
+   }
+   return 1;
+}
+
+/* ------------------------------------------------------------------ */
+static void
+compute_hex_geometry_3d(double *coords,
+                        int *nodepos, int *facenodes, int *neighbors,
+                        double *fnormals, double *fcentroids,
+                        int *facepos, int *cellfaces,
+                        const int cells[GEOMETRY_LANES],
+                        double *ccentroids, double *cvolumes)
+/* ------------------------------------------------------------------ */
+{
+   const vreal third = vset(0.666666666666666666666666666667*0.5);
+   const vreal sixth = vset(0.5 / 3);
+   double p[4][3][GEOMETRY_LANES];
+   double fn[3][GEOMETRY_LANES];
+   double s[GEOMETRY_LANES];
+   double out[4][GEOMETRY_LANES];
+   int faces[6][GEOMETRY_LANES];
+   vreal x[3], u[3], v[3], w[3], d[3], nrm[3];
+   vreal xcell[3], ccell[3];
+   vreal volume, tet_volume, outside;
+   int i, j, k, l, face;
+
+   for (l=0; l<GEOMETRY_LANES; ++l)
+   {
+      for (j=0; j<6; ++j) faces[j][l] = cellfaces[facepos[cells[l]] + j];
+   }
+
+   /* Approximate cell centre as average of face centroids */
+   for (i=0; i<3; ++i) xcell[i] = vset(0.0);
+   for (j=0; j<6; ++j)
+   {
+      for (l=0; l<GEOMETRY_LANES; ++l)
+      {
+         for (i=0; i<3; ++i) p[0][i][l] = fcentroids[3*faces[j][l]+i];
+      }
+      for (i=0; i<3; ++i) xcell[i] = vadd(xcell[i], vload(p[0][i]));
+   }
+   for (i=0; i<3; ++i)
+   {
+      xcell[i] = vdiv(xcell[i], vset(6.0));
+      ccell[i] = vset(0.0);
+   }
+
+   volume = vset(0.0);
+   for (j=0; j<6; ++j)
+   {
+      gather_quad(coords, nodepos, facenodes, faces[j], p);
+      for (l=0; l<GEOMETRY_LANES; ++l)
+      {
+         face = faces[j][l];
+         for (i=0; i<3; ++i) fn[i][l] = fnormals[3*face+i];
+         s[l] = (neighbors[2*face+0] == cells[l]) ? 1.0 : -1.0;
+      }
+      for (i=0; i<3; ++i) nrm[i] = vload(fn[i]);
+      outside = vload(s);
+
+      quad_centre(p, x);
+      for (i=0; i<3; ++i)
+      {
+         u[i] = vsub(vload(p[3][i]), x[i]);
+         d[i] = vsub(x[i], xcell[i]);
+      }
+
+      for (k=0; k<4; ++k)
+      {
+         for (i=0; i<3; ++i) v[i] = vsub(vload(p[k][i]), x[i]);
+
+         vcross(u, v, w);
+         tet_volume = vmul(vdot(w, d), sixth);
+         tet_volume = vflip(tet_volume, vdot(w, nrm));
+         tet_volume = vflip(tet_volume, outside);
+         volume = vadd(volume, tet_volume);
+
+         for (i=0; i<3; ++i)
+         {
+            /* Triangle centroid relative to cell centre */
+            ccell[i] = vadd(ccell[i],
+                            vmul(vdiv(vmul(tet_volume, vset(3.0)), vset(4.0)),
+                                 vsub(vadd(x[i], vmul(third, vadd(u[i], v[i]))),
+                                      xcell[i])));
+            u[i] = v[i];
+         }
+      }
+   }
+
+   for (i=0; i<3; ++i) vstore(out[i], vadd(xcell[i], vdiv(ccell[i], volume)));
+   vstore(out[3], volume);
+
+   for (l=0; l<GEOMETRY_LANES; ++l)
+   {
+      for (i=0; i<3; ++i) ccentroids[3*cells[l]+i] = out[i][l];
+      cvolumes[cells[l]] = out[3][l];
+   }
+}
+
 /* ------------------------------------------------------------------ */
 static void
 compute_cell_geometry_3d(double *coords,
@@ -236,8 +577,23 @@ compute_cell_geometry_3d(double *coords,
    double volume;
    double tet_volume, subnormal_sign;
    double twothirds = 0.666666666666666666666666666667;
+   int    hexes[GEOMETRY_LANES];
+   int    nhexes = 0;
    for (c=0; c<ncells; ++c)
    {
+      /* Hexahedra are collected and processed in batches */
+      if (is_hexahedron(nodepos, facepos, cellfaces, c))
+      {
+         hexes[nhexes++] = c;
+         if (nhexes == GEOMETRY_LANES)
+         {
+            compute_hex_geometry_3d(coords, nodepos, facenodes, neighbors,
+                                    fnormals, fcentroids, facepos, cellfaces,
+                                    hexes, ccentroids, cvolumes);
+            nhexes = 0;
+         }
+         continue;
+      }
 
       for(i=0; i<ndims; ++i) xcell[i] = 0.0;
       for(i=0; i<ndims; ++i) ccell[i] = 0.0;
@@ -322,6 +678,15 @@ compute_cell_geometry_3d(double *coords,
       for (i=0; i<ndims; ++i) ccentroids[3*c+i] = xcell[i] + ccell[i]/volume;
       cvolumes[c] = volume;
    }
+
+   /* Fill a partial last batch by repeating its last cell */
+   if (nhexes > 0)
+   {
+      for (i=nhexes; i<GEOMETRY_LANES; ++i) hexes[i] = hexes[nhexes-1];
+      compute_hex_geometry_3d(coords, nodepos, facenodes, neighbors,
+                              fnormals, fcentroids, facepos, cellfaces,
+                              hexes, ccentroids, cvolumes);
+   }
 }
 
 /* ------------------------------------------------------------------ */
@@ -19,11 +19,16 @@
 #include "config.h"
 #include <assert.h>
 #include <float.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 #include "preprocess.h"
 #include "uniquepoints.h"
 #include "facetopology.h"
@@ -34,17 +39,14 @@
 static void
 compute_cell_index(const int dims[3], int i, int j, int *neighbors, int len);
 
-static int
-checkmemory(int nz, struct processed_grid *out, int **intersections);
-
 static void
-process_vertical_faces(int direction,
-                       int **intersections,
+process_vertical_faces(int direction, int begin, int end,
+                       int *intersections,
                        int *plist, int *work,
                        struct processed_grid *out);
 
 static void
-process_horizontal_faces(int **intersections,
+process_horizontal_faces(int begin, int end,
                          int *plist,
                          struct processed_grid *out);
 
@@ -111,60 +113,35 @@ compute_cell_index(const int dims[3], int i, int j,
 }
 
 /*-----------------------------------------------------------------
-  Ensure there's sufficient memory */
-static int
-checkmemory(int nz, struct processed_grid *out, int **intersections)
+  Point numbers of the faces along the pillar pair between pillar
+  columns (i-1+direction, j-direction) and (i, j), oriented as
+  expected by findconnections().  */
+static void
+vertical_face_pillars(int direction, int i, int j, int *plist,
+                      const struct processed_grid *out, int *cornerpts[4])
 {
-    int r, m, n, ok;
-
-    /* Ensure there is enough space to manage the (pathological) case
-     * of every single cell on one side of a fault connecting to all
-     * cells on the other side of the fault (i.e., an all-to-all cell
-     * connectivity pairing). */
-    r = (2*nz + 2) * (2*nz + 2);
-    m = out->m;
-    n = out->n;
-
-    if (out->number_of_faces +  r > m) {
-        m += MAX(m / 2,  2 * r);
-    }
-    if (out->face_ptr[out->number_of_faces] + 6*r > n) {
-        n += MAX(n / 2, 12 * r);
-    }
-
-    ok = m == out->m;
-    if (! ok) {
-        void *p1, *p2, *p3, *p4;
-
-        p1 = realloc(*intersections     , 4*m   * sizeof **intersections);
-        p2 = realloc(out->face_neighbors, 2*m   * sizeof *out->face_neighbors);
-        p3 = realloc(out->face_ptr      , (m+1) * sizeof *out->face_ptr);
-        p4 = realloc(out->face_tag      , 1*m   * sizeof *out->face_tag);
-
-        if (p1 != NULL) { *intersections      = p1; }
-        if (p2 != NULL) { out->face_neighbors = p2; }
-        if (p3 != NULL) { out->face_ptr       = p3; }
-        if (p4 != NULL) { out->face_tag       = p4; }
-
-        ok = (p1 != NULL) && (p2 != NULL) && (p3 != NULL) && (p4 != NULL);
-
-        if (ok) { out->m = m; }
-    }
-
-    if (ok && (n != out->n)) {
-        void *p1;
-
-        p1 = realloc(out->face_nodes, n * sizeof *out->face_nodes);
-
-        ok = p1 != NULL;
+    int d[3];
+    int *tmp;
 
-        if (ok) {
-            out->face_nodes = p1;
-            out->n          = n;
-        }
+    d[0] = 2 * (out->dimensions[0] + 0);
+    d[1] = 2 * (out->dimensions[1] + 0);
+    d[2] = 2 * (out->dimensions[2] + 1);
+
+    /* Vectors of point numbers */
+    igetvectors(d, 2*i + direction, 2*j + (1 - direction),
+                plist, cornerpts);
+
+    if (direction == 1) {
+        /* 1   3       0   1    */
+        /*       --->           */
+        /* 0   2       2   3    */
+        /* rotate clockwise     */
+        tmp          = cornerpts[1];
+        cornerpts[1] = cornerpts[0];
+        cornerpts[0] = cornerpts[2];
+        cornerpts[2] = cornerpts[3];
+        cornerpts[3] = tmp;
     }
-
-    return ok;
 }
 
 /*-----------------------------------------------------------------
@@ -175,21 +152,23 @@ checkmemory(int nz, struct processed_grid *out, int **intersections)
 
   direction == 0 : constant-i faces.
   direction == 1 : constant-j faces.
+
+  Only the pillar pairs with linear index i + (nx+1-direction)*j in
+  the range [begin, end) are processed.  The output arrays must be
+  large enough to hold the new faces and intersections, see
+  count_vertical_faces().
 */
 static void
-process_vertical_faces(int direction,
-                       int **intersections,
+process_vertical_faces(int direction, int begin, int end,
+                       int *intersections,
                        int *plist, int *work,
                        struct processed_grid *out)
 {
-    int i,j;
+    int i,j,p;
     int *cornerpts[4];
-    int d[3];
     int f;
     enum face_tag tag[] = { I_FACE, J_FACE };
-    int *tmp;
     int nx = out->dimensions[0];
-    int ny = out->dimensions[1];
     int nz = out->dimensions[2];
     int startface;
     int num_intersections;
@@ -198,69 +177,75 @@ process_vertical_faces(int direction,
 
     assert ((direction == 0) || (direction == 1));
 
-    d[0] = 2 * (nx + 0);
-    d[1] = 2 * (ny + 0);
-    d[2] = 2 * (nz + 1);
+    for (p = begin; p < end; ++p) {
+        i = p % (nx + (1 - direction));
+        j = p / (nx + (1 - direction));
 
-    for (j = 0; j < ny + direction; ++j) {
-        for (i = 0; i < nx + (1 - direction); ++i) {
+        vertical_face_pillars(direction, i, j, plist, out, cornerpts);
 
-            if (! checkmemory(nz, out, intersections)) {
-                fprintf(stderr,
-                        "Could not allocate enough space in "
-                        "process_vertical_faces()\n");
-                exit(1);
-            }
+        /* int startface = ftab->position; */
+        startface = out->number_of_faces;
+        /* int num_intersections = *npoints - npillarpoints; */
+        num_intersections = out->number_of_nodes -
+            out->number_of_nodes_on_pillars;
 
-            /* Vectors of point numbers */
-            igetvectors(d, 2*i + direction, 2*j + (1 - direction),
-                        plist, cornerpts);
-
-            if (direction == 1) {
-                /* 1   3       0   1    */
-                /*       --->           */
-                /* 0   2       2   3    */
-                /* rotate clockwise     */
-                tmp          = cornerpts[1];
-                cornerpts[1] = cornerpts[0];
-                cornerpts[0] = cornerpts[2];
-                cornerpts[2] = cornerpts[3];
-                cornerpts[3] = tmp;
-            }
+        /* Establish new connections (faces) along pillar pair. */
+        findconnections(2*nz + 2, cornerpts,
+                        intersections + 4*num_intersections,
+                        work, out);
 
-            /* int startface = ftab->position; */
-            startface = out->number_of_faces;
-            /* int num_intersections = *npoints - npillarpoints; */
-            num_intersections = out->number_of_nodes -
-                out->number_of_nodes_on_pillars;
-
-            /* Establish new connections (faces) along pillar pair. */
-            findconnections(2*nz + 2, cornerpts,
-                            *intersections + 4*num_intersections,
-                            work, out);
-
-            /* Start of ->face_neighbors[] for this set of connections. */
-            ptr = out->face_neighbors + 2*startface;
-
-            /* Total number of cells (both sides) connected by this
-             * set of connections (faces). */
-            len = 2*out->number_of_faces - 2*startface;
-
-            /* Derive inter-cell connectivity (i.e. ->face_neighbors)
-             * of global (uncompressed) cells for this set of
-             * connections (faces). */
-            compute_cell_index(out->dimensions, i-1+direction, j-direction, ptr    , len);
-            compute_cell_index(out->dimensions, i            , j          , ptr + 1, len);
-
-            /* Tag the new faces */
-            f = startface;
-            for (; f < out->number_of_faces; ++f) {
-                out->face_tag[f] = tag[direction];
-            }
+        /* Start of ->face_neighbors[] for this set of connections. */
+        ptr = out->face_neighbors + 2*startface;
+
+        /* Total number of cells (both sides) connected by this
+         * set of connections (faces). */
+        len = 2*out->number_of_faces - 2*startface;
+
+        /* Derive inter-cell connectivity (i.e. ->face_neighbors)
+         * of global (uncompressed) cells for this set of
+         * connections (faces). */
+        compute_cell_index(out->dimensions, i-1+direction, j-direction, ptr    , len);
+        compute_cell_index(out->dimensions, i            , j          , ptr + 1, len);
+
+        /* Tag the new faces */
+        f = startface;
+        for (; f < out->number_of_faces; ++f) {
+            out->face_tag[f] = tag[direction];
         }
     }
 }
 
+/*-----------------------------------------------------------------
+  Counting pass of process_vertical_faces() for the single pillar
+  pair with linear index p.  */
+static void
+count_vertical_faces(int direction, int p, int *plist, int *work,
+                     const struct processed_grid *out,
+                     struct connection_count *count)
+{
+    int *cornerpts[4];
+    int nx = out->dimensions[0];
+    int nz = out->dimensions[2];
+
+    vertical_face_pillars(direction,
+                          p % (nx + (1 - direction)),
+                          p / (nx + (1 - direction)),
+                          plist, out, cornerpts);
+
+    countconnections(2*nz + 2, cornerpts, work, count);
+}
+
+/*-----------------------------------------------------------------
+  True if the space between horizontal lines k and k+1 of a pillar
+  column with point number vectors c is collapsed. */
+static int
+collapsed(int *c[4], int k)
+{
+    return
+        c[0][k] == c[0][k+1] && c[1][k] == c[1][k+1] &&
+        c[2][k] == c[2][k+1] && c[3][k] == c[3][k+1];
+}
+
 /*-----------------------------------------------------------------
   For each horizontal face (i.e. k constant),
   -find point numbers for the corners and
@@ -271,13 +256,16 @@ process_vertical_faces(int direction,
   cells that are have collapsed coordinates. (This includes cells with
   ACTNUM==0)
 
+  Only the pillar columns with linear index i + nx*j in the range
+  [begin, end) are processed.  The output arrays must be large enough
+  to hold the new faces, see count_horizontal_faces().
 */
 static void
-process_horizontal_faces(int **intersections,
+process_horizontal_faces(int begin, int end,
                          int *plist,
                          struct processed_grid *out)
 {
-    int i,j,k;
+    int i,j,k,p;
 
     int nx = out->dimensions[0];
     int ny = out->dimensions[1];
@@ -295,41 +283,52 @@ process_horizontal_faces(int **intersections,
     d[1] = 2*ny;
     d[2] = 2+2*nz;
 
-    for(j=0; j<ny; ++j) {
-        for (i=0; i<nx; ++i) {
+    for (p = begin; p < end; ++p) {
+        i = p % nx;
+        j = p / nx;
 
-            if (! checkmemory(nz, out, intersections)) {
-                fprintf(stderr,
-                        "Could not allocate enough space in "
-                        "process_horizontal_faces()\n");
-                exit(1);
-            }
+        f = out->face_nodes     + out->face_ptr[out->number_of_faces];
+        n = out->face_neighbors + 2*out->number_of_faces;
+
+        /* Vectors of point numbers */
+        igetvectors(d, 2*i+1, 2*j+1, plist, c);
+
+        prevcell = -1;
 
-            f = out->face_nodes     + out->face_ptr[out->number_of_faces];
-            n = out->face_neighbors + 2*out->number_of_faces;
+        for (k = 1; k<nz*2+1; ++k){
 
-            /* Vectors of point numbers */
-            igetvectors(d, 2*i+1, 2*j+1, plist, c);
+            /* Skip if space between face k and face k+1 is collapsed. */
+            /* Note that inactive cells (with ACTNUM==0) have all been  */
+            /* collapsed in finduniquepoints.                           */
+            if (collapsed(c, k)){
 
-            prevcell = -1;
+                /* If the pinch is a cell: */
+                if (k%2){
+                    idx = linearindex(out->dimensions, i,j,(k-1)/2);
+                    cell[idx] = -1;
+                }
+            }
+            else{
 
-            for (k = 1; k<nz*2+1; ++k){
+                if (k%2){
+                    /* Add face */
+                    *f++ = c[0][k];
+                    *f++ = c[2][k];
+                    *f++ = c[3][k];
+                    *f++ = c[1][k];
 
-                /* Skip if space between face k and face k+1 is collapsed. */
-                /* Note that inactive cells (with ACTNUM==0) have all been  */
-                /* collapsed in finduniquepoints.                           */
-                if (c[0][k] == c[0][k+1] && c[1][k] == c[1][k+1] &&
-                    c[2][k] == c[2][k+1] && c[3][k] == c[3][k+1]){
+                    out->face_tag[  out->number_of_faces] = K_FACE;
+                    out->face_ptr[++out->number_of_faces] = f - out->face_nodes;
+
+                    thiscell = linearindex(out->dimensions, i,j,(k-1)/2);
+                    *n++ = prevcell;
+                    *n++ = prevcell = thiscell;
+
+                    cell[thiscell] = cellno++;
 
-                    /* If the pinch is a cell: */
-                    if (k%2){
-                        idx = linearindex(out->dimensions, i,j,(k-1)/2);
-                        cell[idx] = -1;
-                    }
                 }
                 else{
-
-                    if (k%2){
+                    if (prevcell != -1){
                         /* Add face */
                         *f++ = c[0][k];
                         *f++ = c[2][k];
@@ -339,27 +338,8 @@ process_horizontal_faces(int **intersections,
                         out->face_tag[  out->number_of_faces] = K_FACE;
                         out->face_ptr[++out->number_of_faces] = f - out->face_nodes;
 
-                        thiscell = linearindex(out->dimensions, i,j,(k-1)/2);
                         *n++ = prevcell;
-                        *n++ = prevcell = thiscell;
-
-                        cell[thiscell] = cellno++;
-
-                    }
-                    else{
-                        if (prevcell != -1){
-                            /* Add face */
-                            *f++ = c[0][k];
-                            *f++ = c[2][k];
-                            *f++ = c[3][k];
-                            *f++ = c[1][k];
-
-                            out->face_tag[  out->number_of_faces] = K_FACE;
-                            out->face_ptr[++out->number_of_faces] = f - out->face_nodes;
-
-                            *n++ = prevcell;
-                            *n++ = prevcell = -1;
-                        }
+                        *n++ = prevcell = -1;
                     }
                 }
             }
@@ -368,6 +348,310 @@ process_horizontal_faces(int **intersections,
     out->number_of_cells = cellno;
 }
 
+/*-----------------------------------------------------------------
+  Counting pass of process_horizontal_faces() for the single pillar
+  column with linear index p.  */
+static void
+count_horizontal_faces(int p, int *plist,
+                       const struct processed_grid *out,
+                       struct connection_count *count)
+{
+    int k, open;
+    int *c[4];
+    int nx = out->dimensions[0];
+    int nz = out->dimensions[2];
+    int d[3];
+
+    d[0] = 2*nx;
+    d[1] = 2*out->dimensions[1];
+    d[2] = 2+2*nz;
+
+    igetvectors(d, 2*(p % nx)+1, 2*(p / nx)+1, plist, c);
+
+    /* A face is added at the top of each non-collapsed cell and at
+     * each non-collapsed gap below a cell. */
+    open = 0;
+    for (k = 1; k<nz*2+1; ++k){
+        if (! collapsed(c, k)){
+            if ((k%2) || open){
+                count->faces      += 1;
+                count->face_nodes += 4;
+            }
+            open = k%2;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------
+  A contiguous range of pillar pairs (vertical faces) or pillar
+  columns (horizontal faces), processed as a unit of work in
+  process_faces().  The face processing is split in a counting pass,
+  which establishes the size of the output of each tile, and a
+  filling pass, which writes each tile's faces directly into the
+  final output arrays. */
+struct face_tile {
+    int                     phase;  /* 0, 1: vertical direction, 2: horizontal */
+    int                     begin;
+    int                     end;
+    struct connection_count count;
+    int                     max_faces;  /* Largest count of a single pillar pair */
+    int                     number_of_cells;
+};
+
+/* ------------------------------------------------------------------ */
+static void
+count_tile(int *plist, int *work, const struct processed_grid *out,
+           struct face_tile *tile)
+/* ------------------------------------------------------------------ */
+{
+    int p, nf;
+
+    tile->count.faces         = 0;
+    tile->count.face_nodes    = 0;
+    tile->count.intersections = 0;
+    tile->max_faces           = 0;
+
+    for (p = tile->begin; p < tile->end; ++p) {
+        nf = tile->count.faces;
+
+        if (tile->phase < 2) {
+            count_vertical_faces(tile->phase, p, plist, work, out, &tile->count);
+        }
+        else {
+            count_horizontal_faces(p, plist, out, &tile->count);
+        }
+
+        tile->max_faces = MAX(tile->max_faces, tile->count.faces - nf);
+    }
+}
+
+/*-----------------------------------------------------------------
+  Fill the faces of a tile into the output arrays, starting at face
+  number face_offset, face node position node_pos and node number
+  node_offset for new intersection nodes.
+
+  The pillar pairs are processed one at a time through a view of the
+  output arrays whose face pointers are collected in the scratch
+  array face_ptr (at least max_faces + 1 elements).  This way no tile
+  reads output data owned by another tile.  */
+static void
+fill_tile(struct face_tile *tile,
+          int face_offset, int node_pos, int node_offset,
+          int *plist, int *work, int *face_ptr, int *intersections,
+          struct processed_grid *out)
+{
+    int p, f;
+    int face = face_offset;
+
+    struct processed_grid view = *out;
+
+    tile->number_of_cells = 0;
+
+    view.face_ptr        = face_ptr;
+    view.number_of_nodes = node_offset;
+
+    for (p = tile->begin; p < tile->end; ++p) {
+        view.number_of_faces = 0;
+        view.face_ptr[0]     = node_pos;
+        view.face_neighbors  = out->face_neighbors + 2*face;
+        view.face_tag        = out->face_tag + face;
+
+        if (tile->phase < 2) {
+            process_vertical_faces(tile->phase, p, p + 1, intersections,
+                                   plist, work, &view);
+        }
+        else {
+            process_horizontal_faces(p, p + 1, plist, &view);
+            tile->number_of_cells += view.number_of_cells;
+        }
+
+        for (f = 1; f <= view.number_of_faces; ++f) {
+            out->face_ptr[face + f] = view.face_ptr[f];
+        }
+
+        face    += view.number_of_faces;
+        node_pos = view.face_ptr[view.number_of_faces];
+    }
+
+    assert (face - face_offset == tile->count.faces);
+    assert (view.number_of_nodes - node_offset == tile->count.intersections);
+}
+
+/*-----------------------------------------------------------------
+  Establish all faces of the grid in the order
+
+      process_vertical_faces  (0, ...);
+      process_vertical_faces  (1, ...);
+      process_horizontal_faces(   ...);
+
+  and allocate the exact amount of memory needed for the face arrays,
+  the intersection list and the node coordinates.
+
+  The pillar pairs of each phase are split into contiguous tiles.  A
+  counting pass first determines the number of faces, face nodes and
+  fault intersections of each tile.  Prefix sums of these counts give
+  each tile's position in the output arrays, which are then allocated
+  once and filled in a second pass.  Both passes process the tiles
+  concurrently if nthreads > 1.  Since each tile's position follows
+  the serial processing order, the result does not depend on the
+  number of threads. */
+static int *
+process_faces(int nthreads, int *plist, struct processed_grid *out)
+{
+    int    phase, t, k, ntiles, nunits, max_faces;
+    int    nx = out->dimensions[0];
+    int    ny = out->dimensions[1];
+    int    nz = out->dimensions[2];
+    int    np = out->number_of_nodes_on_pillars;
+    int    units[3], ntiles_phase[3];
+    int   *face_offset, *pos_offset, *node_offset, *intersections;
+    size_t wsize;
+    void  *p;
+
+    struct face_tile *tiles;
+
+    units[0] = (nx + 1) * (ny + 0);
+    units[1] = (nx + 0) * (ny + 1);
+    units[2] = (nx + 0) * (ny + 0);
+
+    /* Over-decompose somewhat to balance the uneven cost of faulted
+     * and unfaulted pillar pairs. */
+    ntiles = 0;
+    for (phase = 0; phase < 3; ++phase) {
+        ntiles_phase[phase] = MIN(units[phase], (nthreads > 1) ? 4*nthreads : 1);
+        ntiles += ntiles_phase[phase];
+    }
+
+    tiles       = malloc( MAX(ntiles, 1)  * sizeof *tiles);
+    face_offset = malloc((ntiles + 1)     * sizeof *face_offset);
+    pos_offset  = malloc((ntiles + 1)     * sizeof *pos_offset);
+    node_offset = malloc((ntiles + 1)     * sizeof *node_offset);
+
+    if ((tiles == NULL) || (face_offset == NULL) ||
+        (pos_offset == NULL) || (node_offset == NULL)) {
+        fprintf(stderr, "Could not allocate face tiles\n");
+        exit(1);
+    }
+
+    for (phase = 0, t = 0; phase < 3; ++phase) {
+        nunits = units[phase];
+
+        for (k = 0; k < ntiles_phase[phase]; ++k, ++t) {
+            tiles[t].phase = phase;
+            tiles[t].begin = (int) ((((size_t) nunits) * (k + 0)) / ntiles_phase[phase]);
+            tiles[t].end   = (int) ((((size_t) nunits) * (k + 1)) / ntiles_phase[phase]);
+        }
+    }
+
+    wsize = 2 * ((size_t) (2*nz + 2));
+
+    /* Pass 1: Count */
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        size_t i;
+        int    *work = malloc(wsize * sizeof *work);
+
+        if (work == NULL) {
+            fprintf(stderr, "Could not allocate work array in "
+                    "process_faces()\n");
+            exit(1);
+        }
+        for (i = 0; i < wsize; ++i) { work[i] = -1; }
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (t = 0; t < ntiles; ++t) {
+            count_tile(plist, work, out, &tiles[t]);
+        }
+
+        free(work);
+    }
+
+    /* Position of each tile's faces, face nodes and intersection
+     * nodes in the final, serially ordered, arrays. */
+    face_offset[0] = 0;
+    pos_offset [0] = 0;
+    node_offset[0] = np;
+    max_faces      = 0;
+    for (t = 0; t < ntiles; ++t) {
+        face_offset[t + 1] = face_offset[t] + tiles[t].count.faces;
+        pos_offset [t + 1] = pos_offset [t] + tiles[t].count.face_nodes;
+        node_offset[t + 1] = node_offset[t] + tiles[t].count.intersections;
+
+        max_faces = MAX(max_faces, tiles[t].max_faces);
+    }
+
+    /* Allocate exact-size output arrays once. */
+    out->m = face_offset[ntiles];
+    out->n = pos_offset [ntiles];
+
+    out->face_neighbors = malloc(MAX(2*out->m, 1) * sizeof *out->face_neighbors);
+    out->face_ptr       = malloc(   (out->m + 1)  * sizeof *out->face_ptr);
+    out->face_tag       = malloc(MAX(1*out->m, 1) * sizeof *out->face_tag);
+    out->face_nodes     = malloc(MAX(1*out->n, 1) * sizeof *out->face_nodes);
+
+    intersections = malloc(MAX(4*(node_offset[ntiles] - np), 1) * sizeof *intersections);
+
+    p = realloc(out->node_coordinates,
+                3 * ((size_t) node_offset[ntiles]) * sizeof *out->node_coordinates);
+
+    if ((out->face_neighbors == NULL) || (out->face_ptr == NULL) ||
+        (out->face_tag == NULL) || (out->face_nodes == NULL) ||
+        (intersections == NULL) || (p == NULL)) {
+        fprintf(stderr, "Could not allocate enough space in "
+                "process_faces()\n");
+        exit(1);
+    }
+
+    out->node_coordinates = p;
+    out->face_ptr[0]      = 0;
+
+    /* Pass 2: Fill */
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        size_t i;
+        int    *work     = malloc(wsize * sizeof *work);
+        int    *face_ptr = malloc((max_faces + 1) * sizeof *face_ptr);
+
+        if ((work == NULL) || (face_ptr == NULL)) {
+            fprintf(stderr, "Could not allocate work array in "
+                    "process_faces()\n");
+            exit(1);
+        }
+        for (i = 0; i < wsize; ++i) { work[i] = -1; }
+
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 1)
+#endif
+        for (t = 0; t < ntiles; ++t) {
+            fill_tile(&tiles[t], face_offset[t], pos_offset[t], node_offset[t],
+                      plist, work, face_ptr, intersections, out);
+        }
+
+        free(face_ptr);
+        free(work);
+    }
+
+    out->number_of_faces = face_offset[ntiles];
+    out->number_of_nodes = node_offset[ntiles];
+    out->number_of_cells = 0;
+    for (t = 0; t < ntiles; ++t) {
+        out->number_of_cells += tiles[t].number_of_cells;
+    }
+
+    free(node_offset);
+    free(pos_offset);
+    free(face_offset);
+    free(tiles);
+
+    return intersections;
+}
+
 /*-----------------------------------------------------------------
   On input,
   L points to 4 ints that indirectly refers to points in c.
@@ -443,17 +727,9 @@ compute_intersection_coordinates(int                   *intersections,
     int    k;
     double *pt;
     int    *itsct = intersections;
-    /* Make sure the space allocated for nodes match the number of
-     * node. */
-    void *p = realloc (out->node_coordinates, 3*n*sizeof(double));
-    if (p) {
-        out->node_coordinates = p;
-    }
-    else {
-        fprintf(stderr, "Could not allocate extra space for intersections\n");
-    }
 
-    /* Append intersections */
+    /* Append intersections.  Space for these was allocated in
+     * process_faces(). */
     pt    = out->node_coordinates + 3*np;
 
     for (k=np; k<n; ++k){
@@ -523,6 +799,63 @@ copy_and_permute_zcorn(int nx, int ny, int nz, const double *in,
     return out;
 }
 
+/* ------------------------------------------------------------------ */
+static int
+transpose_in_place(double *a, size_t rows, size_t cols)
+/* ------------------------------------------------------------------ */
+{
+    /* Transpose the row-major rows-by-cols matrix a in place by
+     * following the cycles of the permutation p -> p*rows mod (n-1).
+     * The only extra storage is one bit per element to mark the
+     * elements already moved.  Returns zero if that could not be
+     * allocated. */
+    const size_t   n    = rows * cols;
+    unsigned char *done;
+    size_t         start, p, q;
+    double         t, u;
+
+    if ((rows < 2) || (cols < 2)) {
+        return 1;
+    }
+
+    done = calloc((n + 7) / 8, sizeof *done);
+    if (done == NULL) {
+        return 0;
+    }
+
+    for (start = 1; start < n - 1; ++start) {
+        if (done[start / 8] & (1u << (start % 8))) {
+            continue;
+        }
+
+        p = start;
+        t = a[p];
+        do {
+            q = (p * rows) % (n - 1);
+            u = a[q];
+            a[q] = t;
+            t = u;
+            done[q / 8] |= (unsigned char) (1u << (q % 8));
+            p = q;
+        } while (p != start);
+    }
+
+    free(done);
+    return 1;
+}
+
+/* ------------------------------------------------------------------ */
+static void
+negate(double *a, size_t n)
+/* ------------------------------------------------------------------ */
+{
+    size_t i;
+
+    for (i = 0; i < n; ++i) {
+        a[i] = -a[i];
+    }
+}
+
 /* ------------------------------------------------------------------ */
 static int
 get_zcorn_sign(int nx, int ny, int nz, const int *actnum,
@@ -633,7 +966,7 @@ vert_size(const struct grdecl *in,
 
 /* ---------------------------------------------------------------------- */
 static int
-is_lefthanded(const struct grdecl *in, const double sign)
+find_handedness(const struct grdecl *in, const double sign)
 /* ---------------------------------------------------------------------- */
 {
     int           active, searching;
@@ -681,7 +1014,9 @@ is_lefthanded(const struct grdecl *in, const double sign)
         c += 1;
     } while (searching && (c < (nx * ny * nz)));
 
-    assert (! searching);       /* active && (fabs(dz) > 0) */
+    if (searching) {
+        return -1;              /* No active cell of non-zero height */
+    }
 
     /* Compute vector triple product to distinguish left-handed (<0)
      * from right-handed (>0) coordinate systems. */
@@ -692,6 +1027,18 @@ is_lefthanded(const struct grdecl *in, const double sign)
     return triple < 0.0;
 }
 
+/* ---------------------------------------------------------------------- */
+static int
+is_lefthanded(const struct grdecl *in, const double sign)
+/* ---------------------------------------------------------------------- */
+{
+    int left_handed = find_handedness(in, sign);
+
+    assert (left_handed >= 0);  /* active && (fabs(dz) > 0) */
+
+    return left_handed == 1;
+}
+
 /* ---------------------------------------------------------------------- */
 static void
 reverse_face_nodes(struct processed_grid *out)
@@ -722,11 +1069,30 @@ reverse_face_nodes(struct processed_grid *out)
 void process_grdecl(const struct grdecl   *in,
                     double                tolerance,
                     struct processed_grid *out)
+{
+    process_grdecl_threaded(in, tolerance, 1, out);
+}
+
+/*-----------------------------------------------------------------
+  Process the corner-point grid <in> with ZCORN sign and coordinate
+  system handedness established by the caller.  If pillar_ptr is
+  non-NULL it receives the start of each pillar's points, see
+  finduniquepoints().  If zcorn_work is non-NULL it is the array
+  in->zcorn refers to, and is reordered in place rather than copied
+  and restored before returning.  */
+static void
+process_block(const struct grdecl   *in,
+              double                tolerance,
+              int                   sign,
+              int                   left_handed,
+              int                   num_threads,
+              int                   *pillar_ptr,
+              double                *zcorn_work,
+              struct processed_grid *out)
 {
     struct grdecl g;
 
     size_t i;
-    int    sign, error, left_handed;
     int    cellnum;
 
     int    *actnum, *iptr;
@@ -734,31 +1100,25 @@ void process_grdecl(const struct grdecl   *in,
 
     double *zcorn;
 
-    const size_t BIGNUM = 64;
     const int    nx = in->dims[0];
     const int    ny = in->dims[1];
     const int    nz = in->dims[2];
     const size_t nc = ((size_t) nx) * ((size_t) ny) * ((size_t) nz);
 
     /* internal work arrays */
-    int    *work;
     int    *plist;
     int    *intersections;
 
     /* -----------------------------------------------------------------*/
-    /* Initialize output structure:
-       1) allocate space for grid topology (which may need to be
-          increased)
-       2) set Cartesian imensions
-    */
-    out->m                = (int) (BIGNUM / 3);
-    out->n                = (int) BIGNUM;
+    /* Initialize output structure.  Space for the grid topology is
+       allocated once the exact sizes are known, see process_faces(). */
+    out->m                = 0;
+    out->n                = 0;
 
-    out->face_neighbors   = malloc( BIGNUM      * sizeof *out->face_neighbors);
-    out->face_nodes       = malloc( out->n      * sizeof *out->face_nodes);
-    out->face_ptr         = malloc((out->m + 1) * sizeof *out->face_ptr);
-    out->face_tag         = malloc( out->m      * sizeof *out->face_tag);
-    out->face_ptr[0]      = 0;
+    out->face_neighbors   = NULL;
+    out->face_nodes       = NULL;
+    out->face_ptr         = NULL;
+    out->face_tag         = NULL;
 
     out->dimensions[0]    = in->dims[0];
     out->dimensions[1]    = in->dims[1];
@@ -788,9 +1148,22 @@ void process_grdecl(const struct grdecl   *in,
     actnum    = malloc (nc *     sizeof *actnum);
     g.actnum  = copy_and_permute_actnum(nx, ny, nz, in->actnum, actnum);
 
-    zcorn     = malloc (nc * 8 * sizeof *zcorn);
-    sign      = get_zcorn_sign(nx, ny, nz, in->actnum, in->zcorn, &error);
-    g.zcorn   = copy_and_permute_zcorn(nx, ny, nz, in->zcorn, sign, zcorn);
+    if (zcorn_work != NULL) {
+        assert (zcorn_work == in->zcorn);
+        if (sign == -1) {
+            negate(zcorn_work, 8 * nc);
+        }
+        if (!transpose_in_place(zcorn_work, 2*((size_t) nz), 4*((size_t) nx)*ny)) {
+            fprintf(stderr, "Could not allocate work array in process_grdecl_inplace()\n");
+            exit(1);
+        }
+        zcorn = NULL;
+        g.zcorn = zcorn_work;
+    }
+    else {
+        zcorn     = malloc (nc * 8 * sizeof *zcorn);
+        g.zcorn   = copy_and_permute_zcorn(nx, ny, nz, in->zcorn, sign, zcorn);
+    }
 
     g.coord   = in->coord;
 
@@ -798,13 +1171,22 @@ void process_grdecl(const struct grdecl   *in,
      * padding */
     plist = malloc(8 * (nc + ((size_t)nx)*((size_t)ny)) * sizeof *plist);
 
-    finduniquepoints(&g, plist, tolerance, out);
+    finduniquepoints(&g, plist, tolerance, num_threads, pillar_ptr, out);
+
+    if (zcorn_work != NULL) {
+        /* Back to the input ordering. */
+        if (!transpose_in_place(zcorn_work, 4*((size_t) nx)*ny, 2*((size_t) nz))) {
+            fprintf(stderr, "Could not allocate work array in process_grdecl_inplace()\n");
+            exit(1);
+        }
+        if (sign == -1) {
+            negate(zcorn_work, 8 * nc);
+        }
+    }
 
     free (zcorn);
     free (actnum);
 
-    /* Determine if coordinate system is left handed or not. */
-    left_handed = is_lefthanded(in, sign);
     if (left_handed) {
         /* Reflect Y coordinates about XZ plane to create right-handed
          * coordinate system whilst processing intersections. */
@@ -816,19 +1198,9 @@ void process_grdecl(const struct grdecl   *in,
     /* -----------------------------------------------------------------*/
     /* Find face topology and face-to-cell connections */
 
-    /* internal */
-    work = malloc(2 * ((size_t) (2*nz + 2)) * sizeof *work);
-    for(i = 0; i < ((size_t)4) * (nz + 1); ++i) { work[i] = -1; }
-
-    /* internal array to store intersections */
-    intersections = malloc(BIGNUM* sizeof(*intersections));
-
-    process_vertical_faces   (0, &intersections, plist, work, out);
-    process_vertical_faces   (1, &intersections, plist, work, out);
-    process_horizontal_faces (   &intersections, plist,       out);
+    intersections = process_faces(num_threads, plist, out);
 
     free (plist);
-    free (work);
 
     /* -----------------------------------------------------------------*/
     /* (re)allocate space for and compute coordinates of nodes that
@@ -890,6 +1262,888 @@ void process_grdecl(const struct grdecl   *in,
     }
 }
 
+/* ------------------------------------------------------------------ */
+static int
+resolve_num_threads(int num_threads)
+/* ------------------------------------------------------------------ */
+{
+#if defined(_OPENMP)
+    if (num_threads <= 0) {
+        num_threads = omp_get_max_threads();
+    }
+#else
+    num_threads = 1;
+#endif
+
+    return num_threads;
+}
+
+/*-------------------------------------------------------*/
+void process_grdecl_threaded(const struct grdecl   *in,
+                             double                tolerance,
+                             int                   num_threads,
+                             struct processed_grid *out)
+{
+    int sign, error, left_handed;
+
+    sign        = get_zcorn_sign(in->dims[0], in->dims[1], in->dims[2],
+                                 in->actnum, in->zcorn, &error);
+
+    /* Determine if coordinate system is left handed or not. */
+    left_handed = is_lefthanded(in, sign);
+
+    process_block(in, tolerance, sign, left_handed,
+                  resolve_num_threads(num_threads), NULL, NULL, out);
+}
+
+/*-------------------------------------------------------*/
+int process_grdecl_inplace(const struct grdecl   *in,
+                           double                *zcorn,
+                           double                tolerance,
+                           int                   num_threads,
+                           struct processed_grid *out)
+{
+    int sign, error, left_handed;
+
+    /* The writable array must be the one processed. */
+    if (zcorn != in->zcorn) {
+        fprintf(stderr, "ZCORN work array does not alias the grid's ZCORN "
+                "in process_grdecl_inplace()\n");
+        return 0;
+    }
+
+    sign        = get_zcorn_sign(in->dims[0], in->dims[1], in->dims[2],
+                                 in->actnum, in->zcorn, &error);
+
+    /* Determine if coordinate system is left handed or not. */
+    left_handed = is_lefthanded(in, sign);
+
+    process_block(in, tolerance, sign, left_handed,
+                  resolve_num_threads(num_threads), NULL, zcorn, out);
+
+    return 1;
+}
+
+/*-----------------------------------------------------------------
+  Streaming interface
+*/
+
+/*-----------------------------------------------------------------
+  Copy the corner-point data of the cell columns i0 <= i < i1, j0 <=
+  j < j1 of <in> into the buffers coord, zcorn and actnum and define
+  <sub> as the corresponding (i1-i0)-by-(j1-j0)-by-nz grid.  The coord
+  buffer may be NULL if the columns span all of <in>'s rows of cells,
+  in which case <sub> refers to <in>'s pillars.  */
+static void
+extract_box(const struct grdecl *in, int i0, int i1, int j0, int j1,
+            double *coord, double *zcorn, int *actnum, struct grdecl *sub)
+{
+    int    j, k;
+    size_t nx = in->dims[0];
+    size_t ny = in->dims[1];
+    size_t nz = in->dims[2];
+    size_t ni = i1 - i0;
+    size_t nj = j1 - j0;
+
+    for (k = 0; k < 2*((int) nz); ++k) {
+        for (j = 2*j0; j < 2*j1; ++j) {
+            memcpy(zcorn     + 2*ni*((j - 2*j0) + 2*nj*k),
+                   in->zcorn + 2*i0 + 2*nx*(j + 2*ny*k),
+                   2*ni * sizeof *zcorn);
+        }
+    }
+
+    if (in->actnum != NULL) {
+        for (k = 0; k < (int) nz; ++k) {
+            for (j = j0; j < j1; ++j) {
+                memcpy(actnum     + ni*((j - j0) + nj*k),
+                       in->actnum + i0 + nx*(j + ny*k),
+                       ni * sizeof *actnum);
+            }
+        }
+    }
+
+    if (coord != NULL) {
+        for (j = j0; j <= j1; ++j) {
+            memcpy(coord     + 6*(ni + 1)*(j - j0),
+                   in->coord + 6*(i0 + (nx + 1)*j),
+                   6*(ni + 1) * sizeof *coord);
+        }
+        sub->coord = coord;
+    }
+    else {
+        assert ((i0 == 0) && (i1 == (int) nx));
+        sub->coord = in->coord + 6*(nx + 1)*j0;
+    }
+
+    sub->dims[0] = i1 - i0;
+    sub->dims[1] = j1 - j0;
+    sub->dims[2] = in->dims[2];
+    sub->zcorn   = zcorn;
+    sub->actnum  = (in->actnum != NULL) ? actnum : NULL;
+    sub->mapaxes = in->mapaxes;
+}
+
+/*-----------------------------------------------------------------
+  Copy the corner-point data of cell rows j0 <= j < j1 of <in> into
+  the buffers zcorn and actnum and define <sub> as the corresponding
+  nx-by-(j1-j0)-by-nz grid. */
+static void
+extract_rows(const struct grdecl *in, int j0, int j1,
+             double *zcorn, int *actnum, struct grdecl *sub)
+{
+    extract_box(in, 0, in->dims[0], j0, j1, NULL, zcorn, actnum, sub);
+}
+
+/*-----------------------------------------------------------------
+  Local cell row of a cell in the processed block <blk>, or -1 if the
+  cell index c is -1.  */
+static int
+cell_row(const struct processed_grid *blk, int c)
+{
+    if (c == -1) {
+        return -1;
+    }
+
+    c = blk->local_cell_index[c];
+
+    return (c / blk->dimensions[0]) % blk->dimensions[1];
+}
+
+/*-----------------------------------------------------------------
+  Global Cartesian index of the cell with local index c in the
+  processed block <blk> which starts at cell row h0 of a grid with ny
+  cell rows.  */
+static int
+global_cell(const struct processed_grid *blk, int c, int h0, int ny)
+{
+    int i, j, k;
+
+    c = blk->local_cell_index[c];
+
+    i = c % blk->dimensions[0];  c /= blk->dimensions[0];
+    j = c % blk->dimensions[1];
+    k = c / blk->dimensions[1];
+
+    return i + blk->dimensions[0]*((j + h0) + ny*k);
+}
+
+/*-----------------------------------------------------------------
+  Pass the part of the processed block <blk> owned by the cell rows
+  jl0 <= j < jl1 of the block to the sink.  The block starts at global
+  cell row h0 of a grid with ny cell rows.  The slab owns its cell rows' I- and K-faces, the
+  J-faces on pillar rows jl0 <= j < jl1 (including pillar row jl1 if
+  last is set) and the nodes on these pillar rows.
+
+  Nodes are numbered globally in order of emission: The slab's pillar
+  nodes in pillar order followed by the fault intersections on its
+  faces.  The nodes on pillar row jl1 are emitted by the next slab, so
+  their global numbers follow those of this slab's nodes.  They are
+  passed as halo nodes after the slab's own nodes.  */
+static void
+emit_slab(const struct processed_grid *blk, const int *pillar_ptr,
+          int jl0, int jl1, int h0, int ny, int last,
+          int first_node, int first_face,
+          processed_grid_sink sink, void *ctx,
+          int *num_nodes, int *num_faces)
+{
+    int  f, i, k, n, row, own, nf, nn, nint, npn, nhalo;
+    int  stride   = blk->dimensions[0] + 1;
+    int  np       = blk->number_of_nodes_on_pillars;
+    int  pbegin   = pillar_ptr[jl0 * stride];
+    int  pend     = pillar_ptr[(last ? jl1 + 1 : jl1) * stride];
+    int  *node_map, *face_ptr, *face_nodes, *neighbors, *cells;
+    enum face_tag *tag;
+    double *coords;
+    const int *n2;
+
+    struct processed_slab slab;
+
+    node_map   = malloc(MAX(blk->number_of_nodes, 1) * sizeof *node_map);
+    face_ptr   = malloc((blk->number_of_faces + 1) * sizeof *face_ptr);
+    face_nodes = malloc(MAX(blk->face_ptr[blk->number_of_faces], 1) * sizeof *face_nodes);
+    neighbors  = malloc(MAX(2*blk->number_of_faces, 1) * sizeof *neighbors);
+    tag        = malloc(MAX(blk->number_of_faces, 1) * sizeof *tag);
+    cells      = malloc(MAX(blk->number_of_cells, 1) * sizeof *cells);
+    coords     = malloc(3 * ((size_t) MAX(blk->number_of_nodes, 1)) * sizeof *coords);
+
+    if ((node_map == NULL) || (face_ptr == NULL) || (face_nodes == NULL) ||
+        (neighbors == NULL) || (tag == NULL) || (cells == NULL) ||
+        (coords == NULL)) {
+        fprintf(stderr, "Could not allocate slab in "
+                "process_grdecl_streaming()\n");
+        exit(1);
+    }
+
+    for (n = 0; n < blk->number_of_nodes; ++n) { node_map[n] = -1; }
+
+    /* Select owned faces and mark the fault intersections on them. */
+    nf = 0;  face_ptr[0] = 0;
+    for (f = 0; f < blk->number_of_faces; ++f) {
+        n2 = blk->face_neighbors + 2*f;
+
+        if (blk->face_tag[f] == J_FACE) {
+            row = (n2[1] != -1) ? cell_row(blk, n2[1]) : cell_row(blk, n2[0]) + 1;
+            own = (jl0 <= row) && ((row < jl1) || (last && (row == jl1)));
+        }
+        else {
+            row = (n2[0] != -1) ? cell_row(blk, n2[0]) : cell_row(blk, n2[1]);
+            own = (jl0 <= row) && (row < jl1);
+        }
+
+        if (own) {
+            for (k = blk->face_ptr[f]; k < blk->face_ptr[f + 1]; ++k) {
+                face_nodes[face_ptr[nf] + (k - blk->face_ptr[f])] = blk->face_nodes[k];
+                if (blk->face_nodes[k] >= np) {
+                    node_map[blk->face_nodes[k]] = 0;
+                }
+            }
+
+            for (i = 0; i < 2; ++i) {
+                neighbors[2*nf + i] = (n2[i] == -1) ? -1 :
+                    global_cell(blk, n2[i], h0, ny);
+            }
+
+            tag[nf]          = blk->face_tag[f];
+            face_ptr[nf + 1] = face_ptr[nf] + (blk->face_ptr[f + 1] - blk->face_ptr[f]);
+            nf += 1;
+        }
+    }
+
+    /* Global node numbers and coordinates of owned nodes. */
+    npn = pend - pbegin;
+    for (n = pbegin; n < pend; ++n) {
+        node_map[n] = first_node + (n - pbegin);
+        memcpy(coords + 3*(n - pbegin), blk->node_coordinates + 3*n,
+               3 * sizeof *coords);
+    }
+
+    nint = 0;
+    for (n = np; n < blk->number_of_nodes; ++n) {
+        if (node_map[n] == 0) {
+            node_map[n] = first_node + npn + nint;
+            memcpy(coords + 3*(npn + nint), blk->node_coordinates + 3*n,
+                   3 * sizeof *coords);
+            nint += 1;
+        }
+    }
+
+    nhalo = 0;
+    if (! last) {
+        for (n = pend; n < pillar_ptr[(jl1 + 1) * stride]; ++n, ++nhalo) {
+            node_map[n] = first_node + npn + nint + nhalo;
+            memcpy(coords + 3*(npn + nint + nhalo), blk->node_coordinates + 3*n,
+                   3 * sizeof *coords);
+        }
+    }
+
+    for (k = 0; k < face_ptr[nf]; ++k) {
+        assert (node_map[face_nodes[k]] >= 0);
+        face_nodes[k] = node_map[face_nodes[k]];
+    }
+
+    /* Owned active cells */
+    nn = 0;
+    for (i = 0; i < blk->number_of_cells; ++i) {
+        row = cell_row(blk, i);
+        if ((jl0 <= row) && (row < jl1)) {
+            cells[nn++] = global_cell(blk, i, h0, ny);
+        }
+    }
+
+    slab.first_face       = first_face;
+    slab.number_of_faces  = nf;
+    slab.face_ptr         = face_ptr;
+    slab.face_nodes       = face_nodes;
+    slab.face_neighbors   = neighbors;
+    slab.face_tag         = tag;
+    slab.first_node       = first_node;
+    slab.number_of_nodes  = npn + nint;
+    slab.number_of_halo_nodes = nhalo;
+    slab.node_coordinates = coords;
+    slab.number_of_cells  = nn;
+    slab.global_cell      = cells;
+
+    sink(ctx, &slab);
+
+    *num_nodes = npn + nint;
+    *num_faces = nf;
+
+    free(coords);
+    free(cells);
+    free(tag);
+    free(neighbors);
+    free(face_nodes);
+    free(face_ptr);
+    free(node_map);
+}
+
+/*-------------------------------------------------------*/
+void process_grdecl_streaming(const struct grdecl *in,
+                              double              tolerance,
+                              int                 slab_rows,
+                              int                 num_threads,
+                              processed_grid_sink sink,
+                              void               *ctx)
+{
+    int    sign, error, left_handed;
+    int    j0, j1, h0, h1, nn, nf;
+    int    first_node, first_face;
+    int    *actnum, *pillar_ptr;
+    double *zcorn;
+    size_t maxrows;
+
+    struct grdecl         sub;
+    struct processed_grid blk;
+
+    const size_t nx = in->dims[0];
+    const size_t ny = in->dims[1];
+    const size_t nz = in->dims[2];
+
+    sign        = get_zcorn_sign(in->dims[0], in->dims[1], in->dims[2],
+                                 in->actnum, in->zcorn, &error);
+    left_handed = is_lefthanded(in, sign);
+    num_threads = resolve_num_threads(num_threads);
+
+    /* Each slab is processed along with one halo row of cells on
+     * either side such that the points on its boundary pillar rows are
+     * complete. */
+    slab_rows = MAX(slab_rows, 1);
+    maxrows   = MIN(((size_t) slab_rows) + 2, ny);
+
+    zcorn      = malloc(8 * nx * maxrows * nz * sizeof *zcorn);
+    actnum     = malloc(MAX(nx * maxrows * nz, 1) * sizeof *actnum);
+    pillar_ptr = malloc(((nx + 1)*(maxrows + 1) + 1) * sizeof *pillar_ptr);
+
+    if ((zcorn == NULL) || (actnum == NULL) || (pillar_ptr == NULL)) {
+        fprintf(stderr, "Could not allocate slab buffers in "
+                "process_grdecl_streaming()\n");
+        exit(1);
+    }
+
+    first_node = first_face = 0;
+    for (j0 = 0; j0 < (int) ny; j0 = j1) {
+        j1 = MIN(j0 + slab_rows, (int) ny);
+        h0 = MAX(j0 - 1, 0);
+        h1 = MIN(j1 + 1, (int) ny);
+
+        extract_rows(in, h0, h1, zcorn, actnum, &sub);
+        process_block(&sub, tolerance, sign, left_handed,
+                      num_threads, pillar_ptr, NULL, &blk);
+
+        emit_slab(&blk, pillar_ptr, j0 - h0, j1 - h0, h0, (int) ny, j1 == (int) ny,
+                  first_node, first_face, sink, ctx, &nn, &nf);
+
+        free_processed_grid(&blk);
+
+        first_node += nn;
+        first_face += nf;
+    }
+
+    free(pillar_ptr);
+    free(actnum);
+    free(zcorn);
+}
+
+/*-------------------------------------------------------*/
+int grdecl_zcorn_sign(const struct grdecl *g, int *error)
+{
+    return get_zcorn_sign(g->dims[0], g->dims[1], g->dims[2],
+                          g->actnum, g->zcorn, error);
+}
+
+/*-------------------------------------------------------*/
+int grdecl_is_lefthanded(const struct grdecl *g, int sign)
+{
+    return find_handedness(g, sign);
+}
+
+/*-------------------------------------------------------*/
+void process_grdecl_rows(const struct grdecl *g,
+                         int                 row_offset,
+                         int                 num_rows,
+                         int                 first_row,
+                         int                 last_row,
+                         int                 sign,
+                         int                 left_handed,
+                         double              tolerance,
+                         int                 num_threads,
+                         processed_grid_sink sink,
+                         void               *ctx)
+{
+    int    nn, nf;
+    int    *pillar_ptr;
+
+    struct processed_grid blk;
+
+    const int jl0 = first_row - row_offset;
+    const int jl1 = last_row  - row_offset;
+
+    /* The owned rows must be surrounded by their halo rows. */
+    assert ((0 <= jl0) && (jl0 < jl1) && (jl1 <= g->dims[1]));
+    assert ((first_row == 0)       || (jl0 >= 1));
+    assert ((last_row == num_rows) || (jl1 + 1 <= g->dims[1]));
+
+    pillar_ptr = malloc(((size_t) (g->dims[0] + 1)*(g->dims[1] + 1) + 1)
+                        * sizeof *pillar_ptr);
+    if (pillar_ptr == NULL) {
+        fprintf(stderr, "Could not allocate pillar pointers in "
+                "process_grdecl_rows()\n");
+        exit(1);
+    }
+
+    process_block(g, tolerance, sign, left_handed,
+                  resolve_num_threads(num_threads), pillar_ptr, NULL, &blk);
+
+    emit_slab(&blk, pillar_ptr, jl0, jl1, row_offset, num_rows,
+              last_row == num_rows, 0, 0, sink, ctx, &nn, &nf);
+
+    free_processed_grid(&blk);
+    free(pillar_ptr);
+}
+
+/*-----------------------------------------------------------------
+  Incremental update
+*/
+
+/*-----------------------------------------------------------------
+  Whether the face with tag <tag> and Cartesian neighbours c0 and c1
+  is rebuilt by process_grdecl_update().  These are the I- and
+  J-faces on the pillars of the changed columns <box> and all K-faces
+  of the reprocessed columns <cols>.  Both regions are given as {i0,
+  i1, j0, j1}, half-open in terms of columns of cells.  */
+static int
+face_is_rebuilt(enum face_tag tag, int c0, int c1, const int dims[3],
+                const int box[4], const int cols[4])
+{
+    int c, i, j;
+
+    c = (c0 != -1) ? c0 : c1;
+    if (c == -1) {
+        return 0;
+    }
+
+    i = c % dims[0];
+    j = (c / dims[0]) % dims[1];
+
+    switch (tag) {
+    case I_FACE:
+        /* Pillar line of the face, c0 is on its lower side */
+        i += (c0 != -1);
+        return (box[0] <= i) && (i <= box[1]) && (cols[2] <= j) && (j < cols[3]);
+
+    case J_FACE:
+        j += (c0 != -1);
+        return (cols[0] <= i) && (i < cols[1]) && (box[2] <= j) && (j <= box[3]);
+
+    default:
+        return (cols[0] <= i) && (i < cols[1]) && (cols[2] <= j) && (j < cols[3]);
+    }
+}
+
+/*-----------------------------------------------------------------
+  Allocate an array of n ints, at least one, or die.  */
+static int *
+alloc_ints(size_t n)
+{
+    int *a = malloc(MAX(n, 1) * sizeof *a);
+
+    if (a == NULL) {
+        fprintf(stderr, "Could not allocate memory in "
+                "process_grdecl_update()\n");
+        exit(1);
+    }
+
+    return a;
+}
+
+/*-----------------------------------------------------------------
+  Upper (cell is second neighbour) and lower (cell is first
+  neighbour) K-face of the cells of <g> that are mapped to a slot by
+  cell_slot.  Only faces with a non-zero keep flag are considered
+  unless keep is NULL.  */
+static void
+horizontal_faces(const struct processed_grid *g, const int *cell_slot,
+                 const int *keep, int *upper, int *lower)
+{
+    int f;
+    const int *n;
+
+    for (f = 0; f < g->number_of_faces; ++f) {
+        if ((g->face_tag[f] != K_FACE) || ((keep != NULL) && keep[f])) {
+            continue;
+        }
+
+        n = g->face_neighbors + 2*f;
+
+        if ((n[1] != -1) && (cell_slot[n[1]] != -1)) {
+            upper[cell_slot[n[1]]] = f;
+        }
+        if ((n[0] != -1) && (cell_slot[n[0]] != -1)) {
+            lower[cell_slot[n[0]]] = f;
+        }
+    }
+}
+
+/*-------------------------------------------------------*/
+void process_grdecl_update(const struct grdecl   *in,
+                           double                 tolerance,
+                           const int              lo[3],
+                           const int              hi[3],
+                           int                    num_threads,
+                           struct processed_grid *grid,
+                           int                  **face_origin,
+                           int                  **cell_origin)
+{
+    int    sign, error, left_handed;
+    int    box[4], cols[4];
+    int    b, c, f, g, i, j, k, n, o, q, t;
+    int    nc, nf, nfn, nn, npn, ni, nj, sn, on, fb, fo;
+    int    *actnum, *pillar_ptr;
+    int    *old2blk, *old_cell, *new_cell, *origin;
+    int    *keep_old, *keep_blk, *old_node, *blk_node, *blk_to_old;
+    int    *upper, *lower;
+    int    *face_src;
+    double *coord, *zcorn;
+    const int *src_nbr;
+
+    struct grdecl         sub;
+    struct processed_grid blk, res;
+
+    const int nx  = in->dims[0];
+    const int ny  = in->dims[1];
+    const int nz  = in->dims[2];
+    const int nco = grid->number_of_cells;
+    const int nfo = grid->number_of_faces;
+
+    assert ((grid->dimensions[0] == nx) && (grid->dimensions[1] == ny) &&
+            (grid->dimensions[2] == nz));
+
+    /* Changed columns and the columns that must be reprocessed along
+     * with them, one column on either side such that the points on
+     * the boundary pillars of the changed columns are complete. */
+    box[0] = MAX(lo[0], 0);  box[1] = MIN(hi[0], nx);
+    box[2] = MAX(lo[1], 0);  box[3] = MIN(hi[1], ny);
+
+    if ((box[0] >= box[1]) || (box[2] >= box[3]) ||
+        (MAX(lo[2], 0) >= MIN(hi[2], nz))) {
+        /* Nothing changed */
+        if (face_origin != NULL) {
+            *face_origin = alloc_ints(nfo);
+            for (f = 0; f < nfo; ++f) { (*face_origin)[f] = f; }
+        }
+        if (cell_origin != NULL) {
+            *cell_origin = alloc_ints(nco);
+            for (c = 0; c < nco; ++c) { (*cell_origin)[c] = c; }
+        }
+        return;
+    }
+
+    cols[0] = MAX(box[0] - 1, 0);  cols[1] = MIN(box[1] + 1, nx);
+    cols[2] = MAX(box[2] - 1, 0);  cols[3] = MIN(box[3] + 1, ny);
+
+    ni = cols[1] - cols[0];
+    nj = cols[3] - cols[2];
+
+    /* -----------------------------------------------------------------*/
+    /* Process the affected columns as a grid of their own, using the
+     * ZCORN sign and handedness of the whole grid. */
+    sign        = get_zcorn_sign(nx, ny, nz, in->actnum, in->zcorn, &error);
+    left_handed = is_lefthanded(in, sign);
+
+    coord      = malloc(6 * ((size_t) (ni + 1)) * (nj + 1) * sizeof *coord);
+    zcorn      = malloc(8 * ((size_t) ni) * nj * nz * sizeof *zcorn);
+    actnum     = alloc_ints(((size_t) ni) * nj * nz);
+    pillar_ptr = alloc_ints(((size_t) (ni + 1)) * (nj + 1) + 1);
+
+    if ((coord == NULL) || (zcorn == NULL)) {
+        fprintf(stderr, "Could not allocate memory in "
+                "process_grdecl_update()\n");
+        exit(1);
+    }
+
+    extract_box(in, cols[0], cols[1], cols[2], cols[3],
+                coord, zcorn, actnum, &sub);
+    process_block(&sub, tolerance, sign, left_handed,
+                  resolve_num_threads(num_threads), pillar_ptr, NULL, &blk);
+
+    free(actnum);
+    free(zcorn);
+    free(coord);
+
+    /* Global Cartesian indices of the reprocessed cells */
+    for (b = 0; b < blk.number_of_cells; ++b) {
+        c = blk.local_cell_index[b];
+        i = c % ni + cols[0];  c /= ni;
+        j = c % nj + cols[2];
+        k = c / nj;
+        blk.local_cell_index[b] = i + nx*(j + ny*k);
+    }
+
+    /* -----------------------------------------------------------------*/
+    /* Merge the cells outside of the reprocessed columns with the
+     * reprocessed ones, maintaining increasing Cartesian indices. */
+    old_cell = alloc_ints(nco);             /* new index of old cells */
+    new_cell = alloc_ints(blk.number_of_cells);
+    old2blk  = alloc_ints(nco);
+    origin   = alloc_ints(((size_t) nco) + blk.number_of_cells);
+
+    res.local_cell_index = alloc_ints(((size_t) nco) + blk.number_of_cells);
+
+    nc = o = b = 0;
+    while ((o < nco) || (b < blk.number_of_cells)) {
+        g = (o < nco)                  ? grid->local_cell_index[o] : INT_MAX;
+        c = (b < blk.number_of_cells)  ? blk.local_cell_index[b]   : INT_MAX;
+
+        if (g < c) {
+            i = g % nx;
+            j = (g / nx) % ny;
+            old2blk[o] = -1;
+            if ((cols[0] <= i) && (i < cols[1]) && (cols[2] <= j) && (j < cols[3])) {
+                old_cell[o] = -1;  /* Deactivated */
+            }
+            else {
+                old_cell[o] = nc;
+                origin[nc]  = o;
+                res.local_cell_index[nc++] = g;
+            }
+            ++o;
+        }
+        else {
+            if (g == c) {
+                /* Still active, unchanged faces may refer to it */
+                old_cell[o] = nc;
+                old2blk[o]  = b;
+                ++o;
+            }
+            new_cell[b] = nc;
+            origin[nc]  = -1;
+            res.local_cell_index[nc++] = c;
+            ++b;
+        }
+    }
+
+    /* -----------------------------------------------------------------*/
+    /* Select the faces to keep from either grid. */
+    keep_old = alloc_ints(nfo);
+    keep_blk = alloc_ints(blk.number_of_faces);
+
+    for (f = 0; f < nfo; ++f) {
+        src_nbr = grid->face_neighbors + 2*f;
+        keep_old[f] = ! face_is_rebuilt(grid->face_tag[f],
+                                        (src_nbr[0] == -1) ? -1 : grid->local_cell_index[src_nbr[0]],
+                                        (src_nbr[1] == -1) ? -1 : grid->local_cell_index[src_nbr[1]],
+                                        in->dims, box, cols);
+    }
+    for (f = 0; f < blk.number_of_faces; ++f) {
+        src_nbr = blk.face_neighbors + 2*f;
+        keep_blk[f] = face_is_rebuilt(blk.face_tag[f],
+                                      (src_nbr[0] == -1) ? -1 : blk.local_cell_index[src_nbr[0]],
+                                      (src_nbr[1] == -1) ? -1 : blk.local_cell_index[src_nbr[1]],
+                                      in->dims, box, cols);
+    }
+
+    /* -----------------------------------------------------------------*/
+    /* Identify the reprocessed nodes on the pillars outside of the
+     * changed columns with the existing ones.  These are corners of
+     * unchanged cells, found at the same positions of the cells'
+     * K-faces in either grid. */
+    blk_to_old = alloc_ints(blk.number_of_nodes);
+    for (n = 0; n < blk.number_of_nodes; ++n) { blk_to_old[n] = -1; }
+
+    upper    = alloc_ints(4 * ((size_t) blk.number_of_cells));
+    face_src = alloc_ints(blk.number_of_cells);       /* Identity */
+    lower = upper + 2*blk.number_of_cells;
+    for (b = 0; b < 4*blk.number_of_cells; ++b) { upper[b] = -1; }
+
+    for (b = 0; b < blk.number_of_cells; ++b) { face_src[b] = b; }
+    horizontal_faces(&blk, face_src, NULL,
+                     upper, lower);
+    horizontal_faces(grid, old2blk, keep_old,
+                     upper + blk.number_of_cells, lower + blk.number_of_cells);
+
+    for (t = 0, n = 0; t < (ni + 1)*(nj + 1); ++t) {
+        i = t % (ni + 1) + cols[0];
+        j = t / (ni + 1) + cols[2];
+        for (; n < pillar_ptr[t + 1]; ++n) {
+            /* Mark nodes on the pillars of the changed columns */
+            blk_to_old[n] = ((box[0] <= i) && (i <= box[1]) &&
+                             (box[2] <= j) && (j <= box[3])) ? -2 : -1;
+        }
+    }
+
+    for (o = 0; o < nco; ++o) {
+        if ((b = old2blk[o]) == -1) {
+            continue;
+        }
+        for (q = 0; q < 8; ++q) {
+            fb = (q < 4) ? upper[b] : lower[b];
+            fo = (q < 4) ? upper[b + blk.number_of_cells] : lower[b + blk.number_of_cells];
+            if ((fb == -1) || (fo == -1)) {
+                continue;
+            }
+            assert ((blk.face_ptr[fb + 1] - blk.face_ptr[fb] == 4) &&
+                    (grid->face_ptr[fo + 1] - grid->face_ptr[fo] == 4));
+
+            sn = blk.face_nodes[blk.face_ptr[fb] + q % 4];
+            on = grid->face_nodes[grid->face_ptr[fo] + q % 4];
+            if ((sn < blk.number_of_nodes_on_pillars) && (blk_to_old[sn] == -1)) {
+                blk_to_old[sn] = on;
+            }
+        }
+    }
+
+    free(face_src);
+    free(upper);
+    free(pillar_ptr);
+
+    /* -----------------------------------------------------------------*/
+    /* Number the nodes referenced by the kept faces, pillar nodes
+     * first, those of either grid in their original order. */
+    old_node = alloc_ints(grid->number_of_nodes);
+    blk_node = alloc_ints(blk.number_of_nodes);
+    for (n = 0; n < grid->number_of_nodes; ++n) { old_node[n] = -1; }
+    for (n = 0; n < blk.number_of_nodes;   ++n) { blk_node[n] = -1; }
+
+    nf = nfn = 0;
+    for (f = 0; f < nfo; ++f) {
+        if (keep_old[f]) {
+            for (k = grid->face_ptr[f]; k < grid->face_ptr[f + 1]; ++k) {
+                old_node[grid->face_nodes[k]] = 0;
+            }
+            nf  += 1;
+            nfn += grid->face_ptr[f + 1] - grid->face_ptr[f];
+        }
+    }
+    for (f = 0; f < blk.number_of_faces; ++f) {
+        if (keep_blk[f]) {
+            for (k = blk.face_ptr[f]; k < blk.face_ptr[f + 1]; ++k) {
+                n = blk.face_nodes[k];
+                if (blk_to_old[n] >= 0) {
+                    old_node[blk_to_old[n]] = 0;
+                }
+                else {
+                    blk_node[n] = 0;
+                }
+            }
+            nf  += 1;
+            nfn += blk.face_ptr[f + 1] - blk.face_ptr[f];
+        }
+    }
+
+    nn = 0;
+    for (n = 0; n < grid->number_of_nodes_on_pillars; ++n) {
+        if (old_node[n] == 0) { old_node[n] = nn++; }
+    }
+    for (n = 0; n < blk.number_of_nodes_on_pillars; ++n) {
+        if (blk_node[n] == 0) { blk_node[n] = nn++; }
+    }
+    npn = nn;
+    for (n = grid->number_of_nodes_on_pillars; n < grid->number_of_nodes; ++n) {
+        if (old_node[n] == 0) { old_node[n] = nn++; }
+    }
+    for (n = blk.number_of_nodes_on_pillars; n < blk.number_of_nodes; ++n) {
+        if (blk_node[n] == 0) { blk_node[n] = nn++; }
+    }
+    for (n = 0; n < blk.number_of_nodes; ++n) {
+        if (blk_to_old[n] >= 0) { blk_node[n] = old_node[blk_to_old[n]]; }
+    }
+
+    res.node_coordinates = malloc(3 * ((size_t) MAX(nn, 1)) * sizeof *res.node_coordinates);
+    if (res.node_coordinates == NULL) {
+        fprintf(stderr, "Could not allocate memory in "
+                "process_grdecl_update()\n");
+        exit(1);
+    }
+    for (n = 0; n < grid->number_of_nodes; ++n) {
+        if (old_node[n] >= 0) {
+            memcpy(res.node_coordinates + 3*old_node[n],
+                   grid->node_coordinates + 3*n, 3 * sizeof *res.node_coordinates);
+        }
+    }
+    for (n = 0; n < blk.number_of_nodes; ++n) {
+        if ((blk_node[n] >= 0) && (blk_to_old[n] < 0)) {
+            memcpy(res.node_coordinates + 3*blk_node[n],
+                   blk.node_coordinates + 3*n, 3 * sizeof *res.node_coordinates);
+        }
+    }
+
+    /* -----------------------------------------------------------------*/
+    /* Kept faces of either grid by tag, the existing ones first. */
+    res.face_ptr       = alloc_ints(((size_t) nf) + 1);
+    res.face_nodes     = alloc_ints(nfn);
+    res.face_neighbors = alloc_ints(2 * ((size_t) nf));
+    res.face_tag       = malloc(MAX(nf, 1) * sizeof *res.face_tag);
+    face_src           = alloc_ints(nf);
+
+    if (res.face_tag == NULL) {
+        fprintf(stderr, "Could not allocate memory in "
+                "process_grdecl_update()\n");
+        exit(1);
+    }
+
+    res.face_ptr[0] = 0;
+    nf = 0;
+    for (t = I_FACE; t <= K_FACE; ++t) {
+        for (f = 0; f < nfo; ++f) {
+            if (keep_old[f] && (grid->face_tag[f] == (enum face_tag) t)) {
+                for (k = grid->face_ptr[f]; k < grid->face_ptr[f + 1]; ++k) {
+                    res.face_nodes[res.face_ptr[nf] + (k - grid->face_ptr[f])] =
+                        old_node[grid->face_nodes[k]];
+                }
+                for (q = 0; q < 2; ++q) {
+                    c = grid->face_neighbors[2*f + q];
+                    res.face_neighbors[2*nf + q] = (c == -1) ? -1 : old_cell[c];
+                }
+                res.face_tag[nf]     = grid->face_tag[f];
+                res.face_ptr[nf + 1] = res.face_ptr[nf] + (grid->face_ptr[f + 1] - grid->face_ptr[f]);
+                face_src[nf++]       = f;
+            }
+        }
+        for (f = 0; f < blk.number_of_faces; ++f) {
+            if (keep_blk[f] && (blk.face_tag[f] == (enum face_tag) t)) {
+                for (k = blk.face_ptr[f]; k < blk.face_ptr[f + 1]; ++k) {
+                    res.face_nodes[res.face_ptr[nf] + (k - blk.face_ptr[f])] =
+                        blk_node[blk.face_nodes[k]];
+                }
+                for (q = 0; q < 2; ++q) {
+                    c = blk.face_neighbors[2*f + q];
+                    res.face_neighbors[2*nf + q] = (c == -1) ? -1 : new_cell[c];
+                }
+                res.face_tag[nf]     = blk.face_tag[f];
+                res.face_ptr[nf + 1] = res.face_ptr[nf] + (blk.face_ptr[f + 1] - blk.face_ptr[f]);
+                face_src[nf++]       = -1;
+            }
+        }
+    }
+
+    res.m = nf;
+    res.n = nfn;
+    res.dimensions[0] = nx;
+    res.dimensions[1] = ny;
+    res.dimensions[2] = nz;
+    res.number_of_faces = nf;
+    res.number_of_nodes = nn;
+    res.number_of_nodes_on_pillars = npn;
+    res.number_of_cells = nc;
+
+    free_processed_grid(&blk);
+    free_processed_grid(grid);
+    *grid = res;
+
+    if (face_origin != NULL) { *face_origin = face_src; } else { free(face_src); }
+    if (cell_origin != NULL) { *cell_origin = origin;   } else { free(origin);   }
+
+    free(blk_node);
+    free(old_node);
+    free(blk_to_old);
+    free(keep_blk);
+    free(keep_old);
+    free(old2blk);
+    free(new_cell);
+    free(old_cell);
+}
+
 /*-------------------------------------------------------*/
 void free_processed_grid(struct processed_grid *g)
 {
@@ -60,9 +60,9 @@ extern "C" {
      * a geological model in corner-point format.
      */
     struct processed_grid {
-        int m; /**< Upper bound on "number_of_faces".  For internal use in
+        int m; /**< Allocated size of "face_tag".  For internal use in
                     function process_grid()'s memory management. */
-        int n; /**< Upper bound on "number_of_nodes".  For internal use in
+        int n; /**< Allocated size of "face_nodes".  For internal use in
                     function process_grid()'s memory management. */
 
         int    dimensions[3];     /**< Cartesian box dimensions. */
@@ -113,6 +113,219 @@ extern "C" {
                         double                 tol,
                         struct processed_grid *out);
 
+    /**
+     * Multi-threaded version of process_grdecl().
+     *
+     * The pillar pairs are split into contiguous tiles whose faces are
+     * first counted and then established concurrently, directly at
+     * their serial position in the output.  The resulting grid is
+     * identical to that of
+     * process_grdecl().  Threading requires OpenMP support, otherwise
+     * this function falls back to the serial algorithm.
+     *
+     * @param[in]     g           Corner-point specification.
+     * @param[in]     tol         Absolute tolerance of node-coincidence.
+     * @param[in]     num_threads Number of threads.  Non-positive values
+     *                            select the OpenMP default, i.e., all
+     *                            available cores unless limited through
+     *                            OMP_NUM_THREADS.
+     * @param[in,out] out         Minimal grid representation.  See
+     *                            process_grdecl().
+     */
+    void process_grdecl_threaded(const struct grdecl   *g          ,
+                                 double                 tol        ,
+                                 int                    num_threads,
+                                 struct processed_grid *out        );
+
+    /**
+     * Version of process_grdecl_threaded() that works on the caller's
+     * ZCORN array instead of a private, reordered copy of it.
+     *
+     * For the duration of the call the array is reordered column by
+     * column in place, and it holds the original values again on
+     * return.  It must therefore be writable, and must not be accessed
+     * by others until the call returns.  The additional memory required
+     * is one bit per ZCORN value, rather than a full copy.
+     *
+     * @param[in]     g           Corner-point specification.
+     * @param[in,out] zcorn       The array g->zcorn refers to.
+     * @param[in]     tol         Absolute tolerance of node-coincidence.
+     * @param[in]     num_threads Number of threads, see
+     *                            process_grdecl_threaded().
+     * @param[in,out] out         Minimal grid representation.  See
+     *                            process_grdecl().
+     * @return One if successful, zero, with nothing processed, if
+     *         zcorn is not the array g->zcorn refers to.
+     */
+    int process_grdecl_inplace(const struct grdecl   *g          ,
+                                double                *zcorn      ,
+                                double                 tol        ,
+                                int                    num_threads,
+                                struct processed_grid *out        );
+
+    /**
+     * Part of a grid passed to the sink of process_grdecl_streaming().
+     *
+     * Faces and nodes are numbered globally in order of emission.  Cells
+     * are identified by their global Cartesian index.  All arrays are
+     * owned by process_grdecl_streaming() and valid only for the
+     * duration of the sink call.
+     */
+    struct processed_slab {
+        int    first_face;            /**< Global number of first face. */
+        int    number_of_faces;       /**< Number of faces in slab. */
+        const int *face_ptr;          /**< Start position for each face's
+                                           `face_nodes', starting at zero. */
+        const int *face_nodes;        /**< Global node numbers of each face,
+                                           stored sequentially. */
+        const int *face_neighbors;    /**< Global Cartesian cell indices.
+                                           Two elements per face, -1
+                                           outside the domain. */
+        const enum face_tag *face_tag;/**< Classification of faces. */
+
+        int    first_node;            /**< Global number of first node. */
+        int    number_of_nodes;       /**< Number of nodes in slab. */
+        int    number_of_halo_nodes;  /**< Number of nodes referenced by the
+                                           slab's faces but owned by the
+                                           next slab.  These follow the
+                                           slab's own nodes in numbering. */
+        const double *node_coordinates; /**< Vertex coordinates.  Three
+                                             doubles per vertex, own nodes
+                                             followed by halo nodes. */
+
+        int    number_of_cells;       /**< Number of active cells in slab. */
+        const int *global_cell;       /**< Global Cartesian indices of the
+                                           active cells, increasing. */
+    };
+
+    /**
+     * Callback receiving the slabs of process_grdecl_streaming().
+     */
+    typedef void (*processed_grid_sink)(void                        *ctx ,
+                                        const struct processed_slab *slab);
+
+    /**
+     * Bounded-memory version of process_grdecl().
+     *
+     * The grid is processed in slabs of slab_rows rows of cells along
+     * the J axis, each along with one halo row of cells on either side.
+     * The faces, nodes and active cells of each slab are passed to the
+     * sink in order of increasing J.  The additional memory required is
+     * proportional to the slab size rather than to the model size.
+     *
+     * Node and face numbering differ from those of process_grdecl() as
+     * the fault intersection nodes are interleaved with the pillar
+     * nodes, slab by slab.  Fault intersection nodes that are not
+     * referenced by any face are omitted.
+     *
+     * @param[in] g           Corner-point specification.
+     * @param[in] tol         Absolute tolerance of node-coincidence.
+     * @param[in] slab_rows   Number of cell rows per slab.
+     * @param[in] num_threads Number of threads used within each slab.
+     *                        See process_grdecl_threaded().
+     * @param[in] sink        Callback receiving the slabs.
+     * @param[in] ctx         User data passed to the sink.
+     */
+    void process_grdecl_streaming(const struct grdecl *g          ,
+                                  double               tol        ,
+                                  int                  slab_rows  ,
+                                  int                  num_threads,
+                                  processed_grid_sink  sink       ,
+                                  void                *ctx        );
+
+    /**
+     * Sign convention of the ZCORN values of a corner-point specification.
+     *
+     * @param[in]  g     Corner-point specification.
+     * @param[out] error Set to one if ZCORN is not monotone along the
+     *                   pillars for either sign, zero otherwise.
+     * @return One if ZCORN is nondecreasing along the pillars, minus one
+     *         otherwise.
+     */
+    int grdecl_zcorn_sign(const struct grdecl *g, int *error);
+
+    /**
+     * Handedness of the coordinate system of a corner-point
+     * specification.
+     *
+     * @param[in] g    Corner-point specification.
+     * @param[in] sign ZCORN sign, see grdecl_zcorn_sign().
+     * @return One if the coordinate system is left-handed, zero if it is
+     *         right-handed and minus one if g has no active cell of
+     *         non-zero height from which to tell.
+     */
+    int grdecl_is_lefthanded(const struct grdecl *g, int sign);
+
+    /**
+     * Process a block of rows of a larger corner-point grid.
+     *
+     * This is the building block of distributed preprocessing: The
+     * specification g holds the cell rows row_offset <= j < row_offset +
+     * g->dims[1] of a grid with num_rows rows along the J axis.  The
+     * rows first_row <= j < last_row are processed and passed to the
+     * sink as a single slab, see process_grdecl_streaming().  The
+     * remaining rows of g must comprise at least one halo row on either
+     * side of the processed rows, unless at the boundary of the grid.
+     *
+     * The slab's faces and nodes are numbered from zero.  Shifting the
+     * node numbers (including those of halo nodes) and the face numbers
+     * by the totals of all preceding blocks gives the global numbering
+     * of process_grdecl_streaming().  The ZCORN sign and handedness must
+     * be agreed upon by all blocks, see grdecl_zcorn_sign() and
+     * grdecl_is_lefthanded().
+     */
+    void process_grdecl_rows(const struct grdecl *g          ,
+                             int                  row_offset ,
+                             int                  num_rows   ,
+                             int                  first_row  ,
+                             int                  last_row   ,
+                             int                  sign       ,
+                             int                  left_handed,
+                             double               tol        ,
+                             int                  num_threads,
+                             processed_grid_sink  sink       ,
+                             void                *ctx        );
+
+    /**
+     * Update a processed grid after a change of the corner-point
+     * specification within a box of cells.
+     *
+     * The cells lo[d] <= i_d < hi[d] of g may have changed ZCORN and
+     * ACTNUM values, COORD and everything outside of the box must be
+     * unchanged from the specification that grid was processed from.
+     * Points are rediscovered along the pillars of the changed columns
+     * only, and the faces on those pillars are recomputed from the
+     * columns of cells adjacent to them.  All other faces and nodes are
+     * retained, so the update is local in the point and face discovery
+     * while the renumbering of the integer tables is linear in the size
+     * of the grid.  The faces are ordered by direction like those of
+     * process_grdecl(), but are otherwise not in the same order.
+     *
+     * @param[in]     g           Changed corner-point specification.
+     * @param[in]     tol         Absolute tolerance of node-coincidence.
+     * @param[in]     lo          First cell of the changed box.
+     * @param[in]     hi          One past the last cell of the changed box.
+     * @param[in]     num_threads Number of threads, see
+     *                            process_grdecl_threaded().
+     * @param[in,out] grid        Grid previously obtained from
+     *                            process_grdecl() or from this function.
+     * @param[out]    face_origin If non-NULL, receives a malloc()ed array of
+     *                            the previous index of every face of the
+     *                            updated grid, or -1 for recomputed faces.
+     * @param[out]    cell_origin If non-NULL, receives a malloc()ed array of
+     *                            the previous index of every cell of the
+     *                            updated grid, or -1 for cells in the
+     *                            reprocessed columns.
+     */
+    void process_grdecl_update(const struct grdecl   *g          ,
+                               double                 tol        ,
+                               const int              lo[3]      ,
+                               const int              hi[3]      ,
+                               int                    num_threads,
+                               struct processed_grid *grid       ,
+                               int                  **face_origin,
+                               int                  **cell_origin);
+
     /**
      * Release memory resources acquired in previous grid processing using
      * function process_grdecl().
@@ -25,6 +25,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 #include "preprocess.h"
 #include "uniquepoints.h"
 
@@ -32,22 +36,62 @@
 #define MAX(i,j) (((i) > (j)) ? (i) : (j))
 
 /*-----------------------------------------------------------------
-  Compare function passed to qsortx  */
-static int compare(const void *a, const void *b)
+  Merge the adjacent sorted runs a[0..m) and a[m..n) into b[0..n).  */
+static void merge_runs(const double *a, int m, int n, double *b)
 {
-    const double a0 = *(const double*) a;
-    const double b0 = *(const double*) b;
+    int i = 0, j = m, k = 0;
 
-    /*                { -1, a < b
-     * compare(a,b) = {  0, a = b
-     *                {  1, a > b */
-    return (a0 > b0) - (a0 < b0);
+    while ((i < m) && (j < n)) {
+        b[k++] = (a[j] < a[i]) ? a[j++] : a[i++];
+    }
+    while (i < m) { b[k++] = a[i++]; }
+    while (j < n) { b[k++] = a[j++]; }
 }
 
 /*-----------------------------------------------------------------
-  Creat sorted list of z-values in zcorn with actnum==1x */
+  Sort <n> doubles in <list> in increasing order using the scratch
+  array <tmp> of (at least) <n> elements.
+
+  Bottom-up natural merge sort.  The list of z-values along a pillar
+  is the concatenation of (up to) four columns of zcorn values which
+  are normally sorted already, so this typically completes in two
+  passes over the data.  */
+static void sort_zlist(double *list, int n, double *tmp)
+{
+    double *src = list, *dst = tmp, *swap;
+    int     i, m, e, nruns;
+
+    for (m = 1; (m < n) && !(list[m] < list[m-1]); ++m) {}
+    if (m >= n) {
+        return;                 /* Already sorted */
+    }
+
+    do {
+        nruns = 0;
+        for (i = 0; i < n; i = e) {
+            /* Find the run src[i..m) and the following run src[m..e). */
+            for (m = i + 1; (m < n) && !(src[m] < src[m-1]); ++m) {}
+            for (e = m + 1; (e < n) && !(src[e] < src[e-1]); ++e) {}
+            e = MIN(e, n);
+
+            merge_runs(src + i, m - i, e - i, dst + i);
+            ++nruns;
+        }
+
+        swap = src; src = dst; dst = swap;
+    } while (nruns > 1);
+
+    if (src != list) {
+        memcpy(list, src, n * sizeof *list);
+    }
+}
+
+/*-----------------------------------------------------------------
+  Creat sorted list of z-values in zcorn with actnum==1x.  The
+  scratch array tmp must hold n*m elements.  */
 static int createSortedList(double *list, int n, int m,
-                            const double *z[], const int *a[])
+                            const double *z[], const int *a[],
+                            double *tmp)
 {
     int i,j;
     double *ptr = list;
@@ -58,7 +102,7 @@ static int createSortedList(double *list, int n, int m,
         }
     }
 
-    qsort(list, ptr-list, sizeof(double), compare);
+    sort_zlist(list, ptr-list, tmp);
     return ptr-list;
 }
 
@@ -239,12 +283,21 @@ static void interpolate_pillar(const double *coord, double *pt)
 /*-----------------------------------------------------------------
   Assign point numbers p such that "zlist(p)==zcorn".  Assume that
   coordinate number is arranged in a sequence such that the natural
-  index is (k,i,j) */
+  index is (k,i,j)
+
+  The pillars are processed concurrently on <nthreads> threads.  The
+  unique z-values of each pillar are first stored at a fixed,
+  pessimistic offset in zlist.  A prefix sum of the per-pillar counts
+  then gives the point numbers in pillar order, so the numbering does
+  not depend on the number of threads.  If pillar_ptr is non-NULL, it
+  receives the (npillars+1) start positions of each pillar's points. */
 int finduniquepoints(const struct grdecl *g,
                      /* return values: */
                      int           *plist, /* list of point numbers on
                                             * each pillar*/
                      double tolerance,
+                     int    nthreads,
+                     int   *pillar_ptr,
                      struct processed_grid *out)
 
 {
@@ -252,101 +305,144 @@ int finduniquepoints(const struct grdecl *g,
     const int nx = out->dimensions[0];
     const int ny = out->dimensions[1];
     const int nz = out->dimensions[2];
-    const int nc = g->dims[0]*g->dims[1]*g->dims[2];
 
     /* zlist may need extra space temporarily due to simple boundary
      * treatement  */
-    int            npillarpoints = 8*(nx+1)*(ny+1)*nz;
-    int            npillars      = (nx+1)*(ny+1);
+    const size_t   maxlen        = 8*((size_t) nz);
+    const int      npillars      = (nx+1)*(ny+1);
+    const size_t   npillarpoints = maxlen*npillars;
 
     double *zlist = malloc(npillarpoints*sizeof *zlist);
     int     *zptr = malloc((npillars+1)*sizeof *zptr);
 
-    int     i,j,k;
+    int     pix;
+    int     ok = 1;
 
     int     d1[3];
-    int     len    = 0;
-    double  *zout  = zlist;
-    int     pos    = 0;
-    double *pt;
-    const double *z[4];
-    const int *a[4];
-    int *p;
-    int pix, cix;
-    int zix;
-
-    const double *coord = g->coord;
+
+#if !defined(_OPENMP)
+    (void) nthreads;
+#endif
+
+    if ((zlist == NULL) || (zptr == NULL)){
+        fprintf(stderr, "Could not allocate z-lists in finduniquepoints");
+        free(zptr);
+        free(zlist);
+        return 0;
+    }
 
     d1[0] = 2*g->dims[0];
     d1[1] = 2*g->dims[1];
     d1[2] = 2*g->dims[2];
 
-    out->node_coordinates = malloc (3*8*nc*sizeof(*out->node_coordinates));
-
-    zptr[pos++] = zout - zlist;
-
-    pt    = out->node_coordinates;
-
     /* Loop over pillars, find unique points on each pillar */
-    for (j=0; j < g->dims[1]+1; ++j){
-        for (i=0; i < g->dims[0]+1; ++i){
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        int     i, j, p, len;
+        const double *z[4];
+        const int *a[4];
+        double *tmp = malloc((maxlen + 1)*sizeof *tmp);
+
+        if (tmp == NULL){
+            fprintf(stderr, "Could not allocate work array in finduniquepoints");
+            exit(1);
+        }
+
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+        for (p = 0; p < npillars; ++p){
+            i = p % (g->dims[0]+1);
+            j = p / (g->dims[0]+1);
 
             /* Get positioned pointers for actnum and zcorn data */
             igetvectors(g->dims,   i,   j, g->actnum, a);
             dgetvectors(d1,      2*i, 2*j, g->zcorn,  z);
 
-            len = createSortedList(     zout, d1[2], 4, z, a);
-            len = uniquify        (len, zout, tolerance);
+            len = createSortedList(     zlist + maxlen*p, d1[2], 4, z, a, tmp);
+            len = uniquify        (len, zlist + maxlen*p, tolerance);
 
-            /* Assign unique points */
-            for (k=0; k<len; ++k){
-                pt[2] = zout[k];
-                interpolate_pillar(coord, pt);
-                pt += 3;
-            }
+            zptr[p+1] = len;
+        }
 
-            /* Increment pointer to sparse table of unique zcorn
-             * values */
-            zout        = zout + len;
-            zptr[pos++] = zout - zlist;
+        free(tmp);
+    }
+
+    /* Pointers to sparse table of unique zcorn values.  Move each
+     * pillar's values to its final position. */
+    zptr[0] = 0;
+    for (pix = 0; pix < npillars; ++pix){
+        memmove(zlist + zptr[pix], zlist + maxlen*pix,
+                zptr[pix+1] * sizeof *zlist);
+        zptr[pix+1] += zptr[pix];
+    }
+
+    out->number_of_nodes_on_pillars = zptr[npillars];
+    out->number_of_nodes            = zptr[npillars];
+
+    /* Assign unique points.  The number of points is known at this
+     * stage, so the coordinate array is allocated at its exact size. */
+    out->node_coordinates = malloc (3*((size_t) zptr[npillars])*sizeof(*out->node_coordinates));
+    if (out->node_coordinates == NULL){
+        fprintf(stderr, "Could not allocate node coordinates in finduniquepoints");
+        free(zptr);
+        free(zlist);
+        return 0;
+    }
 
-            coord += 6;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+    for (pix = 0; pix < npillars; ++pix){
+        int     k;
+        double *pt = out->node_coordinates + 3*((size_t) zptr[pix]);
+
+        for (k=zptr[pix]; k<zptr[pix+1]; ++k){
+            pt[2] = zlist[k];
+            interpolate_pillar(g->coord + 6*((size_t) pix), pt);
+            pt += 3;
         }
     }
-    out->number_of_nodes_on_pillars = zptr[pos-1];
-    out->number_of_nodes            = zptr[pos-1];
 
     /* Loop over all vertical sets of zcorn values, assign point
      * numbers */
-    p = plist;
-    for (j=0; j < 2*g->dims[1]; ++j){
-        for (i=0; i < 2*g->dims[0]; ++i){
-
-            /* pillar index */
-            pix = (i+1)/2 + (g->dims[0]+1)*((j+1)/2);
-
-            /* cell column position */
-            cix = g->dims[2]*((i/2) + (j/2)*g->dims[0]);
-
-            /* zcorn column position */
-            zix = 2*g->dims[2]*(i+2*g->dims[0]*j);
-
-            if (!assignPointNumbers(zptr[pix], zptr[pix+1], zlist,
-                                    2*g->dims[2],
-                                    g->zcorn  + zix, g->actnum + cix,
-                                    p, tolerance)){
-                fprintf(stderr, "Something went wrong in assignPointNumbers");
-                return 0;
-            }
-
-            p += 2 + 2*g->dims[2];
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) schedule(static) reduction(&&:ok)
+#endif
+    for (pix = 0; pix < 4*g->dims[0]*g->dims[1]; ++pix){
+        int i = pix % (2*g->dims[0]);
+        int j = pix / (2*g->dims[0]);
+        int pil, cix, zix;
+
+        /* pillar index */
+        pil = (i+1)/2 + (g->dims[0]+1)*((j+1)/2);
+
+        /* cell column position */
+        cix = g->dims[2]*((i/2) + (j/2)*g->dims[0]);
+
+        /* zcorn column position */
+        zix = 2*g->dims[2]*(i+2*g->dims[0]*j);
+
+        if (!assignPointNumbers(zptr[pil], zptr[pil+1], zlist,
+                                2*g->dims[2],
+                                g->zcorn  + zix, g->actnum + cix,
+                                plist + ((size_t) pix)*(2 + 2*g->dims[2]),
+                                tolerance)){
+            fprintf(stderr, "Something went wrong in assignPointNumbers");
+            ok = 0;
         }
     }
 
+    if (pillar_ptr != NULL){
+        memcpy(pillar_ptr, zptr, (npillars+1)*sizeof *pillar_ptr);
+    }
+
     free(zptr);
     free(zlist);
 
-    return 1;
+    return ok;
 }
 
 /* Local Variables:    */
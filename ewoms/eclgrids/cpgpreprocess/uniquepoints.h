@@ -22,6 +22,8 @@
 int finduniquepoints(const struct grdecl *g,  /* input */
                      int                 *p,  /* for each z0 in zcorn, z0 = z[p0] */
                      double               t,  /* tolerance*/
+                     int                  nthreads,
+                     int                 *pillar_ptr, /* may be NULL */
                      struct processed_grid *out);
 
 #endif /* EWOMS_UNIQUEPOINTS_HEADER */
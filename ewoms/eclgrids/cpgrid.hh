@@ -19,10 +19,13 @@
 #ifndef EWOMS_CPGRID_HEADER
 #define EWOMS_CPGRID_HEADER
 
+#include <algorithm>
+#include <stdexcept>
 #include <string>
 #include <map>
 #include <array>
 #include <unordered_set>
+#include <vector>
 #include <ewoms/eclio/errormacros.hh>
 
 // Warning suppression for Dune includes.
@@ -52,6 +55,8 @@
 
 #include <ewoms/eclgrids/utility/parserincludes.hh>
 
+#include <boost/range/iterator_range.hpp>
+
 #include <iostream>
 
 namespace Dune
@@ -261,6 +266,18 @@ namespace Dune
         /// \param remove_ij_boundary if true, will remove (i, j) boundaries. Used internally.
         void processEclipseFormat(const grdecl& input_data, double z_tolerance, bool remove_ij_boundary, bool turn_normals = false);
 
+        /// Update the grid after a change of the corner-point data within a box of cells.
+        /// The grid keeps its NNCs, z_tolerance and normal orientation.
+        /// \param input_data the changed data in grdecl format, the COORD and the data
+        ///        outside of the box must be those the grid was processed from, see
+        ///        zcornData() for grids read from an EclipseGrid with MINPV or PINCH.
+        /// \param box_begin first (i, j, k) of the box of cells.
+        /// \param box_end one past the last (i, j, k) of the box of cells.
+        /// Grids processed with periodic extension or remove_ij_boundary,
+        /// and reordered grids, cannot be updated; std::logic_error is thrown.
+        void updateEclipseFormat(const grdecl& input_data, const std::array<int, 3>& box_begin,
+                                 const std::array<int, 3>& box_end);
+
         //@}
 
         /// \name Cartesian grid extensions.
@@ -323,6 +340,15 @@ namespace Dune
             current_view_data_->setUniqueBoundaryIds(uids);
         }
 
+        /// Set the directory of the cache of processed grids.
+        /// \param directory if non-empty, processEclipseFormat() stores the processed grid
+        ///        in this directory, keyed by a hash of its input, and loads it from there
+        ///        when given the same input again.
+        void setGridCacheDirectory(const std::string& directory)
+        {
+            current_view_data_->setGridCacheDirectory(directory);
+        }
+
         // --- Dune interface below ---
 
         /// \name The DUNE grid interface implementation
@@ -408,6 +434,68 @@ namespace Dune
             return cpgrid::Iterator<codim, PiType>(*current_view_data_, size(codim), true);
         }
 
+        /// \brief Split the leaf entities of a codimension and partition into chunks.
+        ///
+        /// The entities are split by index into consecutive ranges, meant
+        /// as the tasks of a loop run by several threads, e.g. with
+        /// Ewoms::ThreadPool::parallelFor().  The ranges hold about the
+        /// same number of entities or, for cells weighed by their faces,
+        /// about the same number of cell faces, which is the work of a loop
+        /// over the intersections.  Ranges are empty if there are fewer
+        /// entities than chunks.
+        /// \tparam codim The codimension of the entities.
+        /// \tparam PiType The partition of the entities.
+        /// \param num_chunks The number of ranges, at least one.
+        /// \param weigh_by_faces Whether to balance the number of faces of
+        ///        the cells rather than the number of cells. Only for codim 0.
+        template<int codim, PartitionIteratorType PiType = All_Partition>
+        std::vector<boost::iterator_range<cpgrid::Iterator<codim, PiType> > >
+        leafChunks(int num_chunks, bool weigh_by_faces = false) const
+        {
+            typedef cpgrid::Iterator<codim, PiType> ChunkIterator;
+            if (num_chunks < 1) {
+                EWOMS_THROW(std::invalid_argument, "Cannot split entities into " << num_chunks << " chunks");
+            }
+            if (weigh_by_faces && codim != 0) {
+                EWOMS_THROW(std::invalid_argument, "Only cells can be weighed by their faces");
+            }
+            // The entities of the partition, in the order of the iterators.
+            const int num_all = current_view_data_->size(codim);
+            const std::vector<int>* entities = cpgrid::PartitionIteratorRule<PiType>::fullSet ?
+                nullptr : current_view_data_->partitionEntities(codim, PiType);
+            const int num = cpgrid::PartitionIteratorRule<PiType>::emptySet ? 0 :
+                (entities ? static_cast<int>(entities->size()) : num_all);
+            auto entity = [entities](int pos) { return entities ? (*entities)[pos] : pos; };
+
+            // The position of the first entity of each chunk, and of the end.
+            std::vector<int> start(num_chunks + 1, num);
+            if (weigh_by_faces) {
+                std::vector<long> faces_before(num + 1, 0);
+                for (int pos = 0; pos < num; ++pos) {
+                    faces_before[pos + 1] = faces_before[pos] + numCellFaces(entity(pos));
+                }
+                for (int chunk = 0; chunk < num_chunks; ++chunk) {
+                    const long target = faces_before[num] * chunk / num_chunks;
+                    start[chunk] = std::lower_bound(faces_before.begin(), faces_before.end(), target)
+                        - faces_before.begin();
+                }
+            } else {
+                for (int chunk = 0; chunk < num_chunks; ++chunk) {
+                    start[chunk] = static_cast<long>(num) * chunk / num_chunks;
+                }
+            }
+
+            std::vector<boost::iterator_range<ChunkIterator> > chunks;
+            chunks.reserve(num_chunks);
+            for (int chunk = 0; chunk < num_chunks; ++chunk) {
+                const int begin = start[chunk] < num ? entity(start[chunk]) : num_all;
+                const int end = start[chunk + 1] < num ? entity(start[chunk + 1]) : num_all;
+                chunks.emplace_back(ChunkIterator(*current_view_data_, begin, true),
+                                    ChunkIterator(*current_view_data_, end, true));
+            }
+            return chunks;
+        }
+
         /// \brief Number of grid entities per level and codim
         int size (int level, int codim) const
         {
@@ -890,6 +978,41 @@ namespace Dune
         {
             return current_view_data_->face_to_point_[face][local_index];
         }
+        /// \brief Get the index identifying a corner of a cell.
+        /// \param cell The index identifying the cell.
+        /// \param local_index The local index (in [0, 8)) of the corner, in
+        ///  lexicographical order by (kji), i.e. i running fastest.
+        int cellVertex(int cell, int local_index) const
+        {
+            return current_view_data_->cell_to_point_[cell][local_index];
+        }
+        /// \brief Get the cells connected to each cell through a face.
+        ///
+        /// The graph includes the NNC faces, is built on first use, also
+        /// when first used from several threads at once, and refers to the
+        /// current view.
+        /// \see cpgrid::CellNeighborGraph
+        const cpgrid::CellNeighborGraph& cellNeighborGraph() const
+        {
+            return current_view_data_->cellNeighborGraph();
+        }
+        /// \brief Renumber the cells and faces for locality of reference.
+        ///
+        /// Data stored by the old cell index c_old is moved to the new
+        /// index c by taking data_new[c] = data_old[cell_order[c]].  Must be
+        /// called before the grid is load balanced.
+        /// \param ordering the ordering of the cells.
+        /// \param[out] cell_order the old index of each new cell.
+        /// \param[out] face_order the old index of each new face.
+        /// \see cpgrid::CpGridData::reorderCells
+        void reorderCells(cpgrid::CellOrdering ordering, std::vector<int>& cell_order,
+                          std::vector<int>& face_order)
+        {
+            if (distributed_data_) {
+                EWOMS_THROW(std::logic_error, "The cells of a load balanced grid cannot be reordered.");
+            }
+            data_->reorderCells(ordering, cell_order, face_order);
+        }
         /// \brief Get vertical position of cell center ("zcorn" average).
         /// \brief cell_index The index of the specific cell.
         double cellCenterDepth(int cell_index) const
@@ -1015,13 +1138,13 @@ namespace Dune
         /// \param cell The index identifying the face.
         double faceArea(int face) const
         {
-            return current_view_data_->geomVector<1>()[cpgrid::EntityRep<1>(face, true)].volume();
+            return current_view_data_->geometry_.faceAreas()[face];
         }
         /// \brief Get the coordinates of the center of a face.
         /// \param cell The index identifying the face.
         const Vector& faceCentroid(int face) const
         {
-            return current_view_data_->geomVector<1>()[cpgrid::EntityRep<1>(face, true)].center();
+            return current_view_data_->geometry_.faceCentroids()[face];
         }
         /// \brief Get the unit normal of a face.
         /// \param cell The index identifying the face.
@@ -1034,13 +1157,54 @@ namespace Dune
         /// \param cell The index identifying the cell.
         double cellVolume(int cell) const
         {
-            return current_view_data_->geomVector<0>()[cpgrid::EntityRep<0>(cell, true)].volume();
+            return current_view_data_->geometry_.cellVolumes()[cell];
         }
         /// \brief Get the coordinates of the center of a cell.
         /// \param cell The index identifying the face.
         const Vector& cellCentroid(int cell) const
         {
-            return current_view_data_->geomVector<0>()[cpgrid::EntityRep<0>(cell, true)].center();
+            return current_view_data_->geometry_.cellCentroids()[cell];
+        }
+
+        /// \brief A contiguous range of scalars, one per entity.
+        typedef boost::iterator_range<const double*> ScalarRange;
+        /// \brief A contiguous range of vectors, one per entity.
+        typedef boost::iterator_range<const Vector*> VectorRange;
+
+        /// \brief Get the volumes of all cells, indexed by cell.
+        ///
+        /// The ranges returned by this and the following methods refer to
+        /// the storage of the current view and do not follow later calls
+        /// to switchToGlobalView() or switchToDistributedView().
+        ScalarRange cellVolumes() const
+        {
+            const auto& v = current_view_data_->geometry_.cellVolumes();
+            return ScalarRange(v.data(), v.data() + v.size());
+        }
+        /// \brief Get the centroids of all cells, indexed by cell.
+        VectorRange cellCentroids() const
+        {
+            const auto& v = current_view_data_->geometry_.cellCentroids();
+            return VectorRange(v.data(), v.data() + v.size());
+        }
+        /// \brief Get the areas of all faces, indexed by face.
+        ScalarRange faceAreas() const
+        {
+            const auto& v = current_view_data_->geometry_.faceAreas();
+            return ScalarRange(v.data(), v.data() + v.size());
+        }
+        /// \brief Get the centroids of all faces, indexed by face.
+        VectorRange faceCentroids() const
+        {
+            const auto& v = current_view_data_->geometry_.faceCentroids();
+            return VectorRange(v.data(), v.data() + v.size());
+        }
+        /// \brief Get the unit normals of all faces, indexed by face.
+        /// \see faceNormal
+        VectorRange faceNormals() const
+        {
+            const auto& v = current_view_data_->face_normals_;
+            return VectorRange(v.data(), v.data() + v.size());
         }
 
         /// \brief An iterator over the centroids of the geometry of the entities.
@@ -0,0 +1,199 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "celllocator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Dune
+{
+namespace cpgrid
+{
+
+namespace
+{
+    // Tolerance of the reference coordinates of points within a cell.
+    const double local_tolerance = 1e-8;
+}
+
+CellLocator::CellLocator(const CpGrid& grid, double cells_per_bucket)
+    : grid_(grid)
+{
+    const int num_cells = grid.numCells();
+
+    // Bounding boxes of the cells and of the whole view.
+    cell_boxes_.resize(num_cells);
+    lower_ = std::numeric_limits<double>::max();
+    Vector upper(-std::numeric_limits<double>::max());
+    Vector mean_extent(0.0);
+    for (int cell = 0; cell < num_cells; ++cell) {
+        Vector lo(std::numeric_limits<double>::max());
+        Vector hi(-std::numeric_limits<double>::max());
+        for (int i = 0; i < 8; ++i) {
+            const Vector& p = grid.vertexPosition(grid.cellVertex(cell, i));
+            for (int dd = 0; dd < 3; ++dd) {
+                lo[dd] = std::min(lo[dd], p[dd]);
+                hi[dd] = std::max(hi[dd], p[dd]);
+            }
+        }
+        for (int dd = 0; dd < 3; ++dd) {
+            lower_[dd] = std::min(lower_[dd], lo[dd]);
+            upper[dd] = std::max(upper[dd], hi[dd]);
+            mean_extent[dd] += hi[dd] - lo[dd];
+        }
+        cell_boxes_[cell] = {{ lo, hi }};
+    }
+
+    // Buckets of about cells_per_bucket average cells, but not many more
+    // buckets than cells.
+    const double scale = std::cbrt(std::max(cells_per_bucket, 1.0));
+    double total = 1.0;
+    for (int dd = 0; dd < 3; ++dd) {
+        const double extent = num_cells > 0 ? upper[dd] - lower_[dd] : 0.0;
+        const double cell_extent = num_cells > 0 ? scale*mean_extent[dd]/num_cells : 0.0;
+        num_buckets_[dd] = 1;
+        if (extent > 0.0 && cell_extent > 0.0) {
+            num_buckets_[dd] = static_cast<int>(std::min(std::ceil(extent/cell_extent), 1e6));
+        }
+        total *= num_buckets_[dd];
+    }
+    while (total > 2.0*num_cells + 1.0) {
+        total = 1.0;
+        for (int dd = 0; dd < 3; ++dd) {
+            num_buckets_[dd] = (num_buckets_[dd] + 1)/2;
+            total *= num_buckets_[dd];
+        }
+    }
+    for (int dd = 0; dd < 3; ++dd) {
+        const double extent = num_cells > 0 ? upper[dd] - lower_[dd] : 0.0;
+        bucket_size_[dd] = extent > 0.0 ? extent/num_buckets_[dd] : 1.0;
+    }
+
+    // Sort the cells into the buckets overlapped by their bounding boxes,
+    // counting first.  Each bucket lists its cells in increasing order.
+    const int nb = num_buckets_[0]*num_buckets_[1]*num_buckets_[2];
+    bucket_ptr_.assign(nb + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int cell = 0; cell < num_cells; ++cell) {
+            std::array<int, 3> lo, hi;
+            bucketOf(cell_boxes_[cell][0], lo);
+            bucketOf(cell_boxes_[cell][1], hi);
+            for (int k = lo[2]; k <= hi[2]; ++k) {
+                for (int j = lo[1]; j <= hi[1]; ++j) {
+                    for (int i = lo[0]; i <= hi[0]; ++i) {
+                        const int bucket = i + num_buckets_[0]*(j + num_buckets_[1]*k);
+                        if (pass == 0) {
+                            ++bucket_ptr_[bucket + 1];
+                        } else {
+                            bucket_cells_[bucket_ptr_[bucket]++] = cell;
+                        }
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int bucket = 0; bucket < nb; ++bucket) {
+                bucket_ptr_[bucket + 1] += bucket_ptr_[bucket];
+            }
+            bucket_cells_.resize(bucket_ptr_[nb]);
+        } else {
+            // The fill advanced each start to the next one's, shift back.
+            for (int bucket = nb; bucket > 0; --bucket) {
+                bucket_ptr_[bucket] = bucket_ptr_[bucket - 1];
+            }
+            bucket_ptr_[0] = 0;
+        }
+    }
+}
+
+int CellLocator::locate(const Vector& point, Vector* local) const
+{
+    std::array<int, 3> ijk;
+    if (!bucketOf(point, ijk)) {
+        return -1;
+    }
+    const int bucket = ijk[0] + num_buckets_[0]*(ijk[1] + num_buckets_[1]*ijk[2]);
+    Vector x;
+    for (int pos = bucket_ptr_[bucket]; pos < bucket_ptr_[bucket + 1]; ++pos) {
+        const int cell = bucket_cells_[pos];
+        if (contains(cell, point, x)) {
+            if (local) {
+                *local = x;
+            }
+            return cell;
+        }
+    }
+    return -1;
+}
+
+std::vector<int> CellLocator::locate(const std::vector<Vector>& points) const
+{
+    const int num_points = points.size();
+    std::vector<int> cells(num_points);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < num_points; ++i) {
+        cells[i] = locate(points[i]);
+    }
+    return cells;
+}
+
+bool CellLocator::bucketOf(const Vector& point, std::array<int, 3>& ijk) const
+{
+    bool inside = true;
+    for (int dd = 0; dd < 3; ++dd) {
+        const double pos = (point[dd] - lower_[dd])/bucket_size_[dd];
+        // Admit points on the boundary of the view, up to rounding.
+        inside = inside && pos >= -local_tolerance && pos <= num_buckets_[dd]*(1.0 + local_tolerance);
+        ijk[dd] = std::max(0, std::min(num_buckets_[dd] - 1, static_cast<int>(std::floor(pos))));
+    }
+    return inside;
+}
+
+bool CellLocator::contains(int cell, const Vector& point, Vector& local) const
+{
+    const auto& box = cell_boxes_[cell];
+    for (int dd = 0; dd < 3; ++dd) {
+        const double slack = local_tolerance*(box[1][dd] - box[0][dd]);
+        if (point[dd] < box[0][dd] - slack || point[dd] > box[1][dd] + slack) {
+            return false;
+        }
+    }
+    Vector corners[8];
+    for (int i = 0; i < 8; ++i) {
+        corners[i] = grid_.vertexPosition(grid_.cellVertex(cell, i));
+    }
+    if (!TrilinearMap(corners).local(point, local)) {
+        return false;
+    }
+    for (int dd = 0; dd < 3; ++dd) {
+        if (local[dd] < -local_tolerance || local[dd] > 1.0 + local_tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace cpgrid
+} // namespace Dune
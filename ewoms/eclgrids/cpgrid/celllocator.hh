@@ -0,0 +1,91 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EWOMS_CPGRIDCELLLOCATOR_HEADER
+#define EWOMS_CPGRIDCELLLOCATOR_HEADER
+
+#include <ewoms/eclgrids/cpgrid.hh>
+#include <ewoms/eclgrids/cpgrid/geometry.hh>
+
+#include <array>
+#include <vector>
+
+namespace Dune
+{
+    namespace cpgrid
+    {
+        /// Finds the cell of a CpGrid containing a point.
+        ///
+        /// The bounding boxes of the cells are sorted into a uniform grid
+        /// of buckets, sized after the average cell.  A query tests the
+        /// cells of the bucket containing the point, first against their
+        /// bounding boxes and then against their trilinear geometry.
+        ///
+        /// The locator works on the current view of the grid.  In a
+        /// distributed run it finds the cells held by this process,
+        /// including overlap cells, and cell indices refer to that view.
+        /// It must be rebuilt if the grid changes, e.g. by loadBalance().
+        class CellLocator
+        {
+        public:
+            typedef FieldVector<double, 3> Vector;
+
+            /// @brief Build the search structure.
+            /// @param grid the grid, which must outlive the locator.
+            /// @param cells_per_bucket the number of cells per bucket aimed at.
+            explicit CellLocator(const CpGrid& grid, double cells_per_bucket = 4.0);
+
+            /// @brief Find the cell containing a point.
+            /// Points on the boundary between cells are assigned to the
+            /// cell with the lowest index.
+            /// @param point the point to search for
+            /// @param local if non-null, the reference coordinates of the
+            ///        point within the cell on return.
+            /// @return the index of the cell, or -1 if no cell of the view
+            ///         contains the point.
+            int locate(const Vector& point, Vector* local = nullptr) const;
+
+            /// @brief Find the cells containing many points, in parallel
+            /// if OpenMP is available.
+            /// @param points the points to search for
+            /// @return the index of the cell containing each point, or -1.
+            std::vector<int> locate(const std::vector<Vector>& points) const;
+
+            /// The number of buckets along each axis.
+            const std::array<int, 3>& bucketDimensions() const
+            {
+                return num_buckets_;
+            }
+
+        private:
+            bool bucketOf(const Vector& point, std::array<int, 3>& ijk) const;
+            bool contains(int cell, const Vector& point, Vector& local) const;
+
+            const CpGrid& grid_;
+            Vector lower_;
+            Vector bucket_size_;
+            std::array<int, 3> num_buckets_;
+            std::vector<std::array<Vector, 2>> cell_boxes_;
+            std::vector<int> bucket_ptr_;
+            std::vector<int> bucket_cells_;
+        };
+
+    } // namespace cpgrid
+} // namespace Dune
+
+#endif // EWOMS_CPGRIDCELLLOCATOR_HEADER
@@ -0,0 +1,88 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "cellneighborgraph.hh"
+#include "orientedentitytable.hh"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace Dune
+{
+namespace cpgrid
+{
+
+CellNeighborGraph::CellNeighborGraph(const OrientedEntityTable<1, 0>& face_to_cell, int num_cells)
+    : start_(num_cells + 1, 0)
+{
+    const int num_faces = face_to_cell.size();
+    // Faces along the front of a distributed grid list a cell that is
+    // not present as std::numeric_limits<int>::max().
+    auto interior = [&face_to_cell](int face, int& c0, int& c1) {
+        const auto cells = face_to_cell[EntityRep<1>(face, true)];
+        if (cells.size() != 2) {
+            return false;
+        }
+        c0 = cells[0].index();
+        c1 = cells[1].index();
+        return c0 != std::numeric_limits<int>::max() && c1 != std::numeric_limits<int>::max();
+    };
+
+    // Count, then fill in order of the faces, then sort each row.
+    int c0, c1;
+    for (int face = 0; face < num_faces; ++face) {
+        if (interior(face, c0, c1)) {
+            ++start_[c0 + 1];
+            ++start_[c1 + 1];
+        }
+    }
+    for (int cell = 0; cell < num_cells; ++cell) {
+        start_[cell + 1] += start_[cell];
+    }
+    neighbors_.resize(start_[num_cells]);
+    faces_.resize(start_[num_cells]);
+    std::vector<int> next(start_.begin(), start_.end() - 1);
+    for (int face = 0; face < num_faces; ++face) {
+        if (interior(face, c0, c1)) {
+            neighbors_[next[c0]] = c1;
+            faces_[next[c0]++] = face;
+            neighbors_[next[c1]] = c0;
+            faces_[next[c1]++] = face;
+        }
+    }
+
+    std::vector<std::pair<int, int> > row;
+    for (int cell = 0; cell < num_cells; ++cell) {
+        row.clear();
+        for (int slot = start_[cell]; slot < start_[cell + 1]; ++slot) {
+            row.emplace_back(neighbors_[slot], faces_[slot]);
+        }
+        std::sort(row.begin(), row.end());
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            neighbors_[start_[cell] + i] = row[i].first;
+            faces_[start_[cell] + i] = row[i].second;
+        }
+    }
+}
+
+} // namespace cpgrid
+} // namespace Dune
@@ -0,0 +1,144 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EWOMS_CPGRIDCELLNEIGHBORGRAPH_HEADER
+#define EWOMS_CPGRIDCELLNEIGHBORGRAPH_HEADER
+
+#include <boost/range/iterator_range.hpp>
+
+#include <vector>
+
+namespace Dune
+{
+    namespace cpgrid
+    {
+        template <int codim_from, int codim_to>
+        class OrientedEntityTable;
+
+        /// The cells connected to each cell through a face, in compressed
+        /// sparse row form.
+        ///
+        /// There is one connection for every interior face of a cell,
+        /// NNC faces included, ordered by the index of the neighbour and
+        /// then of the face.  Faces whose other cell is not present on
+        /// this process are left out.  The position of a connection in
+        /// the graph, its slot, can index arrays of per-connection values
+        /// such as transmissibilities or off-diagonal matrix blocks.
+        class CellNeighborGraph
+        {
+        public:
+            typedef boost::iterator_range<const int*> row_type;
+
+            /// Create an empty graph.
+            CellNeighborGraph()
+                : start_(1, 0)
+            {
+            }
+
+            /// Build the graph from the face-to-cell relation.
+            /// \param face_to_cell the cells of each face.
+            /// \param num_cells the number of cells.
+            CellNeighborGraph(const OrientedEntityTable<1, 0>& face_to_cell, int num_cells);
+
+            /// The number of cells.
+            int numCells() const
+            {
+                return start_.size() - 1;
+            }
+
+            /// The total number of connections, that is, of slots.
+            int numConnections() const
+            {
+                return neighbors_.size();
+            }
+
+            /// The slot of the first connection of a cell.  The
+            /// connections of cell c occupy slots rowStart(c) up to, but
+            /// not including, rowStart(c + 1).
+            int rowStart(int cell) const
+            {
+                return start_[cell];
+            }
+
+            /// The neighbours of a cell.
+            row_type neighbors(int cell) const
+            {
+                return row_type(neighbors_.data() + start_[cell], neighbors_.data() + start_[cell + 1]);
+            }
+
+            /// The faces connecting a cell to each of its neighbours.
+            row_type faces(int cell) const
+            {
+                return row_type(faces_.data() + start_[cell], faces_.data() + start_[cell + 1]);
+            }
+
+            /// The neighbour of the connection in a slot.
+            int neighbor(int slot) const
+            {
+                return neighbors_[slot];
+            }
+
+            /// The face of the connection in a slot.
+            int face(int slot) const
+            {
+                return faces_[slot];
+            }
+
+            /// Set up the sparsity pattern of a cell-by-cell matrix, e.g. a
+            /// Dune::BCRSMatrix, with the diagonal and one entry for each
+            /// distinct neighbour of each cell.
+            /// \tparam Matrix a matrix type with the random build mode of
+            ///         Dune::BCRSMatrix.
+            template <class Matrix>
+            void setupSparsityPattern(Matrix& matrix) const
+            {
+                const int num_cells = numCells();
+                matrix.setBuildMode(Matrix::random);
+                matrix.setSize(num_cells, num_cells);
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    matrix.setrowsize(cell, numDistinctNeighbors(cell) + 1);
+                }
+                matrix.endrowsizes();
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    matrix.addindex(cell, cell);
+                    for (int slot = start_[cell]; slot < start_[cell + 1]; ++slot) {
+                        matrix.addindex(cell, neighbors_[slot]);
+                    }
+                }
+                matrix.endindices();
+            }
+
+        private:
+            int numDistinctNeighbors(int cell) const
+            {
+                int count = 0;
+                for (int slot = start_[cell]; slot < start_[cell + 1]; ++slot) {
+                    count += (slot == start_[cell] || neighbors_[slot] != neighbors_[slot - 1]);
+                }
+                return count;
+            }
+
+            std::vector<int> start_;
+            std::vector<int> neighbors_;
+            std::vector<int> faces_;
+        };
+
+    } // namespace cpgrid
+} // namespace Dune
+
+#endif // EWOMS_CPGRIDCELLNEIGHBORGRAPH_HEADER
@@ -30,6 +30,7 @@
 #include <ewoms/eclgrids/common/zoltangraphfunctions.hh>
 #include <ewoms/eclgrids/common/gridpartitioning.hh>
 #include <ewoms/eclgrids/common/wellconnections.hh>
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
 
 #include <fstream>
 #include <iostream>
@@ -143,6 +144,7 @@ CpGrid::scatterGrid(EdgeWeightMethod method,
 
     if (cc.size() > 1)
     {
+        Ewoms::time::PhaseProfiler::Scope phase("scatterGrid");
         std::vector<int> cell_part;
         std::vector<std::pair<std::string,bool>> wells_on_proc;
         std::vector<std::tuple<int,int,char>> exportList;
@@ -151,6 +153,7 @@ CpGrid::scatterGrid(EdgeWeightMethod method,
         if (useZoltan)
         {
 #ifdef HAVE_ZOLTAN
+            Ewoms::time::PhaseProfiler::Scope partition_phase("partition");
             std::tie(cell_part, wells_on_proc, exportList, importList)
                 = serialPartitioning
                 ? cpgrid::zoltanSerialGraphPartitionGridOnRoot(*this, wells, transmissibilities, cc, method, 0)
@@ -161,6 +164,7 @@ CpGrid::scatterGrid(EdgeWeightMethod method,
         }
         else
         {
+        Ewoms::time::PhaseProfiler::Scope partition_phase("partition");
         std::vector<int> exportGlobalIds;
         std::vector<int> exportLocalIds;
         std::vector<int> exportToPart;
@@ -228,8 +232,12 @@ CpGrid::scatterGrid(EdgeWeightMethod method,
         // first create the overlap
         // map from process to global cell indices in overlap
         std::map<int,std::set<int> > overlap;
-        auto noImportedOwner = addOverlapLayer(*this, cell_part, exportList, importList, cc, addCornerCells,
-                                               transmissibilities);
+        int noImportedOwner = 0;
+        {
+            Ewoms::time::PhaseProfiler::Scope overlap_phase("addOverlapLayer");
+            noImportedOwner = addOverlapLayer(*this, cell_part, exportList, importList, cc, addCornerCells,
+                                              transmissibilities);
+        }
         // importList contains all the indices that will be here.
         auto compareImport = [](const std::tuple<int,int,char,int>& t1,
                                 const std::tuple<int,int,char,int>&t2)
@@ -317,18 +325,21 @@ CpGrid::scatterGrid(EdgeWeightMethod method,
         // Just to be sure we assume that only master knows
         cc.broadcast(&distributed_data_->use_unique_boundary_ids_, 1, 0);
 
-        // Create indexset
-        distributed_data_->cell_indexset_.beginResize();
-        for(const auto& entry: importList)
         {
-            distributed_data_->cell_indexset_.add(std::get<0>(entry), ParallelIndexSet::LocalIndex(std::get<3>(entry), AttributeSet(std::get<2>(entry)), true));
+            Ewoms::time::PhaseProfiler::Scope interface_phase("cellInterfaces");
+            // Create indexset
+            distributed_data_->cell_indexset_.beginResize();
+            for(const auto& entry: importList)
+            {
+                distributed_data_->cell_indexset_.add(std::get<0>(entry), ParallelIndexSet::LocalIndex(std::get<3>(entry), AttributeSet(std::get<2>(entry)), true));
+            }
+            distributed_data_->cell_indexset_.endResize();
+            // add an interface for gathering/scattering data with communication
+            // forward direction will be scatter and backward gather
+            // Interface will communicate from owner to all
+            setupSendInterface(exportList, *cell_scatter_gather_interfaces_);
+            setupRecvInterface(importList, *cell_scatter_gather_interfaces_);
         }
-        distributed_data_->cell_indexset_.endResize();
-        // add an interface for gathering/scattering data with communication
-        // forward direction will be scatter and backward gather
-        // Interface will communicate from owner to all
-        setupSendInterface(exportList, *cell_scatter_gather_interfaces_);
-        setupRecvInterface(importList, *cell_scatter_gather_interfaces_);
 
         distributed_data_->distributeGlobalGrid(*this,*this->current_view_data_, cell_part);
         global_id_set_.insertIdSet(*distributed_data_);
@@ -449,4 +460,10 @@ CpGrid::scatterGrid(EdgeWeightMethod method,
                                              0);
     }
 
+    void CpGrid::updateEclipseFormat(const grdecl& input_data, const std::array<int, 3>& box_begin,
+                                     const std::array<int, 3>& box_end)
+    {
+        current_view_data_->updateEclipseFormat(input_data, box_begin, box_end);
+    }
+
 } // namespace Dune
@@ -34,6 +34,7 @@
 #include <dune/common/parallel/remoteindices.hh>
 #include <dune/common/enumset.hh>
 #include <ewoms/eclgrids/utility/sparsetable.hh>
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
 
 #include <ewoms/eclgrids/cpgrid.hh>
 
@@ -44,8 +45,11 @@ namespace cpgrid
 
 CpGridData::CpGridData(const CpGridData& g)
     : index_set_(new IndexSet(*this)), local_id_set_(new IdSet(*this)),
-      global_id_set_(new LevelGlobalIdSet(local_id_set_, this)), partition_type_indicator_(new PartitionTypeIndicator(*this)), ccobj_(g.ccobj_)
+      global_id_set_(new LevelGlobalIdSet(local_id_set_, this)), partition_type_indicator_(new PartitionTypeIndicator(*this)), ccobj_(g.ccobj_),
+      use_unique_boundary_ids_(false), can_update_eclipse_format_(false),
+      processed_z_tolerance_(0.0), processed_turn_normals_(false)
 {
+    resetCellNeighborGraph();
 #if HAVE_MPI
     cell_interfaces_=std::make_tuple(Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_));
 #endif
@@ -54,8 +58,11 @@ CpGridData::CpGridData(const CpGridData& g)
 CpGridData::CpGridData()
     : index_set_(new IndexSet(*this)), local_id_set_(new IdSet(*this)),
       global_id_set_(new LevelGlobalIdSet(local_id_set_, this)), partition_type_indicator_(new PartitionTypeIndicator(*this)),
-      ccobj_(Dune::MPIHelper::getCommunicator()), use_unique_boundary_ids_(false)
+      ccobj_(Dune::MPIHelper::getCommunicator()), use_unique_boundary_ids_(false),
+      can_update_eclipse_format_(false), processed_z_tolerance_(0.0),
+      processed_turn_normals_(false)
 {
+    resetCellNeighborGraph();
 #if HAVE_MPI
     cell_interfaces_=std::make_tuple(Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_));
 #endif
@@ -64,8 +71,11 @@ CpGridData::CpGridData()
 CpGridData::CpGridData(MPIHelper::MPICommunicator comm)
     : index_set_(new IndexSet(*this)), local_id_set_(new IdSet(*this)),
       global_id_set_(new LevelGlobalIdSet(local_id_set_, this)), partition_type_indicator_(new PartitionTypeIndicator(*this)),
-      ccobj_(comm), use_unique_boundary_ids_(false)
+      ccobj_(comm), use_unique_boundary_ids_(false),
+      can_update_eclipse_format_(false), processed_z_tolerance_(0.0),
+      processed_turn_normals_(false)
 {
+    resetCellNeighborGraph();
 #if HAVE_MPI
     cell_interfaces_=std::make_tuple(Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_));
 #endif
@@ -74,8 +84,11 @@ CpGridData::CpGridData(MPIHelper::MPICommunicator comm)
 CpGridData::CpGridData(CpGrid&)
   : index_set_(new IndexSet(*this)),   local_id_set_(new IdSet(*this)),
     global_id_set_(new LevelGlobalIdSet(local_id_set_, this)),  partition_type_indicator_(new PartitionTypeIndicator(*this)),
-    ccobj_(Dune::MPIHelper::getCommunicator()), use_unique_boundary_ids_(false)
+    ccobj_(Dune::MPIHelper::getCommunicator()), use_unique_boundary_ids_(false),
+      can_update_eclipse_format_(false), processed_z_tolerance_(0.0),
+      processed_turn_normals_(false)
 {
+    resetCellNeighborGraph();
 #if HAVE_MPI
     cell_interfaces_=std::make_tuple(Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_),Interface(ccobj_));
 #endif
@@ -131,6 +144,25 @@ void CpGridData::populateGlobalCellIndexSet()
 #endif
 }
 
+const CellNeighborGraph& CpGridData::cellNeighborGraph() const
+{
+    std::call_once(*cell_neighbor_graph_once_, [this] {
+        cell_neighbor_graph_.reset(new CellNeighborGraph(face_to_cell_, size(0)));
+    });
+    return *cell_neighbor_graph_;
+}
+
+void CpGridData::resetCellNeighborGraph()
+{
+    cell_neighbor_graph_.reset();
+    cell_neighbor_graph_once_.reset(new std::once_flag);
+}
+
+const std::vector<int>* CpGridData::partitionEntities(int codim, PartitionIteratorType pitype) const
+{
+    return partition_type_indicator_->partitionEntities(codim, pitype);
+}
+
 void CpGridData::computeUniqueBoundaryIds()
 {
     // Perhaps we should make available a more comprehensive interface
@@ -1240,23 +1272,31 @@ void CpGridData::computeGeometry(CpGrid& grid,
                                  const OrientedEntityTable<0, 1>& globalCell2Faces,
                                  DefaultGeometryPolicy& geometry,
                                  const OrientedEntityTable<0, 1>& cell2Faces,
-                                 const std::vector< std::array<int,8> >& cell2Points)
+                                 const std::vector< std::array<int,8> >& cell2Points,
+                                 int noFaces, int noPoints)
 {
+    EntityVariable<cpgrid::Geometry<3, 3>, 0> cellGeom;
+    EntityVariable<cpgrid::Geometry<2, 3>, 1> faceGeom;
+    EntityVariable<cpgrid::Geometry<0, 3>, 3> pointGeom;
+    faceGeom.resize(noFaces);
+    cellGeom.resize(cell2Faces.size());
+    pointGeom.resize(noPoints);
+
     FaceGeometryHandle faceGeomHandle(globalGeometry.geomVector(std::integral_constant<int,1>()),
-                                      geometry.geomVector(std::integral_constant<int,1>()));
+                                      faceGeom);
     FaceViaCellHandleWrapper<FaceGeometryHandle>
         wrappedFaceGeomHandle(faceGeomHandle, globalCell2Faces, cell2Faces);
     grid.scatterData(wrappedFaceGeomHandle);
 
     PointGeometryHandle pointGeomHandle(globalGeometry.geomVector(std::integral_constant<int,3>()),
-                                             geometry.geomVector(std::integral_constant<int,3>()));
+                                             pointGeom);
     grid.scatterData(pointGeomHandle);
 
     CellGeometryHandle cellGeomHandle(globalGeometry.geomVector(std::integral_constant<int,0>()),
-                                      geometry.geomVector(std::integral_constant<int,0>()),
-                                      geometry.geomVector(std::integral_constant<int,3>()),
-                                      cell2Points);
+                                      cellGeom, pointGeom, cell2Points);
     grid.scatterData(cellGeomHandle);
+
+    geometry.setGeometries(std::move(cellGeom), std::move(faceGeom), std::move(pointGeom));
 }
 
 void computeFace2Point(CpGrid& grid,
@@ -1525,14 +1565,18 @@ void CpGridData::distributeGlobalGrid(CpGrid& grid,
                                       const std::vector<int>& /* cell_part */)
 {
 #if HAVE_MPI
+    Ewoms::time::PhaseProfiler::Scope phase("distributeGlobalGrid");
     // setup the remote indices.
+    Ewoms::time::PhaseProfiler::Scope remote_phase("remoteIndices");
     cell_remote_indices_.setIndexSets(cell_indexset_, cell_indexset_, ccobj_);
     cell_remote_indices_.template rebuild<false>(); // We could probably also compute this on our own, like before?
+    remote_phase.stop();
 
     // We can identify existing cells with the help of the index set.
     // Now we need to compute the existing faces and points. Either exist
     // if they are reachable from an existing cell.
     // We use std::numeric_limits<int>::max() to indicate non-existent entities.
+    Ewoms::time::PhaseProfiler::Scope topology_phase("topology");
     std::vector<int> map2GlobalFaceId;
     std::vector<int> map2GlobalPointId;
     std::map<int,int> point_indicator =
@@ -1566,15 +1610,17 @@ void CpGridData::distributeGlobalGrid(CpGrid& grid,
                       noExistingFaces);
 
     logical_cartesian_size_=view_data.logical_cartesian_size_;
+    topology_phase.stop();
 
     // Set up the new topology arrays
-    geometry_.geomVector(std::integral_constant<int,1>()).resize(noExistingFaces);
-    geometry_.geomVector(std::integral_constant<int,0>()).resize(cell_to_face_.size());
-    geometry_.geomVector(std::integral_constant<int,3>()).resize(noExistingPoints);
-
+    Ewoms::time::PhaseProfiler::Scope geometry_phase("geometry");
     computeGeometry(grid, view_data.geometry_, view_data.cell_to_face_,
-                    geometry_, cell_to_face_, cell_to_point_);
+                    geometry_, cell_to_face_, cell_to_point_,
+                    noExistingFaces, noExistingPoints);
+    resetCellNeighborGraph();
+    geometry_phase.stop();
 
+    Ewoms::time::PhaseProfiler::Scope scatter_phase("scatterData");
     global_cell_.resize(cell_indexset_.size());
 
     // communicate global cell
@@ -1604,8 +1650,10 @@ void CpGridData::distributeGlobalGrid(CpGrid& grid,
         wrappedFaceHandle(faceHandle, view_data.cell_to_face_, cell_to_face_);
         grid.scatterData(wrappedFaceHandle);
     }
+    scatter_phase.stop();
 
     // Compute the partition type for cell
+    Ewoms::time::PhaseProfiler::Scope partition_type_phase("partitionTypes");
     partition_type_indicator_->cell_indicator_.resize(cell_indexset_.size());
     for(const auto& i: cell_indexset_)
     {
@@ -1639,8 +1687,11 @@ void CpGridData::distributeGlobalGrid(CpGrid& grid,
                 partition_type_indicator_->point_indicator_[*p]=new_type;
         }
     }
+    partition_type_indicator_->computePartitionEntities();
+    partition_type_phase.stop();
 
     // Compute the interface information for cells
+    Ewoms::time::PhaseProfiler::Scope interface_phase("interfaces");
     std::get<InteriorBorder_All_Interface>(cell_interfaces_)
         .build(cell_remote_indices_, EnumItem<AttributeSet, AttributeSet::owner>(),
                AllSet<AttributeSet>());
@@ -50,13 +50,19 @@
 #include <dune/grid/common/gridenums.hh>
 
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <tuple>
 #include <algorithm>
 #include <set>
 
 #include "orientedentitytable.hh"
 #include "defaultgeometrypolicy.hh"
+#include "cellneighborgraph.hh"
 #include <ewoms/eclgrids/cpgpreprocess/preprocess.h>
+#include <ewoms/eclgrids/utility/sparsetable.hh>
 
 #include <ewoms/eclgrids/utility/parserincludes.hh>
 
@@ -84,6 +90,16 @@ namespace mover
 template<class T, int i> struct Mover;
 }
 
+/// The orderings of the cells that CpGridData::reorderCells() can apply.
+enum class CellOrdering {
+    /// Reverse Cuthill-McKee on the cell neighbour graph, which keeps the
+    /// neighbours of a cell close to it in the numbering.
+    ReverseCuthillMcKee,
+    /// The order of the cell centroids along a Hilbert curve, which keeps
+    /// cells that are close in space close in the numbering.
+    Hilbert
+};
+
 /**
  * @brief Struct that hods all the data needed to represent a
  * Cpgrid.
@@ -187,7 +203,29 @@ public:
     /// \param z_tolerance points along a pillar that are closer together in z
     ///        coordinate than this parameter, will be replaced by a single point.
     /// \param remove_ij_boundary if true, will remove (i, j) boundaries. Used internally.
-    void processEclipseFormat(const grdecl& input_data, const std::array<std::set<std::pair<int, int>>, 2>& nnc, double z_tolerance, bool remove_ij_boundary, bool turn_normals = false);
+    /// \param zcorn_work if non-null, the writable array input_data.zcorn refers to. It is then
+    ///        reordered in place during processing instead of being copied, and holds the
+    ///        original values again on return.
+    /// The arrays of input_data are only borrowed for the duration of the call, the grid
+    /// does not keep any reference to them.
+    void processEclipseFormat(const grdecl& input_data, const std::array<std::set<std::pair<int, int>>, 2>& nnc, double z_tolerance, bool remove_ij_boundary, bool turn_normals = false,
+                              double* zcorn_work = nullptr);
+
+    /// Update the grid after a change of the corner-point data within a box of cells.
+    /// Points and faces are only rediscovered in the columns of cells around the box,
+    /// and the geometry of the unchanged faces and cells is retained.
+    /// The NNCs (explicit and PINCH), z_tolerance and normal orientation are
+    /// those the grid was processed with.
+    /// \param input_data the changed data in grdecl format, the COORD and the data
+    ///        outside of the box must be those the grid was processed from, i.e.
+    ///        after MINPV processing for grids read from an EclipseGrid.
+    /// \param box_begin first (i, j, k) of the box of cells.
+    /// \param box_end one past the last (i, j, k) of the box of cells.
+    /// The grid must not have been processed with periodic extension or
+    /// removal of the outer cell layer, nor been reordered, otherwise a
+    /// std::logic_error is thrown.
+    void updateEclipseFormat(const grdecl& input_data, const std::array<int, 3>& box_begin,
+                             const std::array<int, 3>& box_end);
 
     /// @brief
     ///    Extract Cartesian index triplet (i,j,k) of an active cell.
@@ -225,6 +263,21 @@ public:
         }
     }
 
+    /// Set the directory of the cache of processed grids.
+    /// \param directory if non-empty, processEclipseFormat() stores the processed grid
+    ///        in this directory, keyed by a hash of its input, and loads it from there
+    ///        when given the same input again.
+    void setGridCacheDirectory(const std::string& directory)
+    {
+        grid_cache_directory_ = directory;
+    }
+
+    /// The directory of the cache of processed grids, empty if not caching.
+    const std::string& gridCacheDirectory() const
+    {
+        return grid_cache_directory_;
+    }
+
     /// Return the internalized zcorn copy from the grid processing, if
     /// no cells were adjusted during the minpvprocessing this can be
     /// and empty vector.
@@ -246,6 +299,33 @@ public:
         return logical_cartesian_size_;
     }
 
+    /// The cells connected to each cell through a face, NNCs included.
+    /// The graph is built on first use, which may happen concurrently
+    /// from several threads, and kept until the topology of the grid
+    /// changes.
+    const CellNeighborGraph& cellNeighborGraph() const;
+
+    /// The indices, in increasing order, of the cells or points in a
+    /// partition of a parallel grid, or a null pointer if there is no
+    /// such list.
+    /// \see PartitionTypeIndicator::partitionEntities
+    const std::vector<int>* partitionEntities(int codim, PartitionIteratorType pitype) const;
+
+    /// \brief Renumber the cells and faces for locality of reference.
+    ///
+    /// The cells are put in the given ordering and the faces sorted by
+    /// the new index of the first and then the second of their cells, so
+    /// that a loop over the faces visits the cells in order.  All tables
+    /// and per-entity data of the grid are permuted to match, the points
+    /// keep their numbers.  The index and id sets follow the new numbers.
+    /// Only grids of sequential runs can be reordered, and a reordered
+    /// grid cannot be changed by updateEclipseFormat().
+    /// \param ordering the ordering of the cells.
+    /// \param[out] cell_order the old index of each new cell.
+    /// \param[out] face_order the old index of each new face.
+    void reorderCells(CellOrdering ordering, std::vector<int>& cell_order,
+                      std::vector<int>& face_order);
+
     /// \brief Redistribute a global grid.
     ///
     /// The whole grid must be available on all processors.
@@ -282,6 +362,13 @@ private:
     /// \brief Adds entries to the parallel index set of the cells during grid construction
     void populateGlobalCellIndexSet();
 
+    /// \brief Read the processed grid with the given input key from a cache file.
+    /// \return false, leaving the grid unchanged, if there is no such grid in the file.
+    bool readGridCache(const std::string& filename, std::uint64_t key);
+
+    /// \brief Write the processed grid with the given input key to a cache file.
+    void writeGridCache(const std::string& filename, std::uint64_t key) const;
+
 #if HAVE_MPI
 
     /// \brief Gather data on a global grid representation.
@@ -351,12 +438,16 @@ private:
 
 #endif
 
+    /// Forget the cell neighbour graph, after a change of the topology.
+    void resetCellNeighborGraph();
+
     void computeGeometry(CpGrid& grid,
                          const DefaultGeometryPolicy&  globalGeometry,
                          const OrientedEntityTable<0, 1>& globalCell2Faces,
                          DefaultGeometryPolicy& geometry,
                          const OrientedEntityTable<0, 1>& cell2Faces,
-                         const std::vector< std::array<int,8> >& cell2Points);
+                         const std::vector< std::array<int,8> >& cell2Points,
+                         int noFaces, int noPoints);
 
     // Representing the topology
     /** @brief Container for lookup of the faces attached to each cell. */
@@ -397,6 +488,10 @@ private:
     cpgrid::SignedEntityVariable<PointType, 1> face_normals_;
     /** @brief The boundary ids. */
     cpgrid::EntityVariable<int, 1> unique_boundary_ids_;
+    /** @brief The cell-to-cell connectivity, built on demand. */
+    mutable std::unique_ptr<CellNeighborGraph> cell_neighbor_graph_;
+    /** @brief Guards building cell_neighbor_graph_, renewed with the topology. */
+    std::unique_ptr<std::once_flag> cell_neighbor_graph_once_;
     /** @brief The index set of the grid (level). */
     cpgrid::IndexSet* index_set_;
     /** @brief The internal local id set (not exported). */
@@ -415,6 +510,20 @@ private:
     // Boundary information (optional).
     bool use_unique_boundary_ids_;
 
+    /// Whether updateEclipseFormat() can recover the processed grid: the
+    /// grid was processed without removing the outer cell layer, as is
+    /// done for periodic extension, and its cells were not reordered.
+    bool can_update_eclipse_format_;
+
+    /// The NNCs, z_tolerance and normal orientation the grid was processed
+    /// with, which updateEclipseFormat() processes the changed data with.
+    std::array<std::set<std::pair<int, int>>, 2> processed_nnc_;
+    double processed_z_tolerance_;
+    bool processed_turn_normals_;
+
+    /// Directory of the cache of processed grids, empty if not caching.
+    std::string grid_cache_directory_;
+
     /// This vector contains zcorn values from the initialization
     /// process where a CpGrid instance has been created from
     /// cornerpoint input zcorn and coord. During the initialization
@@ -22,6 +22,9 @@
 #include "geometry.hh"
 #include "entityrep.hh"
 
+#include <utility>
+#include <vector>
+
 namespace Dune
 {
     namespace cpgrid
@@ -46,6 +49,7 @@ namespace Dune
                                   const EntityVariable<cpgrid::Geometry<0, 3>, 3>& point_geom)
                 : cell_geom_(cell_geom), face_geom_(face_geom), point_geom_(point_geom)
             {
+                updateGeometryArrays();
             }
 
             /// @brief
@@ -60,14 +64,64 @@ namespace Dune
                 return geomVector(std::integral_constant<int,codim>());
             }
 
+            /// @brief Replace the geometries of the cells, faces and points.
+            ///
+            /// The contiguous arrays of volumes and centroids are refreshed
+            /// from them.  The cell geometries may refer to the corners in
+            /// point_geom, whose storage is taken over, not copied.
+            void setGeometries(EntityVariable<cpgrid::Geometry<3, 3>, 0>&& cell_geom,
+                               EntityVariable<cpgrid::Geometry<2, 3>, 1>&& face_geom,
+                               EntityVariable<cpgrid::Geometry<0, 3>, 3>&& point_geom)
+            {
+                cell_geom_ = std::move(cell_geom);
+                face_geom_ = std::move(face_geom);
+                point_geom_ = std::move(point_geom);
+                updateGeometryArrays();
+            }
+
+            /// \brief The volumes of all cells, indexed by cell.
+            const std::vector<double>& cellVolumes() const
+            {
+                return cell_volumes_;
+            }
+            /// \brief The centroids of all cells, indexed by cell.
+            const std::vector<FieldVector<double, 3> >& cellCentroids() const
+            {
+                return cell_centroids_;
+            }
+            /// \brief The areas of all faces, indexed by face.
+            const std::vector<double>& faceAreas() const
+            {
+                return face_areas_;
+            }
+            /// \brief The centroids of all faces, indexed by face.
+            const std::vector<FieldVector<double, 3> >& faceCentroids() const
+            {
+                return face_centroids_;
+            }
+
         private:
-            /// \brief Get cell geometry
-            const EntityVariable<cpgrid::Geometry<3, 3>, 0>& geomVector(const std::integral_constant<int, 0>&) const
+            // Refresh the contiguous arrays from the geometry objects.
+            void updateGeometryArrays()
             {
-                return cell_geom_;
+                const int nc = cell_geom_.size();
+                cell_volumes_.resize(nc);
+                cell_centroids_.resize(nc);
+                for (int c = 0; c < nc; ++c) {
+                    cell_volumes_[c] = cell_geom_.get(c).volume();
+                    cell_centroids_[c] = cell_geom_.get(c).center();
+                }
+                const int nf = face_geom_.size();
+                face_areas_.resize(nf);
+                face_centroids_.resize(nf);
+                for (int f = 0; f < nf; ++f) {
+                    face_areas_[f] = face_geom_.get(f).volume();
+                    face_centroids_[f] = face_geom_.get(f).center();
+                }
             }
+
             /// \brief Get cell geometry
-            EntityVariable<cpgrid::Geometry<3, 3>, 0>& geomVector(const std::integral_constant<int, 0>&)
+            const EntityVariable<cpgrid::Geometry<3, 3>, 0>& geomVector(const std::integral_constant<int, 0>&) const
             {
                 return cell_geom_;
             }
@@ -76,21 +130,10 @@ namespace Dune
             {
                 return face_geom_;
             }
-            /// \brief Get face geometry
-            EntityVariable<cpgrid::Geometry<2, 3>, 1>& geomVector(const std::integral_constant<int, 1>&)
-            {
-                return face_geom_;
-            }
 
             /// \brief Get point geometry
             template<int codim>
             const EntityVariable<cpgrid::Geometry<0, 3>, 3>& geomVector(const std::integral_constant<int, codim>&) const
-            {
-                static_assert(codim==3, "Codim has to be 3");
-                return point_geom_;
-            }/// \brief Get point geometry
-            template<int codim>
-            EntityVariable<cpgrid::Geometry<0, 3>, 3>& geomVector(const std::integral_constant<int, codim>&)
             {
                 static_assert(codim==3, "Codim has to be 3");
                 return point_geom_;
@@ -98,6 +141,14 @@ namespace Dune
             EntityVariable<cpgrid::Geometry<3, 3>, 0> cell_geom_;
             EntityVariable<cpgrid::Geometry<2, 3>, 1> face_geom_;
             EntityVariable<cpgrid::Geometry<0, 3>, 3> point_geom_;
+            // Copies of the cell and face volumes and centroids above, stored
+            // contiguously for kernels that sweep over all entities.  Only
+            // the constructor and setGeometries() change the geometries,
+            // and both refresh these.
+            std::vector<double> cell_volumes_;
+            std::vector<FieldVector<double, 3> > cell_centroids_;
+            std::vector<double> face_areas_;
+            std::vector<FieldVector<double, 3> > face_centroids_;
         };
 
     } // namespace cpgrid
@@ -0,0 +1,146 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "distributedpreprocess.hh"
+
+#include <ewoms/eclio/errormacros.hh>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace Dune
+{
+namespace cpgrid
+{
+
+namespace
+{
+    void collectSlab(void* ctx, const processed_slab* slab)
+    {
+        auto& grid = *static_cast<DistributedProcessedGrid*>(ctx);
+        const int nf = slab->number_of_faces;
+        const int nn = slab->number_of_nodes + slab->number_of_halo_nodes;
+
+        grid.face_ptr.assign(slab->face_ptr, slab->face_ptr + nf + 1);
+        grid.face_nodes.assign(slab->face_nodes, slab->face_nodes + slab->face_ptr[nf]);
+        grid.face_neighbors.assign(slab->face_neighbors, slab->face_neighbors + 2*nf);
+        grid.face_tags.assign(slab->face_tag, slab->face_tag + nf);
+
+        grid.number_of_nodes = slab->number_of_nodes;
+        grid.number_of_halo_nodes = slab->number_of_halo_nodes;
+        grid.node_coordinates.assign(slab->node_coordinates, slab->node_coordinates + 3*nn);
+
+        grid.global_cell.assign(slab->global_cell, slab->global_cell + slab->number_of_cells);
+    }
+
+    /// Exclusive prefix sum of a per-process count and its total.
+    template<class Comm>
+    std::array<int, 2> exclusivePrefixSum(int count, const Comm& comm)
+    {
+        std::vector<int> counts(comm.size());
+        comm.allgather(&count, 1, counts.data());
+
+        const auto first = std::accumulate(counts.begin(), counts.begin() + comm.rank(), 0);
+        return { first, std::accumulate(counts.begin(), counts.end(), 0) };
+    }
+}
+
+std::array<int, 2> ownedRows(int num_rows, int rank, int size)
+{
+    const auto split = [num_rows, size](int p) {
+        return static_cast<int>((static_cast<long long>(num_rows) * p) / size);
+    };
+
+    return { split(rank), split(rank + 1) };
+}
+
+std::array<int, 2> requiredRows(int num_rows, int rank, int size)
+{
+    const auto rows = ownedRows(num_rows, rank, size);
+
+    if (rows[0] == rows[1]) {
+        return rows;
+    }
+
+    return { std::max(rows[0] - 1, 0), std::min(rows[1] + 1, num_rows) };
+}
+
+DistributedProcessedGrid
+processDistributed(const grdecl& local, int num_rows, double z_tolerance,
+                   const CollectiveCommunication<MPIHelper::MPICommunicator>& comm,
+                   int num_threads)
+{
+    DistributedProcessedGrid grid;
+    grid.dimensions = { local.dims[0], num_rows, local.dims[2] };
+    grid.rows = ownedRows(num_rows, comm.rank(), comm.size());
+    grid.face_ptr.assign(1, 0);
+
+    const auto required = requiredRows(num_rows, comm.rank(), comm.size());
+    const bool empty = grid.rows[0] == grid.rows[1];
+
+    if (local.dims[1] != required[1] - required[0]) {
+        EWOMS_THROW(std::invalid_argument, "Process " << comm.rank() << " got "
+                    << local.dims[1] << " rows of cells, but requires the "
+                    << required[1] - required[0] << " rows "
+                    << required[0] << " to " << required[1] - 1);
+    }
+
+    // All blocks must use the same ZCORN sign and handedness to end up with
+    // consistently oriented faces. A block with decreasing ZCORN forces the
+    // sign of all of them; the handedness is taken from the lowest ranked
+    // process able to tell.
+    int error = 0;
+    const int sign = comm.min(empty ? 1 : grdecl_zcorn_sign(&local, &error));
+
+    const int no_handedness = std::numeric_limits<int>::max();
+    const int local_handedness = empty ? -1 : grdecl_is_lefthanded(&local, sign);
+    const int handedness = comm.min(local_handedness < 0 ? no_handedness
+                                    : 2*comm.rank() + local_handedness);
+    const int left_handed = (handedness == no_handedness) ? 0 : handedness % 2;
+
+    if (! empty) {
+        process_grdecl_rows(&local, required[0], num_rows, grid.rows[0], grid.rows[1],
+                            sign, left_handed, z_tolerance, num_threads,
+                            &collectSlab, &grid);
+    }
+
+    // Global ids follow from the counts of the preceding blocks. The halo
+    // nodes of this block are the first nodes of the next non-empty one.
+    const auto faces = exclusivePrefixSum(static_cast<int>(grid.face_tags.size()), comm);
+    const auto nodes = exclusivePrefixSum(grid.number_of_nodes, comm);
+
+    grid.first_face = faces[0];
+    grid.global_number_of_faces = faces[1];
+    grid.first_node = nodes[0];
+    grid.global_number_of_nodes = nodes[1];
+
+    for (auto& node : grid.face_nodes) {
+        node += grid.first_node;
+    }
+
+    return grid;
+}
+
+} // end namespace cpgrid
+} // end namespace Dune
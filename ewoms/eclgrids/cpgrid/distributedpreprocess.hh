@@ -0,0 +1,124 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EWOMS_DISTRIBUTEDPREPROCESS_HEADER
+#define EWOMS_DISTRIBUTEDPREPROCESS_HEADER
+
+#include <ewoms/eclgrids/cpgpreprocess/preprocess.h>
+
+#include <dune/common/parallel/collectivecommunication.hh>
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <array>
+#include <vector>
+
+namespace Dune
+{
+namespace cpgrid
+{
+
+/// \brief The part of a corner-point grid processed by one process.
+///
+/// The grid is split into blocks of rows of cells along the J axis. Each
+/// process owns the faces and nodes of its block, and faces crossing the
+/// boundary between two blocks are owned by the upper one. Faces and nodes
+/// carry globally consistent ids, cells are identified by their global
+/// Cartesian index.
+///
+/// This is the topology of the block only. No CpGridData is built from it
+/// yet, a parallel CpGrid is still processed on rank 0 and distributed by
+/// CpGrid::scatterGrid().
+struct DistributedProcessedGrid
+{
+    /// Cartesian dimensions of the global grid.
+    std::array<int, 3> dimensions;
+    /// First and one past the last row of cells owned.
+    std::array<int, 2> rows;
+
+    /// Global id of the first owned face.
+    int first_face = 0;
+    /// Total number of faces of the global grid.
+    int global_number_of_faces = 0;
+    /// Start position of each owned face's nodes in face_nodes.
+    std::vector<int> face_ptr;
+    /// Global ids of the nodes of each owned face.
+    std::vector<int> face_nodes;
+    /// Global Cartesian indices of the two cells of each owned face, -1
+    /// on the boundary of the domain.
+    std::vector<int> face_neighbors;
+    /// Classification of the owned faces.
+    std::vector<face_tag> face_tags;
+
+    /// Global id of the first owned node.
+    int first_node = 0;
+    /// Number of nodes owned. The owned nodes have the consecutive global
+    /// ids [first_node, first_node + number_of_nodes).
+    int number_of_nodes = 0;
+    /// Number of nodes referenced by owned faces but owned by the next
+    /// process. These have global ids following the owned ones.
+    int number_of_halo_nodes = 0;
+    /// Total number of nodes of the global grid.
+    int global_number_of_nodes = 0;
+    /// Coordinates of the owned nodes followed by those of the halo nodes.
+    std::vector<double> node_coordinates;
+
+    /// Global Cartesian indices of the owned active cells, increasing.
+    std::vector<int> global_cell;
+};
+
+/// \brief The rows of cells along the J axis owned by a process.
+/// \param num_rows The number of rows of the global grid.
+/// \param rank The rank of the process.
+/// \param size The number of processes.
+/// \return The first and one past the last row owned.
+std::array<int, 2> ownedRows(int num_rows, int rank, int size);
+
+/// \brief The rows of cells along the J axis a process needs to read.
+///
+/// These are the owned rows plus one halo row on either side.
+/// \param num_rows The number of rows of the global grid.
+/// \param rank The rank of the process.
+/// \param size The number of processes.
+/// \return The first and one past the last row required.
+std::array<int, 2> requiredRows(int num_rows, int rank, int size);
+
+/// \brief Preprocess the rows of a corner-point grid owned by this process.
+///
+/// Every process passes only the COORD, ZCORN and ACTNUM data of its
+/// requiredRows(), such that no process holds the complete corner-point
+/// input or processed grid during this step. The processes agree on the
+/// ZCORN sign and the handedness of the coordinate system and establish
+/// the global face and node ids through a prefix sum of their counts.
+/// NNCs, MINPV and PINCH are not handled, and neither are geometry,
+/// overlap cells or the index sets of a distributed grid.
+/// \param local The required rows of the grid. local.dims[1] is the number
+///              of required rows.
+/// \param num_rows The number of rows of the global grid.
+/// \param z_tolerance Absolute tolerance of node-coincidence.
+/// \param comm The communicator of the participating processes.
+/// \param num_threads Number of threads used for the local processing. Non-
+///                    positive values select the OpenMP default.
+DistributedProcessedGrid
+processDistributed(const grdecl& local, int num_rows, double z_tolerance,
+                   const CollectiveCommunication<MPIHelper::MPICommunicator>& comm,
+                   int num_threads = 0);
+
+} // end namespace cpgrid
+} // end namespace Dune
+
+#endif // EWOMS_DISTRIBUTEDPREPROCESS_HEADER
@@ -36,11 +36,136 @@
 
 #include <ewoms/eclio/errormacros.hh>
 
+#include <vector>
+
 namespace Dune
 {
     namespace cpgrid
     {
 
+        /// The trilinear mapping of a hexahedral cell from the unit cube,
+        /// in monomial form
+        ///   g(u, v, w) = a0 + a1 u + a2 v + a3 w + a4 uv + a5 uw + a6 vw + a7 uvw.
+        /// The coefficients are computed once from the eight corners, such
+        /// that many points can be mapped to and from the same cell cheaply.
+        class TrilinearMap
+        {
+        public:
+            typedef FieldVector<double, 3> LocalCoordinate;
+            typedef FieldVector<double, 3> GlobalCoordinate;
+            typedef FieldMatrix<double, 3, 3> JacobianTransposed;
+
+            /// Default number of Newton iterations of local().
+            enum { default_max_iterations = 20 };
+
+            /// Default constructor, giving the zero mapping.
+            TrilinearMap()
+            {
+                for (auto& a : a_) {
+                    a = 0.0;
+                }
+            }
+
+            /// @brief Construct from the corners of a cell.
+            /// @param corners the 8 corners, in lexicographical order
+            ///                by (kji), i.e. i running fastest.
+            explicit TrilinearMap(const GlobalCoordinate* corners)
+            {
+                const GlobalCoordinate* c = corners;
+                a_[0] = c[0];
+                a_[1] = c[1] - c[0];
+                a_[2] = c[2] - c[0];
+                a_[3] = c[4] - c[0];
+                a_[4] = c[3] - c[2] - c[1] + c[0];
+                a_[5] = c[5] - c[4] - c[1] + c[0];
+                a_[6] = c[6] - c[4] - c[2] + c[0];
+                a_[7] = c[7] - c[6] - c[5] + c[4] - c[3] + c[2] + c[1] - c[0];
+            }
+
+            GlobalCoordinate global(const LocalCoordinate& x) const
+            {
+                const double u = x[0], v = x[1], w = x[2];
+                GlobalCoordinate y = a_[0];
+                y.axpy(u, a_[1]);
+                y.axpy(v, a_[2]);
+                y.axpy(w, a_[3]);
+                y.axpy(u*v, a_[4]);
+                y.axpy(u*w, a_[5]);
+                y.axpy(v*w, a_[6]);
+                y.axpy(u*v*w, a_[7]);
+                return y;
+            }
+
+            /// J^T_{ij} = (dg_j/du_i).
+            JacobianTransposed jacobianTransposed(const LocalCoordinate& x) const
+            {
+                const double u = x[0], v = x[1], w = x[2];
+                JacobianTransposed Jt;
+                Jt[0] = a_[1];
+                Jt[0].axpy(v, a_[4]);
+                Jt[0].axpy(w, a_[5]);
+                Jt[0].axpy(v*w, a_[7]);
+                Jt[1] = a_[2];
+                Jt[1].axpy(u, a_[4]);
+                Jt[1].axpy(w, a_[6]);
+                Jt[1].axpy(u*w, a_[7]);
+                Jt[2] = a_[3];
+                Jt[2].axpy(u, a_[5]);
+                Jt[2].axpy(v, a_[6]);
+                Jt[2].axpy(u*v, a_[7]);
+                return Jt;
+            }
+
+            /// @brief Map a point to the unit cube by Newton's method.
+            /// Starting from the centre of the cube, the first step maps
+            /// the point exactly for cells that are parallelepipeds.
+            /// @param y the point to map
+            /// @param x the local coordinates of y on return
+            /// @param max_iterations the maximal number of Newton steps
+            /// @return true if the iteration converged, false if it did not
+            ///         within max_iterations steps or hit a singular Jacobian.
+            bool local(const GlobalCoordinate& y, LocalCoordinate& x,
+                       int max_iterations = default_max_iterations) const
+            {
+                const double epsilon = 1e-12;
+                x = 0.5;
+                for (int it = 0; it < max_iterations; ++it) {
+                    // Solve J dx = g(x) - y by Cramer's rule, where the
+                    // columns of J are the rows of Jt.
+                    const JacobianTransposed Jt = jacobianTransposed(x);
+                    GlobalCoordinate r = global(x);
+                    r -= y;
+                    const GlobalCoordinate c12 = cross(Jt[1], Jt[2]);
+                    const double det = Jt[0]*c12;
+                    if (det == 0.0) {
+                        return false;
+                    }
+                    LocalCoordinate dx;
+                    dx[0] = r*c12;
+                    dx[1] = r*cross(Jt[2], Jt[0]);
+                    dx[2] = r*cross(Jt[0], Jt[1]);
+                    dx /= det;
+                    x -= dx;
+                    if (dx.two_norm2() <= epsilon*epsilon) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            static GlobalCoordinate cross(const GlobalCoordinate& a, const GlobalCoordinate& b)
+            {
+                GlobalCoordinate c;
+                c[0] = a[1]*b[2] - a[2]*b[1];
+                c[1] = a[2]*b[0] - a[0]*b[2];
+                c[2] = a[0]*b[1] - a[1]*b[0];
+                return c;
+            }
+
+            GlobalCoordinate a_[8];
+        };
+
         /// This class encapsulates geometry for both vertices,
         /// intersections and cells.  The main template is empty,
         /// the actual dim == 3 (cell), dim == 2 (intersection)
@@ -288,32 +413,53 @@ namespace Dune
                 return xyz;
             }
 
+            /// The coefficients of the trilinear mapping of global().
+            /// Callers mapping many points in one cell may keep it
+            /// rather than going through the corners for each point.
+            TrilinearMap trilinearMap() const
+            {
+                GlobalCoordinate c[8];
+                for (int i = 0; i < 8; ++i) {
+                    c[i] = corner(i);
+                }
+                return TrilinearMap(c);
+            }
+
             /// Mapping from the cell to the reference domain.
-            /// May be slow.
+            /// If the Newton iteration does not converge, the last
+            /// iterate is returned, see the other overloads.
             LocalCoordinate local(const GlobalCoordinate& y) const
+            {
+                LocalCoordinate x;
+                local(y, x);
+                return x;
+            }
+
+            /// Mapping from the cell to the reference domain.
+            /// @param y the point to map
+            /// @param x the local coordinates of y on return
+            /// @return whether the Newton iteration converged.
+            bool local(const GlobalCoordinate& y, LocalCoordinate& x) const
             {
                 static_assert(mydimension == 3, "");
                 static_assert(coorddimension == 3, "");
-                // This code is modified from dune/grid/genericgeometry/mapping.hh
-                // \todo: Implement direct computation.
-                const ctype epsilon = 1e-12;
-#if DUNE_VERSION_NEWER(DUNE_GEOMETRY, 2, 6)
-                auto refElement = Dune::ReferenceElements<ctype, 3>::cube();
-#else
-                const ReferenceElement< ctype , 3 > & refElement =
-                    ReferenceElements< ctype, 3 >::general(type());
-#endif
-                LocalCoordinate x = refElement.position(0,0);
-                LocalCoordinate dx;
-                do {
-                    // DF^n dx^n = F^n, x^{n+1} -= dx^n
-                    JacobianTransposed JT = jacobianTransposed(x);
-                    GlobalCoordinate z = global(x);
-                    z -= y;
-                    MatrixHelperType::template xTRightInvA<3, 3>(JT, z, dx );
-                    x -= dx;
-                } while (dx.two_norm2() > epsilon*epsilon);
-                return x;
+                return trilinearMap().local(y, x);
+            }
+
+            /// Mapping of many points from the cell to the reference domain,
+            /// the trilinear coefficients are only computed once.
+            /// @param y the points to map
+            /// @param x the local coordinates of the points on return
+            /// @return whether the Newton iteration converged for all points.
+            bool local(const std::vector<GlobalCoordinate>& y, std::vector<LocalCoordinate>& x) const
+            {
+                const TrilinearMap map = trilinearMap();
+                x.resize(y.size());
+                bool converged = true;
+                for (std::size_t i = 0; i < y.size(); ++i) {
+                    converged = map.local(y[i], x[i]) && converged;
+                }
+                return converged;
             }
 
             /// Equal to \sqrt{\det{J^T J}} where J is the Jacobian.
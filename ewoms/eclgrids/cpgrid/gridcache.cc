@@ -0,0 +1,294 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <ewoms/eclio/errormacros.hh>
+#include "cpgriddata.hh"
+
+namespace Dune
+{
+
+    namespace
+    {
+        // The file starts with the magic and version, followed by the
+        // sizes of the basic types, a byte order mark and the key of
+        // the input.  The arrays follow, each preceded by its length.
+        const char cache_magic[8] = { 'E', 'W', 'C', 'P', 'G', 'R', 'I', 'D' };
+        const std::int32_t cache_version = 1;
+        const std::int32_t cache_byte_order = 0x01020304;
+
+        struct CacheHeader
+        {
+            char magic[8];
+            std::int32_t version;
+            std::int32_t int_size;
+            std::int32_t double_size;
+            std::int32_t byte_order;
+            std::uint64_t key;
+            std::int32_t dims[3];
+            // Written as zero, so that the same grid gives the same file.
+            std::int32_t padding;
+        };
+
+        template <typename T>
+        void writeArray(std::ostream& os, const std::vector<T>& v)
+        {
+            const std::uint64_t n = v.size();
+            os.write(reinterpret_cast<const char*>(&n), sizeof n);
+            os.write(reinterpret_cast<const char*>(v.data()), n * sizeof(T));
+        }
+
+        template <typename T>
+        bool readArray(std::istream& is, std::vector<T>& v)
+        {
+            std::uint64_t n = 0;
+            if (!is.read(reinterpret_cast<char*>(&n), sizeof n)) {
+                return false;
+            }
+            // Guard against truncated files before allocating.
+            const auto pos = is.tellg();
+            is.seekg(0, std::ios::end);
+            const auto remaining = static_cast<std::uint64_t>(is.tellg() - pos);
+            is.seekg(pos);
+            if (n > remaining / sizeof(T)) {
+                return false;
+            }
+            v.resize(n);
+            return bool(is.read(reinterpret_cast<char*>(v.data()), n * sizeof(T)));
+        }
+
+        bool rowSizesMatch(const std::vector<int>& sizes, std::size_t data_size)
+        {
+            for (int s : sizes) {
+                if (s < 0) {
+                    return false;
+                }
+            }
+            return std::accumulate(sizes.begin(), sizes.end(), std::size_t(0)) == data_size;
+        }
+
+        bool indicesBelow(const std::vector<int>& indices, std::size_t n)
+        {
+            for (int i : indices) {
+                if (i < 0 || std::size_t(i) >= n) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } // anon namespace
+
+    /// Read a grid written by writeGridCache() with the given key.
+    bool cpgrid::CpGridData::readGridCache(const std::string& filename, std::uint64_t key)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        CacheHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof header)
+            || !std::equal(cache_magic, cache_magic + 8, header.magic)
+            || header.version != cache_version
+            || header.int_size != sizeof(int)
+            || header.double_size != sizeof(double)
+            || header.byte_order != cache_byte_order
+            || header.key != key) {
+            return false;
+        }
+
+        std::vector<int> global_cell, c2f_sizes, c2f_data, f2p_sizes, f2p_data, c2p, tags;
+        std::vector<double> points, normals, face_centroids, face_areas, cell_centroids, cell_volumes;
+        if (!readArray(file, global_cell) || !readArray(file, c2f_sizes) || !readArray(file, c2f_data)
+            || !readArray(file, f2p_sizes) || !readArray(file, f2p_data) || !readArray(file, c2p)
+            || !readArray(file, tags) || !readArray(file, points) || !readArray(file, normals)
+            || !readArray(file, face_centroids) || !readArray(file, face_areas)
+            || !readArray(file, cell_centroids) || !readArray(file, cell_volumes)) {
+            return false;
+        }
+
+        // Check consistency, such that a damaged file is rejected
+        // rather than producing a broken grid.
+        const std::size_t nc = global_cell.size();
+        const std::size_t nf = tags.size();
+        const std::size_t np = points.size() / 3;
+        if (c2f_sizes.size() != nc || !rowSizesMatch(c2f_sizes, c2f_data.size())
+            || f2p_sizes.size() != nf || !rowSizesMatch(f2p_sizes, f2p_data.size())
+            || !indicesBelow(f2p_data, np) || c2p.size() != 8*nc || !indicesBelow(c2p, np)
+            || points.size() != 3*np || normals.size() != 3*nf || face_centroids.size() != 3*nf
+            || face_areas.size() != nf || cell_centroids.size() != 3*nc || cell_volumes.size() != nc) {
+            return false;
+        }
+        std::vector<cpgrid::EntityRep<1>> c2f_reps;
+        c2f_reps.reserve(c2f_data.size());
+        for (int rep : c2f_data) {
+            const bool orientation = rep >= 0;
+            const int face = orientation ? rep : ~rep;
+            if (std::size_t(face) >= nf) {
+                return false;
+            }
+            c2f_reps.emplace_back(face, orientation);
+        }
+
+        // Topology.
+        std::copy(header.dims, header.dims + 3, logical_cartesian_size_.begin());
+        global_cell_.swap(global_cell);
+        cell_to_face_ = cpgrid::OrientedEntityTable<0, 1>(c2f_reps.begin(), c2f_reps.end(),
+                                                          c2f_sizes.begin(), c2f_sizes.end());
+        cell_to_face_.makeInverseRelation(face_to_cell_);
+        face_to_point_ = Ewoms::SparseTable<int>(f2p_data.begin(), f2p_data.end(),
+                                                 f2p_sizes.begin(), f2p_sizes.end());
+        cell_to_point_.resize(nc);
+        for (std::size_t c = 0; c < nc; ++c) {
+            std::copy(c2p.begin() + 8*c, c2p.begin() + 8*(c + 1), cell_to_point_[c].begin());
+        }
+        std::vector<enum face_tag> face_tags(nf);
+        for (std::size_t f = 0; f < nf; ++f) {
+            face_tags[f] = static_cast<enum face_tag>(tags[f]);
+        }
+        face_tag_.assign(face_tags.begin(), face_tags.end());
+
+        // Geometry.  The cells refer to the corners, so these go first.
+        typedef FieldVector<double, 3> point_t;
+        auto point = [](const std::vector<double>& v, std::size_t i) {
+            return point_t{ v[3*i], v[3*i + 1], v[3*i + 2] };
+        };
+        cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3> point_geom;
+        cpgrid::EntityVariable<cpgrid::Geometry<2, 3>, 1> face_geom;
+        cpgrid::EntityVariable<cpgrid::Geometry<3, 3>, 0> cell_geom;
+        point_geom.reserve(np);
+        for (std::size_t i = 0; i < np; ++i) {
+            point_geom.push_back(cpgrid::Geometry<0, 3>(point(points, i)));
+        }
+        face_geom.reserve(nf);
+        std::vector<point_t> face_normals;
+        face_normals.reserve(nf);
+        for (std::size_t f = 0; f < nf; ++f) {
+            face_geom.push_back(cpgrid::Geometry<2, 3>(point(face_centroids, f), face_areas[f]));
+            face_normals.push_back(point(normals, f));
+        }
+        face_normals_.assign(face_normals.begin(), face_normals.end());
+        cell_geom.reserve(nc);
+        for (std::size_t c = 0; c < nc; ++c) {
+            cell_geom.push_back(cpgrid::Geometry<3, 3>(point(cell_centroids, c), cell_volumes[c],
+                                                       point_geom, &cell_to_point_[c][0]));
+        }
+        geometry_.setGeometries(std::move(cell_geom), std::move(face_geom), std::move(point_geom));
+        resetCellNeighborGraph();
+        return true;
+    }
+
+    /// Write the grid, such that readGridCache() can restore it.
+    void cpgrid::CpGridData::writeGridCache(const std::string& filename, std::uint64_t key) const
+    {
+        CacheHeader header{};
+        std::copy(cache_magic, cache_magic + 8, header.magic);
+        header.version = cache_version;
+        header.int_size = sizeof(int);
+        header.double_size = sizeof(double);
+        header.byte_order = cache_byte_order;
+        header.key = key;
+        std::copy(logical_cartesian_size_.begin(), logical_cartesian_size_.end(), header.dims);
+
+        const int nc = cell_to_face_.size();
+        const int nf = face_to_cell_.size();
+        std::vector<int> c2f_sizes, c2f_data, f2p_sizes, f2p_data, c2p, tags;
+        c2f_sizes.reserve(nc);
+        for (int c = 0; c < nc; ++c) {
+            const auto row = cell_to_face_[cpgrid::EntityRep<0>(c, true)];
+            c2f_sizes.push_back(row.size());
+            for (int j = 0; j < row.size(); ++j) {
+                c2f_data.push_back(row[j].orientation() ? row[j].index() : ~row[j].index());
+            }
+        }
+        f2p_sizes.reserve(nf);
+        f2p_data.reserve(face_to_point_.dataSize());
+        for (int f = 0; f < nf; ++f) {
+            f2p_sizes.push_back(face_to_point_.rowSize(f));
+            f2p_data.insert(f2p_data.end(), face_to_point_[f].begin(), face_to_point_[f].end());
+        }
+        c2p.reserve(8*nc);
+        for (const auto& corners : cell_to_point_) {
+            c2p.insert(c2p.end(), corners.begin(), corners.end());
+        }
+        tags.assign(face_tag_.begin(), face_tag_.end());
+
+        std::vector<double> points, normals, face_centroids, face_areas, cell_centroids, cell_volumes;
+        const auto& point_geom = geometry_.geomVector(std::integral_constant<int,3>());
+        const auto& face_geom = geometry_.geomVector(std::integral_constant<int,1>());
+        const auto& cell_geom = geometry_.geomVector(std::integral_constant<int,0>());
+        for (const auto& p : point_geom) {
+            points.insert(points.end(), p.center().begin(), p.center().end());
+        }
+        for (int f = 0; f < nf; ++f) {
+            const auto& n = face_normals_.get(f);
+            normals.insert(normals.end(), n.begin(), n.end());
+            face_centroids.insert(face_centroids.end(), face_geom.get(f).center().begin(),
+                                  face_geom.get(f).center().end());
+            face_areas.push_back(face_geom.get(f).volume());
+        }
+        for (const auto& g : cell_geom) {
+            cell_centroids.insert(cell_centroids.end(), g.center().begin(), g.center().end());
+            cell_volumes.push_back(g.volume());
+        }
+
+        // Write to a file of our own and move it into place, such
+        // that concurrent runs never see a partially written cache.
+        const std::string tmpname = filename + "." + std::to_string(std::random_device{}()) + ".tmp";
+        {
+            std::ofstream file(tmpname.c_str(), std::ios::binary);
+            file.write(reinterpret_cast<const char*>(&header), sizeof header);
+            writeArray(file, global_cell_);
+            writeArray(file, c2f_sizes);
+            writeArray(file, c2f_data);
+            writeArray(file, f2p_sizes);
+            writeArray(file, f2p_data);
+            writeArray(file, c2p);
+            writeArray(file, tags);
+            writeArray(file, points);
+            writeArray(file, normals);
+            writeArray(file, face_centroids);
+            writeArray(file, face_areas);
+            writeArray(file, cell_centroids);
+            writeArray(file, cell_volumes);
+            if (!file) {
+                EWOMS_MESSAGE("Warning: Could not write grid cache file " << tmpname);
+                file.close();
+                std::remove(tmpname.c_str());
+                return;
+            }
+        }
+        if (std::rename(tmpname.c_str(), filename.c_str()) != 0) {
+            EWOMS_MESSAGE("Warning: Could not write grid cache file " << filename);
+            std::remove(tmpname.c_str());
+        }
+    }
+
+} // namespace Dune
@@ -35,12 +35,11 @@ Intersection::Intersection(const CpGridData& grid, const EntityRep<0>& cell, int
                   index_(cell.index()),
                   subindex_(subindex),
                   faces_of_cell_(grid.cell_to_face_[cell]),
-                  global_geom_(cpgrid::Entity<1>(grid, faces_of_cell_[subindex_]).geometry()),
+                  global_geom_(nullptr),
 //                   in_inside_geom_(global_geom_.center()
 //                                   - cpgrid::Entity<0>(grid, index_).geometry().center(),
 //                                   global_geom_.volume()),
-                  nbcell_(cell.index()), // Init to self, which is invalid.
-                  is_on_boundary_(false)
+                  cells_of_face_()
             {
                 assert(index_ >= 0);
                 if (update_now) {
@@ -101,28 +100,11 @@ int Intersection::boundarySegmentIndex() const
 void Intersection::update()
             {
                 const EntityRep<1>& face = faces_of_cell_[subindex_];
-                //global_geom_ = cpgrid::Entity<1>(*pgrid_, face).geometry();
-                global_geom_ = pgrid_->geometry_.geomVector<1>()[face];
-                OrientedEntityTable<1,0>::row_type cells_of_face = pgrid_->face_to_cell_[face];
-                is_on_boundary_ = cells_of_face.size() == 1;
-                // Wether there is no nother nbcell for this intersection
-                // i.e. either this on the boundary or a front intersection
-                bool has_no_nbcell = is_on_boundary_ ||
-                    cells_of_face[0].index()==std::numeric_limits<int>::max() ||
-                    cells_of_face[1].index()==std::numeric_limits<int>::max();
-                if (has_no_nbcell) {
-                    nbcell_ = std::numeric_limits<int>::max(); // neighbor is not within this process
-                } else {
-                    assert(cells_of_face.size() == 2);
-                    if (cells_of_face[0].index() == index_) {
-                        nbcell_ = cells_of_face[1].index();
-                    } else {
-                        nbcell_ = cells_of_face[0].index();
-                    }
-//                     in_outside_geom_ = LocalGeometry(global_geom_.center()
-//                                                      - outside().geometry().center(),
-//                                                      global_geom_.volume());
-                }
+                // Refer to the face geometry of the grid instead of copying it.
+                global_geom_ = &pgrid_->geometry_.geomVector<1>()[face];
+                // Only remember the cells of the face, boundary(), neighbor()
+                // and outside() decide from them when they are asked.
+                cells_of_face_ = pgrid_->face_to_cell_[face];
             }
 
 void Intersection::increment()
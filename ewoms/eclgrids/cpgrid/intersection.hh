@@ -69,10 +69,9 @@ namespace Dune
                   index_(-1),
                   subindex_(-1),
                   faces_of_cell_(),
-                  global_geom_(),
+                  global_geom_(nullptr),
 //                   in_inside_geom_(),
-                  nbcell_(-1), // Init to self, which is invalid.
-                  is_on_boundary_(false)
+                  cells_of_face_()
             {
             }
             /// @brief
@@ -104,7 +103,7 @@ namespace Dune
             /// @return
             bool boundary() const
             {
-                return is_on_boundary_;
+                return cells_of_face_.size() == 1;
             }
 
             /// Returns the boundary id of this intersection.
@@ -118,7 +117,10 @@ namespace Dune
             /// @return
             bool neighbor() const
             {
-                return !boundary() && nbcell_!=std::numeric_limits<int>::max();
+                // A neighbour outside this process is marked by int max.
+                return cells_of_face_.size() == 2
+                    && cells_of_face_[0].index() != std::numeric_limits<int>::max()
+                    && cells_of_face_[1].index() != std::numeric_limits<int>::max();
             }
 
             /// @brief
@@ -169,7 +171,7 @@ namespace Dune
             /// @return
             const Geometry& geometry() const
             {
-                return global_geom_;
+                return *global_geom_;
             }
 
             /// @brief
@@ -231,11 +233,14 @@ namespace Dune
             int index_;
             int subindex_;
             OrientedEntityTable<0,1>::row_type faces_of_cell_;
-            Geometry global_geom_;
+            // Points into the face geometries of the grid, which
+            // outlive the intersection.
+            const Geometry* global_geom_;
 //             LocalGeometry in_inside_geom_;
 //             LocalGeometry in_outside_geom_;
-            int nbcell_;
-            bool is_on_boundary_;
+            // The cells of the current face, kept so that the
+            // neighbourhood queries are only evaluated when asked.
+            OrientedEntityTable<1,0>::row_type cells_of_face_;
 
             void increment();
 
@@ -253,12 +258,13 @@ namespace Dune
 
             int nbcell() const
             {
-                if (is_on_boundary_) {
+                if (boundary()) {
                     EWOMS_THROW(std::runtime_error, "There is no outside cell, intersection is at boundary.");
                 }
-                if(nbcell_==std::numeric_limits<int>::max())
+                if (!neighbor())
                     EWOMS_THROW(std::runtime_error, "There is no outside cell, intersection is at processor boundary.");
-                return nbcell_;
+                return cells_of_face_[0].index() == index_
+                    ? cells_of_face_[1].index() : cells_of_face_[0].index();
             }
         };
 
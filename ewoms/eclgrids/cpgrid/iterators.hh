@@ -23,6 +23,9 @@
 #include "partitioniteratorrule.hh"
 #include <ewoms/eclio/errormacros.hh>
 
+#include <algorithm>
+#include <vector>
+
 namespace Dune
 {
     namespace cpgrid
@@ -43,23 +46,48 @@ namespace Dune
             Iterator(const CpGridData& grid, int index, bool orientation);
 
             /// Increment operator.
-            /// Implementation note: This class is a friend of
-            /// \see EntityRep (which is a private base class of
-            /// Entity) in order to actually access the private
-            /// variable entityrep_. We may want to change EntityRep,
-            /// then this must change, too.
+            /// On parallel grids, the cells and points of the interior,
+            /// interior and border, and overlap partitions are taken from
+            /// the lists kept by the grid, instead of testing every entity
+            /// with PartitionIteratorRule.  Other entities of parallel
+            /// grids are still tested.
             Iterator& operator++()
             {
-                EntityRep<cd>::increment();
-                if(rule_.fullSet || rule_.emptySet)
-                    return *this;
-                while(this->index()<noEntities_ && rule_.isInvalid(*this))
+                if(!entities_)
+                {
                     EntityRep<cd>::increment();
+                    if(use_rule_)
+                        skipInvalid();
+                    return *this;
+                }
+                ++position_;
+                setPosition();
                 return *this;
             }
         private:
+            /// \brief Move to the next entity accepted by the rule, or to the end.
+            void skipInvalid()
+            {
+                while(this->index()<noEntities_ && rule_.isInvalid(*this))
+                    EntityRep<cd>::increment();
+            }
+
+            /// \brief Move to the entity at position_ in entities_, or to the end.
+            void setPosition()
+            {
+                const int index = position_ < static_cast<int>(entities_->size()) ?
+                    (*entities_)[position_] : noEntities_;
+                EntityRep<cd>::setValue(index, this->orientation());
+            }
+
             /// \brief The number of Entities with codim cd.
             int noEntities_;
+            /// \brief The entities of the partition, or null if there is no list.
+            const std::vector<int>* entities_;
+            /// \brief The position of the current entity in entities_.
+            int position_;
+            /// \brief Whether entities not in a list are tested with rule_.
+            bool use_rule_;
             PartitionIteratorRule<pitype> rule_;
         };
 
@@ -125,13 +153,26 @@ Iterator<cd, pitype>::Iterator(const CpGridData& grid, int index, bool orientati
                         // If the partition is empty, goto to end iterator!
                         EntityRep<cd>(PartitionIteratorRule<pitype>::emptySet?grid.size(cd):index,
                                       orientation)),
-      noEntities_(grid.size(cd))
+      noEntities_(grid.size(cd)), entities_(nullptr), position_(0), use_rule_(false)
 {
-    if(rule_.fullSet || rule_.emptySet)
+    if(PartitionIteratorRule<pitype>::fullSet || PartitionIteratorRule<pitype>::emptySet)
         return;
 
-    while(this->index()<noEntities_ && rule_.isInvalid(*this))
-        EntityRep<cd>::increment();
+    entities_ = grid.partitionEntities(cd, pitype);
+    if(!entities_)
+    {
+        // The grid keeps lists of the cells of a partition if and only if
+        // it is parallel.  On sequential grids all entities are interior,
+        // and none needs to be tested.
+        use_rule_ = grid.partitionEntities(0, pitype) != nullptr;
+        if(use_rule_)
+            skipInvalid();
+        return;
+    }
+    // Start at the first entity of the partition at or after index.
+    position_ = std::lower_bound(entities_->begin(), entities_->end(), this->index())
+        - entities_->begin();
+    setPosition();
 }
 }}
 
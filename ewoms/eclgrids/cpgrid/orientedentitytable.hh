@@ -20,9 +20,16 @@
 #define EWOMS_ORIENTEDENTITYTABLE_HEADER
 
 #include "entityrep.hh"
-#include <ewoms/eclgrids/utility/sparsetable.hh>
+#include <ewoms/eclgrids/utility/compactsparsetable.hh>
 #include <map>
 #include <climits>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 /// The namespace Dune is the main namespace for all Dune code.
 namespace Dune
@@ -33,12 +40,12 @@ namespace Dune
         /// @brief A class used as a row type for  OrientedEntityTable.
         /// @tparam codim_to Codimension.
         template <int codim_to>
-        class OrientedEntityRange : private Ewoms::SparseTable< EntityRep<codim_to> >::row_type
+        class OrientedEntityRange : private Ewoms::CompactSparseTable< EntityRep<codim_to> >::row_type
         {
         public:
             typedef EntityRep<codim_to> ToType;
             typedef ToType* ToTypePtr;
-            typedef typename Ewoms::SparseTable<ToType>::row_type R;
+            typedef typename Ewoms::CompactSparseTable<ToType>::row_type R;
 
             /// @brief Default constructor yielding an empty range.
             OrientedEntityRange()
@@ -71,12 +78,12 @@ namespace Dune
         /// @brief A class used as a row type for  OrientedEntityTable.
         /// @tparam codim_to Codimension.
         template <int codim_to>
-        class MutableOrientedEntityRange : private Ewoms::SparseTable< EntityRep<codim_to> >::mutable_row_type
+        class MutableOrientedEntityRange : private Ewoms::CompactSparseTable< EntityRep<codim_to> >::mutable_row_type
         {
         public:
             typedef EntityRep<codim_to> ToType;
             typedef ToType* ToTypePtr;
-            typedef typename Ewoms::SparseTable<ToType>::mutable_row_type R;
+            typedef typename Ewoms::CompactSparseTable<ToType>::mutable_row_type R;
 
             /// @brief Default constructor yielding an empty range.
             MutableOrientedEntityRange()
@@ -111,18 +118,21 @@ namespace Dune
         ///
         /// The purpose of this class is to hide the intricacies of
         /// handling orientations from the client code, otherwise a
-        /// straight Ewoms::SparseTable would do.
+        /// straight Ewoms::SparseTable would do.  The relation is kept
+        /// in an Ewoms::CompactSparseTable, since the rows of the grid
+        /// topology are short and the row bookkeeping would otherwise
+        /// take a large share of its memory.
         /// @tparam codim_from Codimension of domain of relation mapping
         /// @tparam codim_to Codimension of range of relation mapping
         template <int codim_from, int codim_to>
-        class OrientedEntityTable : private Ewoms::SparseTable< EntityRep<codim_to> >
+        class OrientedEntityTable : private Ewoms::CompactSparseTable< EntityRep<codim_to> >
         {
             friend class CpGridData;
         public:
             typedef EntityRep<codim_from> FromType;
             typedef EntityRep<codim_to> ToType;
             typedef OrientedEntityRange<codim_to> row_type; // ??? doxygen henter doc fra Ewoms::SparseTable
-            typedef Ewoms::SparseTable<ToType> super_t;
+            typedef Ewoms::CompactSparseTable<ToType> super_t;
             typedef typename super_t::mutable_row_type mutable_row_type;
 
             /// Default constructor.
@@ -134,7 +144,7 @@ namespace Dune
             /// data and a sequence of row size data.
             ///
             /// These table data are in the same format as the underlying
-            /// Ewoms::SparseTable<int> constructor with the same signature.
+            /// Ewoms::CompactSparseTable constructor with the same signature.
             /// @tparam DataIter Iterator to table data.
             /// @tparam IntegerIter Iterator to  the row length data.
             /// @param data_beg The start of the table data.
@@ -154,6 +164,7 @@ namespace Dune
             using super_t::clear;
             using super_t::appendRow;
             using super_t::allocate;
+            using super_t::reserve;
 
             /// @brief Given an entity e of codimension codim_from,
             /// returns the number of neighbours of codimension codim_to.
@@ -279,62 +290,133 @@ namespace Dune
             /// @brief Makes the inverse relation, mapping codim_to entities
             /// to their codim_from neighbours.
             ///
-            /// Implementation note: The algorithm has been changed
-            /// to a three-pass O(n) algorithm.
+            /// Implementation note: The rows of this table are split into
+            /// contiguous chunks, one per thread if OpenMP is available.
+            /// Each thread counts the entries of its chunk in every row of
+            /// the inverse, the counts are turned into positions by a prefix
+            /// sum over the threads and the inverse rows, and each thread
+            /// then writes its entries straight into the storage of inv.
+            /// The entries of each inverse row are therefore ordered by
+            /// the rows of this table, whatever the number of threads.
+            /// The number of threads is capped such that the counts take
+            /// no more memory than a copy of the entries would.
             /// @param inv  The OrientedEntityTable
             void makeInverseRelation(OrientedEntityTable<codim_to, codim_from>& inv) const
             {
+                const int num_rows = size();
+
                 // Find the maximum index used. This will give (one less than) the size
                 // of the table to be created.
                 int maxind = -1;
-                for (int i = 0; i < size(); ++i) {
-                    EntityRep<codim_from> from_ent(i, true);
-                    row_type r = operator[](from_ent);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) reduction(max:maxind)
+#endif
+                for (int i = 0; i < num_rows; ++i) {
+                    const row_type r = operator[](FromType(i, true));
                     for (int j = 0; j < r.size(); ++j) {
-                        EntityRep<codim_to> to_ent = r[j];
-                        int ind = to_ent.index();
-                        maxind = std::max(ind, maxind);
+                        maxind = std::max(r[j].index(), maxind);
                     }
                 }
-                // Build the new_sizes vector and compute datacount.
-                std::vector<int> new_sizes(maxind + 1);
-                int datacount = 0;
-                for (int i = 0; i < size(); ++i) {
-                    EntityRep<codim_from> from_ent(i, true);
-                    row_type r = operator[](from_ent);
-                    datacount += r.size();
-                    for (int j = 0; j < r.size(); ++j) {
-                        EntityRep<codim_to> to_ent = r[j];
-                        int ind = to_ent.index();
-                        ++new_sizes[ind];
+                const int num_inv_rows = maxind + 1;
+
+#if defined(_OPENMP)
+                // The counts of all threads take num_threads*num_inv_rows ints.
+                // Use at most as many threads as keep them within the size of
+                // the inverse rows plus the entries, the temporary storage a
+                // serial inversion into a copy needs.
+                const int max_threads_for_counts = 1 + dataSize()/std::max(1, num_inv_rows);
+                const int num_threads = std::max(1, std::min({ omp_get_max_threads(),
+                                                               num_rows/min_rows_per_thread,
+                                                               max_threads_for_counts }));
+#else
+                const int num_threads = 1;
+#endif
+                // The rows of this table, and of the inverse, handled by thread t
+                // are [chunk(n, t), chunk(n, t + 1)).
+                auto chunk = [num_threads](int n, int t) {
+                    return static_cast<int>(static_cast<long long>(n) * t / num_threads);
+                };
+
+                // Count the entries of each chunk in each inverse row.
+                std::vector<int> pos(static_cast<std::size_t>(num_threads) * num_inv_rows, 0);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+#endif
+                for (int t = 0; t < num_threads; ++t) {
+                    int* count = pos.data() + static_cast<std::size_t>(t) * num_inv_rows;
+                    for (int i = chunk(num_rows, t); i < chunk(num_rows, t + 1); ++i) {
+                        const row_type r = operator[](FromType(i, true));
+                        for (int j = 0; j < r.size(); ++j) {
+                            ++count[r[j].index()];
+                        }
                     }
                 }
-                // Compute the cumulative sizes.
-                std::vector<int> cumul_sizes(new_sizes.size() + 1);
-                cumul_sizes[0] = 0;
-                std::partial_sum(new_sizes.begin(), new_sizes.end(), cumul_sizes.begin() + 1);
-                // Using the cumulative sizes array as indices, we populate new_data.
-                // Note that cumul_sizes[ind] is not kept constant, but incremented so that
-                // it always gives the correct index for new data corresponding to index ind.
-                std::vector<EntityRep<codim_from> > new_data(datacount);
-                for (int i = 0; i < size(); ++i) {
-                    EntityRep<codim_from> from_ent(i, true);
-                    row_type r = operator[](from_ent);
-                    for (int j = 0; j < r.size(); ++j) {
-                        EntityRep<codim_to> to_ent(r[j]);
-                        int ind = to_ent.index();
-                        int data_ind = cumul_sizes[ind];
-                        new_data[data_ind] = to_ent.orientation() ? from_ent : from_ent.opposite();
-                        ++cumul_sizes[ind];
+
+                // Prefix sum, first over the threads within each inverse row, then
+                // over the inverse rows within each chunk of them, and last over
+                // the chunks.
+                std::vector<int> new_sizes(num_inv_rows);
+                std::vector<int> chunk_start(num_threads + 1, 0);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+#endif
+                for (int t = 0; t < num_threads; ++t) {
+                    int start = 0;
+                    for (int ind = chunk(num_inv_rows, t); ind < chunk(num_inv_rows, t + 1); ++ind) {
+                        int row_size = 0;
+                        for (int tt = 0; tt < num_threads; ++tt) {
+                            int& p = pos[static_cast<std::size_t>(tt) * num_inv_rows + ind];
+                            const int count = p;
+                            p = start + row_size;
+                            row_size += count;
+                        }
+                        new_sizes[ind] = row_size;
+                        start += row_size;
+                    }
+                    chunk_start[t + 1] = start;
+                }
+                std::partial_sum(chunk_start.begin(), chunk_start.end(), chunk_start.begin());
+                if (num_threads > 1) {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+#endif
+                    for (int t = 1; t < num_threads; ++t) {
+                        for (int ind = chunk(num_inv_rows, t); ind < chunk(num_inv_rows, t + 1); ++ind) {
+                            for (int tt = 0; tt < num_threads; ++tt) {
+                                pos[static_cast<std::size_t>(tt) * num_inv_rows + ind] += chunk_start[t];
+                            }
+                        }
+                    }
+                }
+
+                // Fill the inverse in place.  Its rows are stored contiguously,
+                // starting with the first one.
+                inv.clear();
+                inv.allocate(new_sizes.begin(), new_sizes.end());
+                if (chunk_start.back() == 0) {
+                    return;
+                }
+                EntityRep<codim_from>* new_data = inv.row(EntityRep<codim_to>(0, true)).begin();
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+#endif
+                for (int t = 0; t < num_threads; ++t) {
+                    int* next = pos.data() + static_cast<std::size_t>(t) * num_inv_rows;
+                    for (int i = chunk(num_rows, t); i < chunk(num_rows, t + 1); ++i) {
+                        const FromType from_ent(i, true);
+                        const row_type r = operator[](from_ent);
+                        for (int j = 0; j < r.size(); ++j) {
+                            const ToType to_ent = r[j];
+                            new_data[next[to_ent.index()]++] = to_ent.orientation() ? from_ent : from_ent.opposite();
+                        }
                     }
                 }
-                inv = OrientedEntityTable<codim_to, codim_from>(new_data.begin(),
-                                                                new_data.end(),
-                                                                new_sizes.begin(),
-                                                                new_sizes.end());
             }
 
         private:
+            // Tables with fewer rows per thread are inverted by fewer threads.
+            enum { min_rows_per_thread = 4096 };
+
             int numberOfColumns() const
             {
                 int maxind = 0;
@@ -114,5 +114,34 @@ PartitionType PartitionTypeIndicator::getFacePartitionType(int i) const
     }
     return InteriorEntity;
 }
+
+template<int codim>
+void PartitionTypeIndicator::computePartitionEntities(int num_entities)
+{
+    auto& interior = partition_entities_[codim][Interior_Partition];
+    auto& interior_border = partition_entities_[codim][InteriorBorder_Partition];
+    auto& overlap = partition_entities_[codim][Overlap_Partition];
+    interior.clear();
+    interior_border.clear();
+    overlap.clear();
+    // The same selection as by PartitionIteratorRule, with the partition
+    // type looked up once per entity.
+    for(int i=0; i<num_entities; ++i)
+    {
+        PartitionType type=getPartitionType(EntityRep<codim>(i, true));
+        if(type==InteriorEntity)
+            interior.push_back(i);
+        if(type==InteriorEntity || type==BorderEntity)
+            interior_border.push_back(i);
+        if(type!=FrontEntity)
+            overlap.push_back(i);
+    }
+}
+
+void PartitionTypeIndicator::computePartitionEntities()
+{
+    computePartitionEntities<0>(grid_data_->size(0));
+    computePartitionEntities<3>(grid_data_->size(3));
+}
 } // end namespace cpgrid
 } // end namespace Dune
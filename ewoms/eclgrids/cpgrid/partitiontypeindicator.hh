@@ -19,6 +19,7 @@
 #ifndef EWOMS_PARTITIONTYPEINDICATOR_HEADER
 #define EWOMS_PARTITIONTYPEINDICATOR_HEADER
 
+#include <array>
 #include<vector>
 #include <dune/grid/common/gridenums.hh>
 
@@ -51,7 +52,33 @@ public:
     /// \return The partition type of the point.
     PartitionType getPartitionType(const EntityRep<3>& point_entity) const;
 
+    /// Get the cells or points in a partition.
+    ///
+    /// The lists are kept for the partitions of parallel grids that do
+    /// not simply contain all entities or none, that is for
+    /// Interior_Partition, InteriorBorder_Partition and Overlap_Partition.
+    /// \param codim The codimension of the entities.
+    /// \param pitype The partition.
+    /// \return The indices of the entities in increasing order, or a
+    ///         null pointer if there is no list: on sequential grids,
+    ///         where all entities are interior, for partitions that
+    ///         contain all entities or none, and for the faces, whose
+    ///         partition types are found from their cells when asked for.
+    const std::vector<int>* partitionEntities(int codim, PartitionIteratorType pitype) const
+    {
+        if(cell_indicator_.empty() || (codim != 0 && codim != 3) || pitype > Overlap_Partition)
+            return nullptr;
+        return &partition_entities_[codim][pitype];
+    }
+
 private:
+    /// Compute the entity lists returned by partitionEntities(), once
+    /// the partition types of the cells and points are known.
+    void computePartitionEntities();
+
+    template<int codim>
+    void computePartitionEntities(int num_entities);
+
     /// Get the partition type of a face by its index
     /// \param i The index of the face.
     /// \return The partition type of the face associated with this index.
@@ -74,6 +101,10 @@ private:
     /// If non-empty, then the point with index i has (PartitionType)cell_indicator_[i].
     /// Otherwise this grid is not parallel and allen entities are interior.
     std::vector<char> point_indicator_;
+    /// The indices of the cells and points (indexed by codimension) in
+    /// the interior, interior and border, and overlap partitions
+    /// (indexed by PartitionIteratorType), for parallel grids.
+    std::array<std::array<std::vector<int>, Overlap_Partition + 1>, 4> partition_entities_;
     friend class CpGridData;
     friend class FacePartitionTypeIterator;
 };
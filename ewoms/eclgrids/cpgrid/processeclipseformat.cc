@@ -28,15 +28,22 @@
 #include <ewoms/eclgrids/cpgpreprocess/preprocess.h>
 #include <ewoms/eclgrids/minpvprocessor.hh>
 #include <ewoms/eclgrids/repairzcorn.hh>
-#include <ewoms/eclgrids/utility/stopwatch.hh>
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
 
 #include <ewoms/eclgrids/utility/parserincludes.hh>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <initializer_list>
+#include <new>
 #include <set>
+#include <sstream>
 #include <utility>
 
 namespace Dune
@@ -76,6 +83,33 @@ namespace Dune
                        Ewoms::SparseTable<int>& f2p,
                        std::vector<std::array<int,8> >& c2p,
                        std::vector<int>& face_to_output_face);
+        void recoverProcessedGrid(const std::array<int, 3>& dims,
+                                  const NNCMaps& nnc,
+                                  const std::vector<int>& global_cell,
+                                  const cpgrid::OrientedEntityTable<1, 0>& f2c,
+                                  const Ewoms::SparseTable<int>& f2p,
+                                  const cpgrid::EntityVariable<enum face_tag, 1>& face_tags,
+                                  const cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3>& point_geom,
+                                  processed_grid& output,
+                                  std::vector<int>& output_face_to_face);
+
+        std::uint64_t processingKey(const grdecl& input_data, const NNCMaps& nnc, double z_tolerance,
+                                    bool remove_ij_boundary, bool turn_normals);
+
+        /// Geometry of the faces and cells of an earlier version of
+        /// a grid, used by buildGeom() for the faces and cells that an
+        /// incremental update has not changed.
+        struct GeometryReuse
+        {
+            std::vector<int> face_origin; // Earlier index of each face, or -1.
+            std::vector<int> cell_origin; // Earlier index of each cell, or -1.
+            std::vector<FieldVector<double, 3>> face_normals; // Not turned.
+            std::vector<FieldVector<double, 3>> face_centroids;
+            std::vector<double> face_areas;
+            std::vector<FieldVector<double, 3>> cell_centroids;
+            std::vector<double> cell_volumes;
+        };
+
         void buildGeom(const processed_grid& output,
                        const cpgrid::OrientedEntityTable<0, 1>& c2f,
                        const std::vector<std::array<int,8> >& c2p,
@@ -84,7 +118,8 @@ namespace Dune
                        cpgrid::EntityVariable<cpgrid::Geometry<2, 3>, 1>& face_geom,
                        cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3>& point_geom,
                        cpgrid::SignedEntityVariable<FieldVector<double, 3> , 1>& normals,
-                       bool turn_normals);
+                       bool turn_normals,
+                       const GeometryReuse* reuse = nullptr);
     } // anon namespace
 
 namespace cpgrid
@@ -98,6 +133,7 @@ namespace cpgrid
             // Store global grid only on rank 0
             return;
         }
+        Ewoms::time::PhaseProfiler::Scope phase("processEclipseFormat");
 
         if (!ecl_grid_ptr)
             EWOMS_THROW(std::logic_error, "We need a valid pointer to an eclipse grid on rank 0!");
@@ -122,6 +158,7 @@ namespace cpgrid
 
         // Possibly process MINPV
         if (!poreVolume.empty() && (ecl_grid.getMinpvMode() != Ewoms::MinpvMode::ModeEnum::Inactive)) {
+            Ewoms::time::PhaseProfiler::Scope minpv_phase("minPoreVolume");
             Ewoms::MinpvProcessor mp(g.dims[0], g.dims[1], g.dims[2]);
             // Currently PINCH is always assumed to be active
             const size_t cartGridSize = g.dims[0] * g.dims[1] * g.dims[2];
@@ -132,9 +169,6 @@ namespace cpgrid
             const double z_tolerance = ecl_grid.isPinchActive() ?  ecl_grid.getPinchThresholdThickness() : 0.0;
             const bool nogap = ecl_grid.getPinchGapMode() ==  Ewoms::PinchMode::ModeEnum::NOGAP;
             nnc_cells_pinch = mp.process(thickness, z_tolerance, poreVolume, ecl_grid.getMinpvVector(), actnumData, false, zcornData.data(), nogap);
-            if (nnc_cells_pinch.size() > 0) {
-                this->zcorn = zcornData;
-            }
         }
 
         NNCMaps nnc_cells;
@@ -159,10 +193,7 @@ namespace cpgrid
         for (int axisIdx = 0; axisIdx < 3; ++axisIdx)
             logicalCartesianSize[axisIdx] = g.dims[axisIdx];
 
-        // Handle zcorn clipping. The g variable points to the data in
-        // the clipped_zcorn variable, i.e. clipped_zcorn must remain
-        // in scope.
-        std::vector<double> clipped_zcorn;
+        // Handle zcorn clipping, in place since zcornData is our own copy.
         if (clip_z) {
             double minz_top = 1e100;
             double maxz_bot = -1e100;
@@ -187,15 +218,14 @@ namespace cpgrid
             if (minz_top <= maxz_bot) {
                 EWOMS_THROW(std::runtime_error, "Grid cannot be clipped to a shoe-box (in z): Would be empty afterwards.");
             }
-            int num_zcorn = zcornData.size();
-            clipped_zcorn.resize(num_zcorn);
-            for (int i = 0; i < num_zcorn; ++i) {
-                clipped_zcorn[i] = std::max(maxz_bot, std::min(minz_top, g.zcorn[i]));
+            for (auto& z : zcornData) {
+                z = std::max(maxz_bot, std::min(minz_top, z));
             }
-            g.zcorn = &clipped_zcorn[0];
-            this->zcorn = clipped_zcorn;
         }
 
+        // Retain the modified ZCORN values, see zcornData().
+        const bool keep_zcorn = clip_z || !nnc_cells_pinch.empty();
+
         // Get z_tolerance.
         const double z_tolerance = ecl_grid.isPinchActive() ?
             ecl_grid.getPinchThresholdThickness() : 0.0;
@@ -207,11 +237,25 @@ namespace cpgrid
             std::vector<int> new_actnum;
             grdecl new_g;
             addOuterCellLayer(g, new_coord, new_zcorn, new_actnum, new_g);
+            // The extended grid does not refer to the input arrays, release
+            // them before processing.  The peak is unchanged, as both copies
+            // exist while extending, but the processing runs with only the
+            // extended arrays alive (and the input ZCORN, if retained).
+            std::vector<double>().swap(coordData);
+            if (keep_zcorn) {
+                this->zcorn = std::move(zcornData);
+            }
+            std::vector<double>().swap(zcornData);
+            std::vector<int>().swap(actnumData);
             // Make the grid.
-            processEclipseFormat(new_g, nnc_cells, z_tolerance, true, turn_normals);
+            processEclipseFormat(new_g, nnc_cells, z_tolerance, true, turn_normals, new_zcorn.data());
         } else {
-            // Make the grid.
-            processEclipseFormat(g, nnc_cells, z_tolerance, false, turn_normals);
+            // Make the grid.  The ZCORN values are processed in place
+            // rather than through yet another copy.
+            processEclipseFormat(g, nnc_cells, z_tolerance, false, turn_normals, zcornData.data());
+            if (keep_zcorn) {
+                this->zcorn = std::move(zcornData);
+            }
         }
     }
 #endif // #if HAVE_ECL_INPUT
@@ -219,19 +263,64 @@ namespace cpgrid
     enum { NNCFace = -1 };
 
     /// Read the Eclipse grid format ('.grdecl').
-    void CpGridData::processEclipseFormat(const grdecl& input_data, const NNCMaps& nnc, double z_tolerance, bool remove_ij_boundary, bool turn_normals)
+    void CpGridData::processEclipseFormat(const grdecl& input_data, const NNCMaps& nnc, double z_tolerance, bool remove_ij_boundary, bool turn_normals,
+                                          double* zcorn_work)
     {
         if( ccobj_.rank() != 0 )
         {
             EWOMS_THROW(std::logic_error, "Processing  eclipse file only allowed on rank 0");
         }
+        Ewoms::time::PhaseProfiler::Scope phase("buildGrid");
+        // Removing the outer cell layer renumbers the faces and points in
+        // a way updateEclipseFormat() cannot recover.
+        can_update_eclipse_format_ = !remove_ij_boundary;
+        processed_nnc_ = nnc;
+        processed_z_tolerance_ = z_tolerance;
+        processed_turn_normals_ = turn_normals;
+        // Use the cached grid if there is one for this input.
+        std::string cache_file;
+        std::uint64_t key = 0;
+        if (!grid_cache_directory_.empty()) {
+            key = processingKey(input_data, nnc, z_tolerance, remove_ij_boundary, turn_normals);
+            std::ostringstream name;
+            name << grid_cache_directory_ << "/cpgrid-" << std::hex << std::setw(16)
+                 << std::setfill('0') << key << ".bin";
+            cache_file = name.str();
+            bool cache_hit = false;
+            {
+                Ewoms::time::PhaseProfiler::Scope cache_phase("readGridCache");
+                cache_hit = readGridCache(cache_file, key);
+            }
+            if (cache_hit) {
+#ifdef VERBOSE
+                std::cout << "Read processed grid from " << cache_file << std::endl;
+#endif
+                computeUniqueBoundaryIds();
+                if(ccobj_.size()>1)
+                    populateGlobalCellIndexSet();
+                return;
+            }
+        }
+
         // Process.
 #ifdef VERBOSE
         std::cout << "Processing eclipse data." << std::endl;
 #endif
         processed_grid output;
-        process_grdecl(&input_data, z_tolerance, &output);
+        {
+            Ewoms::time::PhaseProfiler::Scope process_phase("processGrdecl");
+            // Use all threads available to this process, the result is
+            // identical to the one of the serial algorithm.
+            if (zcorn_work) {
+                if (!process_grdecl_inplace(&input_data, zcorn_work, z_tolerance, /* num_threads = */ 0, &output)) {
+                    EWOMS_THROW(std::logic_error, "The ZCORN work array is not the one of the grid.");
+                }
+            } else {
+                process_grdecl_threaded(&input_data, z_tolerance, /* num_threads = */ 0, &output);
+            }
+        }
         if (remove_ij_boundary) {
+            Ewoms::time::PhaseProfiler::Scope remove_phase("removeOuterCellLayer");
             removeOuterCellLayer(output);
             // removeUnusedNodes(output);
         }
@@ -247,24 +336,33 @@ namespace cpgrid
 #ifdef VERBOSE
         std::cout << "Building geometry." << std::endl;
 #endif
-        buildGeom(output, cell_to_face_, cell_to_point_, face_to_output_face, geometry_.geomVector(std::integral_constant<int,0>()),
-                  geometry_.geomVector(std::integral_constant<int,1>()), geometry_.geomVector(std::integral_constant<int,3>()),
-                  face_normals_, turn_normals);
+        {
+            cpgrid::EntityVariable<cpgrid::Geometry<3, 3>, 0> cell_geom;
+            cpgrid::EntityVariable<cpgrid::Geometry<2, 3>, 1> face_geom;
+            cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3> point_geom;
+            buildGeom(output, cell_to_face_, cell_to_point_, face_to_output_face, cell_geom,
+                      face_geom, point_geom, face_normals_, turn_normals);
+            geometry_.setGeometries(std::move(cell_geom), std::move(face_geom), std::move(point_geom));
+        }
+        resetCellNeighborGraph();
 
 #ifdef VERBOSE
         std::cout << "Assigning face tags." << std::endl;
 #endif
-        int nf = face_to_output_face.size();
-        std::vector<enum face_tag> temp_tags(nf);
-        for (int i = 0; i < nf; ++i) {
-            const int output_face = face_to_output_face[i];
-            if (output_face == -1) {
-                temp_tags[i] = NNC_FACE;
-            } else {
-                temp_tags[i] = output.face_tag[output_face];
+        {
+            Ewoms::time::PhaseProfiler::Scope tags_phase("faceTags");
+            int nf = face_to_output_face.size();
+            std::vector<enum face_tag> temp_tags(nf);
+            for (int i = 0; i < nf; ++i) {
+                const int output_face = face_to_output_face[i];
+                if (output_face == -1) {
+                    temp_tags[i] = NNC_FACE;
+                } else {
+                    temp_tags[i] = output.face_tag[output_face];
+                }
             }
+            face_tag_.assign(temp_tags.begin(), temp_tags.end());
         }
-        face_tag_.assign(temp_tags.begin(), temp_tags.end());
 
 #ifdef VERBOSE
         std::cout << "Cleaning up." << std::endl;
@@ -274,6 +372,11 @@ namespace cpgrid
 
         computeUniqueBoundaryIds();
 
+        if (!cache_file.empty()) {
+            Ewoms::time::PhaseProfiler::Scope cache_phase("writeGridCache");
+            writeGridCache(cache_file, key);
+        }
+
         if(ccobj_.size()>1)
             populateGlobalCellIndexSet();
 
@@ -282,6 +385,112 @@ namespace cpgrid
 #endif
     }
 
+    void CpGridData::updateEclipseFormat(const grdecl& input_data,
+                                         const std::array<int, 3>& box_begin,
+                                         const std::array<int, 3>& box_end)
+    {
+        if( ccobj_.rank() != 0 )
+        {
+            EWOMS_THROW(std::logic_error, "Updating eclipse grid only allowed on rank 0");
+        }
+        if (!can_update_eclipse_format_) {
+            EWOMS_THROW(std::logic_error, "Only grids processed without periodic extension or removal of the "
+                        "outer cell layer, and not reordered, can be updated");
+        }
+        Ewoms::time::PhaseProfiler::Scope phase("updateEclipseFormat");
+        for (int dd = 0; dd < 3; ++dd) {
+            if (input_data.dims[dd] != logical_cartesian_size_[dd]) {
+                EWOMS_THROW(std::invalid_argument, "Dimensions of updated grid differ from the processed ones");
+            }
+        }
+
+        // Process with the settings of the earlier grid processing.
+        const NNCMaps& nnc = processed_nnc_;
+        const double z_tolerance = processed_z_tolerance_;
+        const bool turn_normals = processed_turn_normals_;
+
+        // Recover the output of the earlier grid processing.
+        processed_grid output;
+        std::vector<int> output_face_to_face;
+        recoverProcessedGrid(logical_cartesian_size_, nnc, global_cell_, face_to_cell_, face_to_point_,
+                             face_tag_, geometry_.geomVector(std::integral_constant<int,3>()),
+                             output, output_face_to_face);
+
+        // Rediscover points and faces in the columns around the box.
+        int* face_origin = nullptr;
+        int* cell_origin = nullptr;
+        process_grdecl_update(&input_data, z_tolerance, box_begin.data(), box_end.data(),
+                              /* num_threads = */ 0, &output, &face_origin, &cell_origin);
+
+        // Keep the geometry of the faces and cells that are unchanged.
+        GeometryReuse reuse;
+        {
+            const auto& face_geom = geometry_.geomVector(std::integral_constant<int,1>());
+            const auto& cell_geom = geometry_.geomVector(std::integral_constant<int,0>());
+            const int nf = face_geom.size();
+            const int nc = cell_geom.size();
+            reuse.face_normals.reserve(nf);
+            reuse.face_centroids.reserve(nf);
+            reuse.face_areas.reserve(nf);
+            for (int face = 0; face < nf; ++face) {
+                FieldVector<double, 3> normal = face_normals_.get(face);
+                if (turn_normals) {
+                    normal *= -1.0;
+                }
+                reuse.face_normals.push_back(normal);
+                reuse.face_centroids.push_back(face_geom.get(face).center());
+                reuse.face_areas.push_back(face_geom.get(face).volume());
+            }
+            reuse.cell_centroids.reserve(nc);
+            reuse.cell_volumes.reserve(nc);
+            for (int cell = 0; cell < nc; ++cell) {
+                reuse.cell_centroids.push_back(cell_geom.get(cell).center());
+                reuse.cell_volumes.push_back(cell_geom.get(cell).volume());
+            }
+        }
+        reuse.cell_origin.assign(cell_origin, cell_origin + output.number_of_cells);
+        std::free(cell_origin);
+
+        // Rebuild the topology and geometry.
+        std::vector<int> face_to_output_face;
+        face_to_point_.clear();
+        buildTopo(output, nnc, global_cell_, cell_to_face_, face_to_cell_, face_to_point_, cell_to_point_, face_to_output_face);
+
+        const int nf = face_to_output_face.size();
+        reuse.face_origin.assign(nf, -1);
+        for (int face = 0; face < nf; ++face) {
+            const int output_face = face_to_output_face[face];
+            if (output_face != NNCFace && face_origin[output_face] != -1) {
+                reuse.face_origin[face] = output_face_to_face[face_origin[output_face]];
+            }
+        }
+        std::free(face_origin);
+
+        {
+            cpgrid::EntityVariable<cpgrid::Geometry<3, 3>, 0> cell_geom;
+            cpgrid::EntityVariable<cpgrid::Geometry<2, 3>, 1> face_geom;
+            cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3> point_geom;
+            buildGeom(output, cell_to_face_, cell_to_point_, face_to_output_face, cell_geom,
+                      face_geom, point_geom, face_normals_, turn_normals, &reuse);
+            geometry_.setGeometries(std::move(cell_geom), std::move(face_geom), std::move(point_geom));
+        }
+        resetCellNeighborGraph();
+
+        std::vector<enum face_tag> temp_tags(nf);
+        for (int i = 0; i < nf; ++i) {
+            const int output_face = face_to_output_face[i];
+            temp_tags[i] = (output_face == NNCFace) ? NNC_FACE : output.face_tag[output_face];
+        }
+        face_tag_.assign(temp_tags.begin(), temp_tags.end());
+
+        free_processed_grid(&output);
+
+        computeUniqueBoundaryIds();
+
+        if(ccobj_.size()>1)
+            populateGlobalCellIndexSet();
+    }
+
     } // end namespace cpgrid
 
     // ---- Implementation details below ----
@@ -355,36 +564,11 @@ namespace cpgrid
             return cellz;
         }
 
-        void setCellZvals(const coord_t& c, const coord_t& n, double* z, const cellz_t& cellvals)
-        {
-            int delta[3] = { 1,
-                             2*n[0],
-                             4*n[0]*n[1] };
-            int ix = 2*(c[0]*delta[0] + c[1]*delta[1] + c[2]*delta[2]);
-            z[ix]                                  = cellvals[0];
-            z[ix + delta[0]]                       = cellvals[1];
-            z[ix + delta[1]]                       = cellvals[2];
-            z[ix + delta[1] + delta[0]]            = cellvals[3];
-            z[ix + delta[2]]                       = cellvals[4];
-            z[ix + delta[2] + delta[0]]            = cellvals[5];
-            z[ix + delta[2] + delta[1]]            = cellvals[6];
-            z[ix + delta[2] + delta[1] + delta[0]] = cellvals[7];
-        }
-
-        coord_t indexToIjk(const coord_t& n, const int index)
+        /// The cell of the original grid that is repeated in position
+        /// i of the extended grid, along an axis of n original cells.
+        inline int periodicSource(const int i, const int n)
         {
-            coord_t c;
-            c[2] = index/(n[0]*n[1]);
-            c[1] = (index%(n[0]*n[1]))/n[0];
-            c[0] = index%n[0];
-            return c;
-        }
-
-        void findTopAndBottomZ(const coord_t& n, const std::vector<double>& z, double& zb, double& zt)
-        {
-            int numperlevel = 4*n[0]*n[1];
-            zb = *std::max_element(z.begin(), z.begin() + numperlevel);
-            zt = *std::min_element(z.end() - numperlevel, z.end());
+            return (i == 0) ? n - 1 : ((i == n + 1) ? 0 : i - 1);
         }
 
         /// Add an outer cell layer in the (i, j) directions,
@@ -402,108 +586,76 @@ namespace cpgrid
             //  2. We do not treat other fields such as PORO, SATNUM etc.
             //     since the grid will be reduced back to its regular
             //     size before those fields are processed.
+            //  3. No cell index tables are built, each entry of the
+            //     extended grid is read from the original arrays through
+            //     periodicSource(), and the new arrays are written once.
 
             EWOMS_MESSAGE("WARNING: Assuming vertical pillars in a cartesian grid.");
 
-            // Build new-to-old cell index table.
-            // First expand in x.
-            coord_t n = {{ original.dims[0], original.dims[1], original.dims[2] }};
-            std::vector<int> x_new2old;
-            x_new2old.reserve((n[0]+2)*n[1]*n[2]);
-            for (int kz = 0; kz < n[2]; ++kz) {
-                for (int jy = 0; jy < n[1]; ++jy) {
-                    int row_ix = kz*n[0]*n[1] + jy*n[0];
-                    x_new2old.push_back(row_ix + n[0] - 1);
-                    for (int ix = 1; ix < n[0] + 1; ++ix) {
-                        x_new2old.push_back(row_ix + ix - 1);
-                    }
-                    x_new2old.push_back(row_ix);
-                }
-            }
-            // copy(x_new2old.begin(), x_new2old.end(), ostream_iterator<int>(cout, " "));
-            // cout << endl;
-            // Then expand in y.
-            const int num_new_cells = (n[0]+2)*(n[1]+2)*n[2];
-            std::vector<int> new2old;
-            new2old.reserve(num_new_cells);
-            for (int kz = 0; kz < n[2]; ++kz) {
-                for (int jy = 0; jy < n[1] + 2; ++jy) {
-                    int offset = kz*(n[0] + 2)*n[1] + (jy - 1)*(n[0] + 2);
-                    if (jy == 0) {
-                        offset = kz*(n[0] + 2)*n[1] + (n[1] - 1)*(n[0] + 2);
-                    } else if (jy == n[1] + 1) {
-                        offset = kz*(n[0] + 2)*n[1];
-                    }
-                    for (int ix = 0; ix < n[0] + 2; ++ix) {
-                        new2old.push_back(x_new2old[offset + ix]);
-                    }
-                }
-            }
-            assert(int(new2old.size()) == num_new_cells);
-            // copy(new2old.begin(), new2old.end(), ostream_iterator<int>(cout, " "));
-            // cout << endl;
-            // On second thought, we should have used a multidimensional array or something...
+            const coord_t n = {{ original.dims[0], original.dims[1], original.dims[2] }};
+            const coord_t new_n = {{ n[0] + 2, n[1] + 2, n[2] }};
+            const int num_new_cells = new_n[0]*new_n[1]*new_n[2];
 
             // Build new COORD field.
-            std::vector<double> coord;
-            coord.reserve(6*(n[0] + 3)*(n[1] + 3));
+            new_coord.resize(6*(n[0] + 3)*(n[1] + 3));
             const double* old_coord = original.coord;
             double dx = old_coord[6] - old_coord[0];
             double dy = old_coord[6*(n[0] + 1) + 1] - old_coord[1];
             double ox = old_coord[0] - dx;
             double oy = old_coord[1] - dy;
+            double* coord = new_coord.data();
             for (int jy = 0; jy < n[1] + 3; ++jy) {
                 double y = oy + jy*dy;
                 for (int ix = 0; ix < n[0] + 3; ++ix) {
                     double x = ox + ix*dx;
-                    coord.push_back(x);
-                    coord.push_back(y);
-                    coord.push_back(0.0);
-                    coord.push_back(x);
-                    coord.push_back(y);
-                    coord.push_back(1.0);
+                    *coord++ = x;
+                    *coord++ = y;
+                    *coord++ = 0.0;
+                    *coord++ = x;
+                    *coord++ = y;
+                    *coord++ = 1.0;
                 }
             }
 
-            // Build new ZCORN field, PERMX, PORO, ACTNUM, SATNUM.
+            // Clamp z-coord to make shoe box shape.  The top and bottom
+            // levels of the extended grid hold the same values as those
+            // of the original one.
             const double* old_zcorn = original.zcorn;
+            const int numperlevel = 4*n[0]*n[1];
+            const int num_old_zcorn = 8*n[0]*n[1]*n[2];
+            const double zb = *std::max_element(old_zcorn, old_zcorn + numperlevel);
+            const double zt = *std::min_element(old_zcorn + num_old_zcorn - numperlevel, old_zcorn + num_old_zcorn);
+
+            // Build new ZCORN and ACTNUM fields.
+            new_zcorn.resize(8*num_new_cells);
+            new_actnum.resize(num_new_cells);
             const int* old_actnum = original.actnum;
-            std::vector<double> zcorn(8*num_new_cells);
-            std::vector<int> actnum(num_new_cells);
-            coord_t new_n = {{ n[0] + 2, n[1] + 2, n[2] }};
-            for (int kz = 0; kz < new_n[2]; ++kz) {
-                for (int jy = 0; jy < new_n[1]; ++jy) {
-                    for (int ix = 0; ix < new_n[0]; ++ix) {
-                        int new_cell_index = ix + jy*(new_n[0]) + kz*(new_n[0])*(new_n[1]);
-                        int old_cell_index = new2old[new_cell_index];
-
-                        cellz_t cellvals = getCellZvals(indexToIjk(n, old_cell_index), n, old_zcorn);
-                        // cout << new_cell_index << ' ' << old_cell_index << ' ' << cellvals << endl;
-                        setCellZvals(indexToIjk(new_n, new_cell_index), new_n, &zcorn[0], cellvals);
-                        actnum[new_cell_index] = old_actnum?old_actnum[old_cell_index]:1;
-                        if (ix == 0 || ix == new_n[0] - 1
-                            || jy == 0 || jy == new_n[1] - 1) {
-                            actnum[new_cell_index] = 1;  // This line is changed from the original.
-                        }
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
+            for (int kz = 0; kz < 2*new_n[2]; ++kz) {
+                double* z = &new_zcorn[4*new_n[0]*new_n[1]*kz];
+                for (int jy = 0; jy < 2*new_n[1]; ++jy) {
+                    const int old_jy = 2*periodicSource(jy/2, n[1]) + jy%2;
+                    const double* old_z = old_zcorn + 2*n[0]*(old_jy + 2*n[1]*kz);
+                    for (int ix = 0; ix < 2*new_n[0]; ++ix) {
+                        const int old_ix = 2*periodicSource(ix/2, n[0]) + ix%2;
+                        *z++ = std::min(zt, std::max(zb, old_z[old_ix]));
                     }
                 }
-            }
-
-            // Clamp z-coord to make shoe box shape
-            bool clamp_z = true;
-            if (clamp_z) {
-                double zb;
-                double zt;
-                findTopAndBottomZ(new_n, zcorn, zb, zt);
-                for (int i = 0; i < int(zcorn.size()); ++i) {
-                    zcorn[i] =  std::min(zt, std::max(zb, zcorn[i]));
+                if (kz % 2 == 0) {
+                    int* act = &new_actnum[new_n[0]*new_n[1]*(kz/2)];
+                    for (int jy = 0; jy < new_n[1]; ++jy) {
+                        for (int ix = 0; ix < new_n[0]; ++ix) {
+                            const bool outer = ix == 0 || ix == new_n[0] - 1 || jy == 0 || jy == new_n[1] - 1;
+                            const int old_cell = periodicSource(ix, n[0]) + n[0]*(periodicSource(jy, n[1]) + n[1]*(kz/2));
+                            *act++ = (outer || !old_actnum) ? 1 : old_actnum[old_cell];
+                        }
+                    }
                 }
             }
 
             // Build output.
-            new_coord.swap(coord);
-            new_zcorn.swap(zcorn);
-            new_actnum.swap(actnum);
             output.dims[0] = new_n[0];
             output.dims[1] = new_n[1];
             output.dims[2] = new_n[2];
@@ -533,45 +685,37 @@ namespace cpgrid
         void removeOuterCellLayer(processed_grid& grid)
         {
             // Remove outer cells as follows:
-            //   1. Build a new local_cell_index (in a new variable), compute new number_of_cells.
-            //   2. Build the inverse lookup: From old logical cartesian to new cell indices.
-            //   3. Modify face_neighbours by replacing each entry by its new cell index (or -1).
-            //   4. Modify dimensions[], number_of_cells and replace local_cell_index.
+            //   1. Compute the new index of every old cell (or -1), and compact
+            //      local_cell_index in place, since new indices never exceed old ones.
+            //   2. Modify face_neighbours by replacing each entry by its new cell index (or -1).
+            //   3. Modify dimensions[] and number_of_cells.
             // After this, we still have the same number of faces, it's just that some of them may
-            // have only (-1, -1) as neighbours.
+            // have only (-1, -1) as neighbours.  No cartesian-sized table is needed.
 
-            // Part 1 and 2 in one pass.
-            std::vector<int> new_index_to_new_lcart;
-            new_index_to_new_lcart.reserve(grid.number_of_cells); // A little too large, but no problem.
-            int num_old_lcart = grid.dimensions[0]*grid.dimensions[1]*grid.dimensions[2];
-            std::vector<int> old_lcart_to_new_index(num_old_lcart, -1);
+            // Part 1.
+            std::vector<int> old_to_new_index(grid.number_of_cells, -1);
+            int num_new_cells = 0;
             for (int i = 0; i < grid.number_of_cells; ++i) {
-                int old_lcart = grid.local_cell_index[i];
-                int new_lcart = newLogCartFromOld(old_lcart, grid.dimensions);
+                int new_lcart = newLogCartFromOld(grid.local_cell_index[i], grid.dimensions);
                 if (new_lcart != -1) {
-                    old_lcart_to_new_index[old_lcart] = new_index_to_new_lcart.size();
-                    new_index_to_new_lcart.push_back(new_lcart);
-                } else {
-                    old_lcart_to_new_index[old_lcart] = -1;
+                    old_to_new_index[i] = num_new_cells;
+                    grid.local_cell_index[num_new_cells++] = new_lcart;
                 }
             }
 
-            // Part 3, modfying the face->cell connections.
+            // Part 2, modfying the face->cell connections.
             for (int i = 0; i < 2*grid.number_of_faces; ++i) {
                 int old_index = grid.face_neighbors[i];
                 if (old_index != -1) {
-                    int old_lcart = grid.local_cell_index[old_index];
-                    int new_index = old_lcart_to_new_index[old_lcart];
-                    grid.face_neighbors[i] = new_index; // May be -1, if cell is to be removed.
+                    grid.face_neighbors[i] = old_to_new_index[old_index]; // May be -1, if cell is to be removed.
                 }
             }
 
-            // Part 4, modifying the other output data.
+            // Part 3, modifying the other output data.
             grid.dimensions[0] = grid.dimensions[0] - 2;
             grid.dimensions[1] = grid.dimensions[1] - 2;
             grid.dimensions[2] = grid.dimensions[2] - 2;
-            grid.number_of_cells = new_index_to_new_lcart.size();
-            std::copy(new_index_to_new_lcart.begin(), new_index_to_new_lcart.end(), grid.local_cell_index);
+            grid.number_of_cells = num_new_cells;
         }
 
         /*
@@ -657,26 +801,19 @@ namespace cpgrid
             return global_to_local;
         }
 
-        NNCMap filterNNCs(const processed_grid& output,
-                          const NNCMap& nnc,
-                          const std::vector<int>& global_to_local)
+        // The local cells of the NNCs that neither repeat a face nor an
+        // earlier NNC, in the order of nnc.  Linear in the number of
+        // faces, cells and NNCs: both faces and NNCs are bucketed by
+        // their lower cell, and every bucket is scanned once while
+        // marking the higher cells seen.
+        std::vector<std::pair<int, int>> filterNNCs(const processed_grid& output,
+                                                    const NNCMap& nnc,
+                                                    const std::vector<int>& global_to_local)
         {
-            NNCMap filtered_nnc;
             const int num_faces = output.number_of_faces;
-            std::vector<std::pair<int, int>> face_cells(num_faces);
-            // Sort all face->cell mappings so that lowest cell number comes first.
-            for (int f = 0; f < num_faces; ++f) {
-                const int c1 = output.face_neighbors[2*f];
-                const int c2 = output.face_neighbors[2*f + 1];
-                if (c1 < c2) {
-                    face_cells[f] = { c1, c2 };
-                } else {
-                    face_cells[f] = { c2, c1 };
-                }
-            }
-            // Sort face->cell mappings according to first, then second cell.
-            std::sort(face_cells.begin(), face_cells.end());
-            // For each nnc, add it to filtered_nnc only if not found in face->cell mappings.
+            const int num_cells = output.number_of_cells;
+            std::vector<std::pair<int, int>> candidates;
+            candidates.reserve(nnc.size());
             for (const auto& nncpair : nnc) {
                 if (nncpair.first < 0 || nncpair.second < 0 ||
                     nncpair.first >= static_cast<int>(global_to_local.size()) ||
@@ -690,12 +827,63 @@ namespace cpgrid
                     Ewoms::OpmLog::warning("nnc_inactive", "NNC connection requested between inactive cells.");
                     continue;
                 }
-                const auto beg = std::lower_bound(face_cells.begin(), face_cells.end(), std::make_pair(c1, -1));
-                const auto end = std::find_if(beg, face_cells.end(), [c1](const std::pair<int, int>& p){ return p.first > c1; });
-                const auto it = std::find_if(beg, end, [c2](const std::pair<int, int>& p){ return p.second == c2; });
-                if (it == end) {
-                    // The connection (c1, c2) was not found in the face->cell mapping.
-                    filtered_nnc.insert(nncpair);
+                candidates.emplace_back(c1, c2);
+            }
+            const int num_candidates = candidates.size();
+
+            // Bucket by lower cell, faces before NNCs.  Entries are the
+            // higher cell, with NNC number n stored as ~n in 'which'.
+            std::vector<int> bucket_start(num_cells + 1, 0);
+            for (int f = 0; f < num_faces; ++f) {
+                const int c1 = output.face_neighbors[2*f];
+                const int c2 = output.face_neighbors[2*f + 1];
+                if (c1 >= 0 && c2 >= 0) {
+                    ++bucket_start[std::min(c1, c2) + 1];
+                }
+            }
+            for (const auto& cells : candidates) {
+                ++bucket_start[std::min(cells.first, cells.second) + 1];
+            }
+            for (int c = 0; c < num_cells; ++c) {
+                bucket_start[c + 1] += bucket_start[c];
+            }
+            std::vector<int> other(bucket_start.back());
+            std::vector<int> which(bucket_start.back());
+            std::vector<int> fill(bucket_start.begin(), bucket_start.end() - 1);
+            for (int f = 0; f < num_faces; ++f) {
+                const int c1 = output.face_neighbors[2*f];
+                const int c2 = output.face_neighbors[2*f + 1];
+                if (c1 >= 0 && c2 >= 0) {
+                    const int pos = fill[std::min(c1, c2)]++;
+                    other[pos] = std::max(c1, c2);
+                    which[pos] = f;
+                }
+            }
+            for (int n = 0; n < num_candidates; ++n) {
+                const auto& cells = candidates[n];
+                const int pos = fill[std::min(cells.first, cells.second)]++;
+                other[pos] = std::max(cells.first, cells.second);
+                which[pos] = ~n;
+            }
+
+            std::vector<char> keep(num_candidates, 0);
+            std::vector<int> seen_in(num_cells, -1);
+            for (int c = 0; c < num_cells; ++c) {
+                for (int pos = bucket_start[c]; pos < bucket_start[c + 1]; ++pos) {
+                    if (seen_in[other[pos]] != c) {
+                        seen_in[other[pos]] = c;
+                        if (which[pos] < 0) {
+                            keep[~which[pos]] = 1;
+                        }
+                    }
+                }
+            }
+
+            std::vector<std::pair<int, int>> filtered_nnc;
+            filtered_nnc.reserve(std::count(keep.begin(), keep.end(), 1));
+            for (int n = 0; n < num_candidates; ++n) {
+                if (keep[n]) {
+                    filtered_nnc.push_back(candidates[n]);
                 }
             }
             return filtered_nnc;
@@ -715,13 +903,15 @@ namespace cpgrid
             // the geometry-based grid processing. In that case we
             // should ensure we do not add it twice, and therefore we
             // filter them out first.
-            NNCMap filtered_nnc = filterNNCs(output, nnc, global_to_local);
+            std::vector<std::pair<int, int>> filtered_nnc;
+            {
+                Ewoms::time::PhaseProfiler::Scope phase("filterNNCs");
+                filtered_nnc = filterNNCs(output, nnc, global_to_local);
+            }
             cpgrid::EntityRep<0> cells[2];
-            for (const auto& nncpair : filtered_nnc) {
-                const int c1 = global_to_local[nncpair.first];
-                const int c2 = global_to_local[nncpair.second];
-                cells[0].setValue(c1, true);
-                cells[1].setValue(c2, false);
+            for (const auto& nnccells : filtered_nnc) {
+                cells[0].setValue(nnccells.first, true);
+                cells[1].setValue(nnccells.second, false);
                 std::sort(cells, cells + 2);
                 f2c.appendRow(cells, cells + 2);
                 face_to_output_face.push_back(cpgrid::NNCFace);
@@ -741,7 +931,9 @@ namespace cpgrid
             f2c.clear();
             face_to_output_face.clear();
             // Reserve to save allocation time. True required size may be smaller.
-            face_to_output_face.reserve(output.number_of_faces + nnc[ExplicitNNC].size());
+            const int max_faces = output.number_of_faces + nnc[ExplicitNNC].size();
+            face_to_output_face.reserve(max_faces);
+            f2c.reserve(max_faces, 2*max_faces + nnc[PinchNNC].size());
             if (!nnc[ExplicitNNC].empty()) {
                 buildFaceToCellNNC(output, nnc[ExplicitNNC], global_to_local, f2c, face_to_output_face);
             }
@@ -812,6 +1004,7 @@ namespace cpgrid
                        std::vector<std::array<int,8> >& c2p,
                        std::vector<int>& face_to_output_face)
         {
+            Ewoms::time::PhaseProfiler::Scope phase("buildTopo");
             // Map local to global cell index.
             global_cell.assign(output.local_cell_index,
                                output.local_cell_index + output.number_of_cells);
@@ -872,6 +1065,161 @@ namespace cpgrid
 #endif
         }
 
+        /// Hash of the bytes [data, data + size), continuing from hash.
+        std::uint64_t hashBytes(std::uint64_t hash, const void* data, std::size_t size)
+        {
+            // Words are mixed with the splitmix64 finalizer, such that
+            // the hash is fast for the large ZCORN arrays.
+            auto mix = [](std::uint64_t x) {
+                x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+                return x ^ (x >> 31);
+            };
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            std::size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, bytes + i, 8);
+                hash = mix(hash ^ word) + 0x9e3779b97f4a7c15ULL;
+            }
+            std::uint64_t tail = size;
+            for (; i < size; ++i) {
+                tail = (tail << 8) | bytes[i];
+            }
+            return mix(hash ^ tail);
+        }
+
+        /// Key of the result of processing, from everything that enters it.
+        std::uint64_t processingKey(const grdecl& input_data, const NNCMaps& nnc, double z_tolerance,
+                                    bool remove_ij_boundary, bool turn_normals)
+        {
+            const std::size_t nx = input_data.dims[0];
+            const std::size_t ny = input_data.dims[1];
+            const std::size_t nz = input_data.dims[2];
+            const int flags[3] = { remove_ij_boundary, turn_normals, input_data.actnum != nullptr };
+            std::uint64_t hash = 0;
+            hash = hashBytes(hash, input_data.dims, sizeof input_data.dims);
+            hash = hashBytes(hash, flags, sizeof flags);
+            hash = hashBytes(hash, &z_tolerance, sizeof z_tolerance);
+            hash = hashBytes(hash, input_data.coord, 6*(nx + 1)*(ny + 1) * sizeof(double));
+            hash = hashBytes(hash, input_data.zcorn, 8*nx*ny*nz * sizeof(double));
+            if (input_data.actnum) {
+                hash = hashBytes(hash, input_data.actnum, nx*ny*nz * sizeof(int));
+            }
+            if (input_data.mapaxes) {
+                hash = hashBytes(hash, input_data.mapaxes, 6 * sizeof(double));
+            }
+            for (const auto& map : nnc) {
+                const std::uint64_t num_pairs = map.size();
+                hash = hashBytes(hash, &num_pairs, sizeof num_pairs);
+                for (const auto& pair : map) {
+                    const int cells[2] = { pair.first, pair.second };
+                    hash = hashBytes(hash, cells, sizeof cells);
+                }
+            }
+            return hash;
+        }
+
+        void recoverProcessedGrid(const std::array<int, 3>& dims,
+                                  const NNCMaps& nnc,
+                                  const std::vector<int>& global_cell,
+                                  const cpgrid::OrientedEntityTable<1, 0>& f2c,
+                                  const Ewoms::SparseTable<int>& f2p,
+                                  const cpgrid::EntityVariable<enum face_tag, 1>& face_tags,
+                                  const cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3>& point_geom,
+                                  processed_grid& output,
+                                  std::vector<int>& output_face_to_face)
+        {
+            // The geometric faces are those of the processed grid, in
+            // the same order.  Explicit NNC faces come first and are
+            // left out.
+            const int num_faces = f2c.size();
+            const int num_cells = global_cell.size();
+            output_face_to_face.clear();
+            int num_face_nodes = 0;
+            for (int face = 0; face < num_faces; ++face) {
+                if (face_tags.get(face) != NNC_FACE) {
+                    output_face_to_face.push_back(face);
+                    num_face_nodes += f2p[face].size();
+                }
+            }
+            const int nf = output_face_to_face.size();
+            const int np = point_geom.size();
+
+            // Allocated with malloc(), for free_processed_grid().
+            output.face_neighbors   = static_cast<int*>(std::malloc(std::max(2*nf, 1) * sizeof(int)));
+            output.face_nodes       = static_cast<int*>(std::malloc(std::max(num_face_nodes, 1) * sizeof(int)));
+            output.face_ptr         = static_cast<int*>(std::malloc((nf + 1) * sizeof(int)));
+            output.face_tag         = static_cast<enum face_tag*>(std::malloc(std::max(nf, 1) * sizeof(enum face_tag)));
+            output.node_coordinates = static_cast<double*>(std::malloc(std::max(3*np, 1) * sizeof(double)));
+            output.local_cell_index = static_cast<int*>(std::malloc(std::max(num_cells, 1) * sizeof(int)));
+            if (!output.face_neighbors || !output.face_nodes || !output.face_ptr ||
+                !output.face_tag || !output.node_coordinates || !output.local_cell_index) {
+                free_processed_grid(&output);
+                throw std::bad_alloc();
+            }
+
+            std::copy(dims.begin(), dims.end(), output.dimensions);
+            output.m = output.number_of_faces = nf;
+            output.n = num_face_nodes;
+            output.number_of_nodes = np;
+            output.number_of_cells = num_cells;
+            std::copy(global_cell.begin(), global_cell.end(), output.local_cell_index);
+            for (int i = 0; i < np; ++i) {
+                const auto& pt = point_geom.get(i).center();
+                for (int dd = 0; dd < 3; ++dd) {
+                    output.node_coordinates[3*i + dd] = pt[dd];
+                }
+            }
+
+            // Nodes are numbered pillar points first, the horizontal
+            // faces only have pillar points.  Every pillar point of an
+            // active cell is on its top or bottom face, so this counts
+            // all pillar points that are on a face; the others, of
+            // collapsed cells only, are dropped by process_grdecl_update().
+            int num_pillar_nodes = 0;
+            std::vector<int> num_upper_faces(num_cells, 0);
+            output.face_ptr[0] = 0;
+            for (int i = 0; i < nf; ++i) {
+                const int face = output_face_to_face[i];
+                const auto nodes = f2p[face];
+                std::copy(nodes.begin(), nodes.end(), output.face_nodes + output.face_ptr[i]);
+                output.face_ptr[i + 1] = output.face_ptr[i] + nodes.size();
+                output.face_tag[i] = face_tags.get(face);
+                int* fnc = output.face_neighbors + 2*i;
+                fnc[0] = fnc[1] = -1;
+                const auto cells = f2c[cpgrid::EntityRep<1>(face, true)];
+                for (int j = 0; j < cells.size(); ++j) {
+                    fnc[cells[j].orientation() ? 0 : 1] = cells[j].index();
+                }
+                if (output.face_tag[i] == K_FACE) {
+                    for (int node : nodes) {
+                        num_pillar_nodes = std::max(num_pillar_nodes, node + 1);
+                    }
+                    if (fnc[1] != -1) {
+                        ++num_upper_faces[fnc[1]];
+                    }
+                }
+            }
+            output.number_of_nodes_on_pillars = num_pillar_nodes;
+
+            // Undo the PINCH connections of buildFaceToCell(), attached
+            // to the bottom face of the upper cell.  The lower cell keeps
+            // its own top face, so it is above more than one face.
+            for (int i = 0; i < nf; ++i) {
+                int* fnc = output.face_neighbors + 2*i;
+                if (output.face_tag[i] != K_FACE || fnc[0] == -1 || fnc[1] == -1
+                    || num_upper_faces[fnc[1]] < 2) {
+                    continue;
+                }
+                auto it = nnc[PinchNNC].lower_bound({global_cell[fnc[0]], 0});
+                if (it != nnc[PinchNNC].end() && it->first == global_cell[fnc[0]]
+                    && it->second == global_cell[fnc[1]]) {
+                    fnc[1] = -1;
+                }
+            }
+        }
+
         /// Encapsulate a vector<T>, and a permutation array used for access.
         template <typename T>
         class IndirectArray
@@ -897,44 +1245,6 @@ namespace cpgrid
             const int* end_;
         };
 
-        // Helper template for making Geometry objects.
-        // The generic one is suitable for dim == 0 (vertices).
-        template <int dim>
-        struct MakeGeometry
-        {
-            cpgrid::Geometry<dim, 3> operator()(const FieldVector<double, 3>& pos)
-            {
-                return cpgrid::Geometry<dim, 3>(pos);
-            }
-        };
-
-        // Specialization for cells.
-        template <>
-        struct MakeGeometry<3>
-        {
-            const cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3>& allcorners_;
-            MakeGeometry(const cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3>& allcorners)
-                : allcorners_(allcorners)
-            {
-            }
-            cpgrid::Geometry<3, 3> operator()(const FieldVector<double, 3>& pos,
-                                                      double vol,
-                                                      const std::array<int,8>& corner_indices)
-            {
-                return cpgrid::Geometry<3, 3>(pos, vol, allcorners_, &corner_indices[0]);
-            }
-        };
-
-        // Specialization for intersections.
-        template <>
-        struct MakeGeometry<2>
-        {
-            cpgrid::Geometry<2, 3> operator()(const FieldVector<double, 3>& pos, double vol)
-            {
-                return cpgrid::Geometry<2, 3>(pos, vol);
-            }
-        };
-
         void buildGeom(const processed_grid& output,
                        const cpgrid::OrientedEntityTable<0, 1>& c2f,
                        const std::vector<std::array<int,8> >& c2p,
@@ -943,160 +1253,171 @@ namespace cpgrid
                        cpgrid::EntityVariable<cpgrid::Geometry<2, 3>, 1>& face_geom,
                        cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3>& point_geom,
                        cpgrid::SignedEntityVariable<FieldVector<double, 3>, 1>& normals,
-                       bool turn_normals)
+                       bool turn_normals,
+                       const GeometryReuse* reuse)
         {
             typedef FieldVector<double, 3> point_t;
-            std::vector<point_t> points;
-            std::vector<point_t> face_normals;
-            std::vector<point_t> face_centroids;
-            std::vector<double>  face_areas;
-            std::vector<point_t> cell_centroids;
-            std::vector<double>  cell_volumes;
             using namespace GeometryHelpers;
-#ifdef VERBOSE
-            Ewoms::time::StopWatch clock;
-            clock.start();
+            Ewoms::time::PhaseProfiler::Scope phase("buildGeom");
+
+            // Every entity is computed independently of the others,
+            // and written to its own slot in the preallocated storage,
+            // so the result does not depend on the number of threads.
+            // The cells refer to the point geometries, and use the face
+            // centroids, so points go first and cells last.
+            const int np = output.number_of_nodes;
+            const int nf = face_to_output_face.size();
+            const int nc = output.number_of_cells;
+            const int* fn = output.face_nodes;
+            const int* fp = output.face_ptr;
+            std::vector<point_t> points(np);
+            {
+                Ewoms::time::PhaseProfiler::Scope sub_phase("points");
+                point_geom.assign(np, cpgrid::Geometry<0, 3>());
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
 #endif
-            // Get the points.
-            int np = output.number_of_nodes;
-            points.clear();
-            points.reserve(np);
-            for (int i = 0; i < np; ++i) {
-                // \TODO add a convenience explicit constructor
-                // for FieldVector taking an iterator.
-                point_t pt;
-                for (int dd = 0; dd < 3; ++dd) {
-                    pt[dd] = output.node_coordinates[3*i + dd];
+                for (int i = 0; i < np; ++i) {
+                    for (int dd = 0; dd < 3; ++dd) {
+                        points[i][dd] = output.node_coordinates[3*i + dd];
+                    }
+                    point_geom.get(i) = cpgrid::Geometry<0, 3>(points[i]);
                 }
-                points.push_back(pt);
             }
-#ifdef VERBOSE
-            std::cout << "Points:             " << clock.secsSinceLast() << std::endl;
-#endif
 
-            // Get the face data.
-            // \TODO Both the face and (especially) the cell section
-            // is not very efficient. It could be rewritten easily
-            // (focus on the polygonCellXXX methods first).
-            // \TODO Use exact geometry instead of these approximations.
-            int nf = face_to_output_face.size();
-            const int* fn = output.face_nodes;
-            const int* fp = output.face_ptr;
-            for (int face = 0; face < nf; ++face) {
-                // Computations in this loop could be speeded up
-                // by doing more of them simultaneously.
-                int output_face = face_to_output_face[face];
-                if (output_face == cpgrid::NNCFace) {
-                    // NNC faces are purely topological constructs,
-                    // and do not have any embedded geometry.
-                    // However, since the ewoms code will multiply and
-                    // divide by the face area even if not necessary
-                    // for the cell-centered FV discretization (because
-                    // it wants to deal with velocities rather than fluxes),
-                    // we have to set the areas to 1 to avoid trouble.
-                    face_normals.push_back({-1e100, -1e100, -1e100});
-                    face_centroids.push_back({-1e100, -1e100, -1e100});
-                    face_areas.push_back(1.0);
-                } else {
-                    IndirectArray<point_t> face_pts(points, fn + fp[output_face], fn + fp[output_face+1]);
-                    point_t avg = average(face_pts);
-                    point_t centroid = polygonCentroid(face_pts, avg);
-                    point_t normal = polygonNormal(face_pts, centroid);
-                    double area = polygonArea(face_pts, centroid);
-                    face_normals.push_back(normal);
-                    face_centroids.push_back(centroid);
-                    face_areas.push_back(area);
+            {
+                Ewoms::time::PhaseProfiler::Scope sub_phase("faces");
+                face_geom.assign(nf, cpgrid::Geometry<2, 3>());
+                normals.assign(nf, point_t(0.0));
+                const double sign = turn_normals ? -1.0 : 1.0;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
+                for (int face = 0; face < nf; ++face) {
+                    const int output_face = face_to_output_face[face];
+                    if (reuse && reuse->face_origin[face] != -1) {
+                        const int old_face = reuse->face_origin[face];
+                        normals.get(face) = reuse->face_normals[old_face];
+                        face_geom.get(face) = cpgrid::Geometry<2, 3>(reuse->face_centroids[old_face],
+                                                                     reuse->face_areas[old_face]);
+                    } else if (output_face == cpgrid::NNCFace) {
+                        // NNC faces are purely topological constructs,
+                        // and do not have any embedded geometry.
+                        // However, since the ewoms code will multiply and
+                        // divide by the face area even if not necessary
+                        // for the cell-centered FV discretization (because
+                        // it wants to deal with velocities rather than fluxes),
+                        // we have to set the areas to 1 to avoid trouble.
+                        normals.get(face) = point_t(-1e100);
+                        face_geom.get(face) = cpgrid::Geometry<2, 3>(point_t(-1e100), 1.0);
+                    } else {
+                        IndirectArray<point_t> face_pts(points, fn + fp[output_face], fn + fp[output_face+1]);
+                        point_t avg = average(face_pts);
+                        point_t centroid = polygonCentroid(face_pts, avg);
+                        normals.get(face) = polygonNormal(face_pts, centroid);
+                        face_geom.get(face) = cpgrid::Geometry<2, 3>(centroid, polygonArea(face_pts, centroid));
+                    }
+                    normals.get(face) *= sign;
                 }
             }
-#ifdef VERBOSE
-            std::cout << "Faces:              " << clock.secsSinceLast() << std::endl;
+
+            {
+                Ewoms::time::PhaseProfiler::Scope sub_phase("cells");
+                cell_geom.assign(nc, cpgrid::Geometry<3, 3>());
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
 #endif
-            // Get the cell data.
-            int nc = output.number_of_cells;
-            std::vector<int> face_indices;
-            for (int cell = 0; cell < nc; ++cell) {
-                cpgrid::EntityRep<0> cell_ent(cell, true);
-                cpgrid::OrientedEntityTable<0, 1>::row_type cf = c2f[cell_ent];
-                face_indices.clear();
-                for (int local_index = 0; local_index < cf.size(); ++local_index) {
-                    if (face_to_output_face[cf[local_index].index()] != cpgrid::NNCFace) {
-                        face_indices.push_back(cf[local_index].index());
+                for (int cell = 0; cell < nc; ++cell) {
+                    cpgrid::EntityRep<0> cell_ent(cell, true);
+                    cpgrid::OrientedEntityTable<0, 1>::row_type cf = c2f[cell_ent];
+                    if (reuse && reuse->cell_origin[cell] != -1) {
+                        // Unchanged if all of its geometric faces are.
+                        bool unchanged = true;
+                        for (int local_index = 0; local_index < cf.size(); ++local_index) {
+                            const int face = cf[local_index].index();
+                            if (face_to_output_face[face] != cpgrid::NNCFace && reuse->face_origin[face] == -1) {
+                                unchanged = false;
+                                break;
+                            }
+                        }
+                        if (unchanged) {
+                            const int old_cell = reuse->cell_origin[cell];
+                            cell_geom.get(cell) = cpgrid::Geometry<3, 3>(reuse->cell_centroids[old_cell],
+                                                                         reuse->cell_volumes[old_cell],
+                                                                         point_geom, &c2p[cell][0]);
+                            continue;
+                        }
                     }
-                }
-                IndirectArray<point_t> cell_pts(face_centroids, &face_indices[0], &face_indices[0] + face_indices.size());
-                point_t cell_avg = average(cell_pts);
-                point_t cell_centroid(0.0);
-                double tot_cell_vol = 0.0;
-                for (int local_index = 0; local_index < cf.size(); ++local_index) {
-                    int face = cf[local_index].index();
-                    int output_face = face_to_output_face[face];
-                    if (output_face == cpgrid::NNCFace) {
-                        // Skip NNC face, do not contribute to cell geometry.
-                        continue;
+                    // The average of the centroids of the geometric
+                    // faces, summed in the same order as average() does.
+                    point_t cell_avg(0.0);
+                    int num_geometric_faces = 0;
+                    for (int local_index = 0; local_index < cf.size(); ++local_index) {
+                        const int face = cf[local_index].index();
+                        if (face_to_output_face[face] != cpgrid::NNCFace) {
+                            cell_avg += face_geom.get(face).center();
+                            ++num_geometric_faces;
+                        }
+                    }
+                    assert(num_geometric_faces > 0);
+                    cell_avg /= double(num_geometric_faces);
+                    point_t cell_centroid(0.0);
+                    double tot_cell_vol = 0.0;
+                    bool hexahedron = (num_geometric_faces == 6);
+                    for (int local_index = 0; hexahedron && local_index < cf.size(); ++local_index) {
+                        const int output_face = face_to_output_face[cf[local_index].index()];
+                        hexahedron = (output_face == cpgrid::NNCFace)
+                            || (fp[output_face+1] - fp[output_face] == 4);
+                    }
+                    if (hexahedron) {
+                        // The common case of an unfaulted cell, with
+                        // fixed-size loops and the same result.
+                        point_t hex_pts[6][4];
+                        point_t hex_centroids[6];
+                        int hex_face = 0;
+                        for (int local_index = 0; local_index < cf.size(); ++local_index) {
+                            const int face = cf[local_index].index();
+                            const int output_face = face_to_output_face[face];
+                            if (output_face == cpgrid::NNCFace) {
+                                continue;
+                            }
+                            for (int i = 0; i < 4; ++i) {
+                                hex_pts[hex_face][i] = points[fn[fp[output_face] + i]];
+                            }
+                            hex_centroids[hex_face] = face_geom.get(face).center();
+                            ++hex_face;
+                        }
+                        tot_cell_vol = hexahedronCellVolumeCentroid(hex_pts, hex_centroids, cell_avg, cell_centroid);
+                    } else {
+                        for (int local_index = 0; local_index < cf.size(); ++local_index) {
+                            int face = cf[local_index].index();
+                            int output_face = face_to_output_face[face];
+                            if (output_face == cpgrid::NNCFace) {
+                                // Skip NNC face, do not contribute to cell geometry.
+                                continue;
+                            }
+                            const point_t face_centroid = face_geom.get(face).center();
+                            IndirectArray<point_t> face_pts(points, fn + fp[output_face], fn + fp[output_face+1]);
+                            double small_vol = polygonCellVolume(face_pts, face_centroid, cell_avg);
+                            tot_cell_vol += small_vol;
+                            point_t face_contrib = polygonCellCentroid(face_pts, face_centroid, cell_avg);
+                            face_contrib *= small_vol;
+                            cell_centroid += face_contrib;
+                        }
+                        cell_centroid /= tot_cell_vol;
                     }
-                    IndirectArray<point_t> face_pts(points, fn + fp[output_face], fn + fp[output_face+1]);
-                    double small_vol = polygonCellVolume(face_pts, face_centroids[face], cell_avg);
-                    tot_cell_vol += small_vol;
-                    point_t face_contrib = polygonCellCentroid(face_pts, face_centroids[face], cell_avg);
-                    face_contrib *= small_vol;
-                    cell_centroid += face_contrib;
-                }
-                cell_centroid /= tot_cell_vol;
 // #define HACK_CELL_CENTROIDS     // when this is defined, you get the average of top and bottom face centroids.
 #ifdef HACK_CELL_CENTROIDS
-                int numf = cf.size();
-                cell_centroid = face_centroids[face_indices[numf - 2]];
-                cell_centroid += face_centroids[face_indices[numf - 1]];
-                cell_centroid *= 0.5;
-#endif
-                cell_centroids.push_back(cell_centroid);
-                cell_volumes.push_back(tot_cell_vol);
-            }
-#ifdef VERBOSE
-            std::cout << "Cells:              " << clock.secsSinceLast() << std::endl;
+                    // The top and bottom faces come last.
+                    int numf = cf.size();
+                    cell_centroid = face_geom.get(cf[numf - 2].index()).center();
+                    cell_centroid += face_geom.get(cf[numf - 1].index()).center();
+                    cell_centroid *= 0.5;
 #endif
-
-            // \TODO Fix the code below , as it is:
-            // A) wasteful
-            // B) wordy,
-            // C) slow
-            // D) copied from readSintefLegacyFormat.cpp
-            // Points
-            // Points
-            point_geom.reserve(points.size());
-            MakeGeometry<0> mpointg;
-            std::transform(points.begin(), points.end(),
-                           std::back_inserter(point_geom), mpointg);
-            // Cells
-            cell_geom.reserve(nc);
-            MakeGeometry<3> mcellg(point_geom);
-//             std::transform(cell_centroids.begin(), cell_centroids.end(),
-//                            cell_volumes.begin(),
-//                            std::back_inserter(cell_geom, mcellg);
-            for (int c = 0;  c < nc; ++c) {
-                cell_geom.push_back(mcellg(cell_centroids[c], cell_volumes[c], c2p[c]));
-            }
-            // Faces
-            face_geom.reserve(face_centroids.size());
-            MakeGeometry<2> mfaceg;
-            std::transform(face_centroids.begin(), face_centroids.end(),
-                           face_areas.begin(),
-                           std::back_inserter(face_geom), mfaceg);
-#ifdef VERBOSE
-            std::cout << "Transforms/copies:  " << clock.secsSinceLast() << std::endl;
-#endif
-
-            // The final, combined object (yes, a lot of copying goes on here).
-            if (turn_normals) {
-                int num_normals = face_normals.size();
-                for (int i = 0; i < num_normals; ++i) {
-                    face_normals[i] *= -1.0;
+                    cell_geom.get(cell) = cpgrid::Geometry<3, 3>(cell_centroid, tot_cell_vol,
+                                                                 point_geom, &c2p[cell][0]);
                 }
             }
-            normals.assign(face_normals.begin(), face_normals.end());
-#ifdef VERBOSE
-            std::cout << "Final construction: " << clock.secsSinceLast() << std::endl;
-#endif
         }
     } // anon namespace
 } // namespace Dune
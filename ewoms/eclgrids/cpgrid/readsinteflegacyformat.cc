@@ -57,6 +57,7 @@ namespace Dune
                 EWOMS_THROW(std::runtime_error, "Could not open file " << topofilename);
             }
             readTopo(file, cell_to_face_, face_to_cell_, cell_to_point_);
+            resetCellNeighborGraph();
         }
         std::string geomfilename = grid_prefix + "-geom.dat";
         {
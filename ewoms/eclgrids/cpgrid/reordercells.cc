@@ -0,0 +1,363 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "cpgriddata.hh"
+#include "geometry.hh"
+
+namespace Dune
+{
+namespace cpgrid
+{
+
+namespace
+{
+    // The cells visited by a breadth-first search from start, level by
+    // level, among the cells not yet numbered.
+    int breadthFirstLevels(const CellNeighborGraph& graph, int start,
+                           const std::vector<char>& numbered,
+                           std::vector<int>& level, std::vector<int>& visited)
+    {
+        visited.clear();
+        visited.push_back(start);
+        level[start] = 0;
+        for (std::size_t i = 0; i < visited.size(); ++i) {
+            const int cell = visited[i];
+            for (const int nb : graph.neighbors(cell)) {
+                if (!numbered[nb] && level[nb] < 0) {
+                    level[nb] = level[cell] + 1;
+                    visited.push_back(nb);
+                }
+            }
+        }
+        return level[visited.back()];
+    }
+
+    // Reverse Cuthill-McKee, with each connected component started from
+    // a pseudo-peripheral cell.
+    std::vector<int> reverseCuthillMcKee(const CellNeighborGraph& graph)
+    {
+        const int num_cells = graph.numCells();
+        std::vector<int> degree(num_cells);
+        for (int cell = 0; cell < num_cells; ++cell) {
+            degree[cell] = graph.neighbors(cell).size();
+        }
+        auto by_degree = [&degree](int a, int b) {
+            return std::make_tuple(degree[a], a) < std::make_tuple(degree[b], b);
+        };
+        std::vector<int> candidates(num_cells);
+        std::iota(candidates.begin(), candidates.end(), 0);
+        std::sort(candidates.begin(), candidates.end(), by_degree);
+
+        std::vector<int> order;
+        order.reserve(num_cells);
+        std::vector<char> numbered(num_cells, 0);
+        std::vector<int> level(num_cells, -1);
+        std::vector<int> visited;
+        std::vector<int> next;
+        for (const int candidate : candidates) {
+            if (numbered[candidate]) {
+                continue;
+            }
+            // Move to a cell of least degree in the last level for as long
+            // as that increases the depth of the search.
+            int start = candidate;
+            int depth = breadthFirstLevels(graph, start, numbered, level, visited);
+            for (;;) {
+                int far = -1;
+                for (const int cell : visited) {
+                    if (level[cell] == depth && (far < 0 || by_degree(cell, far))) {
+                        far = cell;
+                    }
+                }
+                for (const int cell : visited) {
+                    level[cell] = -1;
+                }
+                const int far_depth = breadthFirstLevels(graph, far, numbered, level, visited);
+                if (far_depth <= depth) {
+                    for (const int cell : visited) {
+                        level[cell] = -1;
+                    }
+                    break;
+                }
+                start = far;
+                depth = far_depth;
+            }
+
+            // Cuthill-McKee from the start cell, visiting the neighbours of
+            // each cell by increasing degree.
+            std::size_t head = order.size();
+            order.push_back(start);
+            numbered[start] = 1;
+            for (; head < order.size(); ++head) {
+                next.clear();
+                for (const int nb : graph.neighbors(order[head])) {
+                    if (!numbered[nb]) {
+                        numbered[nb] = 1;
+                        next.push_back(nb);
+                    }
+                }
+                std::sort(next.begin(), next.end(), by_degree);
+                order.insert(order.end(), next.begin(), next.end());
+            }
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // The index along a three-dimensional Hilbert curve of a point with
+    // coordinates of the given number of bits, by the method of Skilling,
+    // "Programming the Hilbert curve", AIP Conf. Proc. 707 (2004).
+    std::uint64_t hilbertIndex(std::array<std::uint32_t, 3> x, int bits)
+    {
+        const std::uint32_t top = std::uint32_t(1) << (bits - 1);
+        for (std::uint32_t q = top; q > 1; q >>= 1) {
+            const std::uint32_t p = q - 1;
+            for (int i = 0; i < 3; ++i) {
+                if (x[i] & q) {
+                    x[0] ^= p;
+                } else {
+                    const std::uint32_t t = (x[0] ^ x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+        for (int i = 1; i < 3; ++i) {
+            x[i] ^= x[i - 1];
+        }
+        std::uint32_t t = 0;
+        for (std::uint32_t q = top; q > 1; q >>= 1) {
+            if (x[2] & q) {
+                t ^= q - 1;
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            x[i] ^= t;
+        }
+        std::uint64_t index = 0;
+        for (int bit = bits - 1; bit >= 0; --bit) {
+            for (int i = 0; i < 3; ++i) {
+                index = (index << 1) | ((x[i] >> bit) & 1);
+            }
+        }
+        return index;
+    }
+
+    // The cells by the position of their centroids along a Hilbert curve
+    // through the bounding box of the centroids.
+    std::vector<int> hilbertOrder(const std::vector<FieldVector<double, 3> >& centroids)
+    {
+        const int bits = 21;
+        const int num_cells = centroids.size();
+        FieldVector<double, 3> lo(std::numeric_limits<double>::max());
+        FieldVector<double, 3> hi(-std::numeric_limits<double>::max());
+        for (const auto& c : centroids) {
+            for (int dd = 0; dd < 3; ++dd) {
+                lo[dd] = std::min(lo[dd], c[dd]);
+                hi[dd] = std::max(hi[dd], c[dd]);
+            }
+        }
+        // Scale all axes alike, to keep the curve from being stretched.
+        double extent = 0.0;
+        for (int dd = 0; dd < 3; ++dd) {
+            extent = std::max(extent, hi[dd] - lo[dd]);
+        }
+        const double cells_per_unit = extent > 0.0 ? ((1 << bits) - 1) / extent : 0.0;
+        std::vector<std::uint64_t> key(num_cells);
+        for (int cell = 0; cell < num_cells; ++cell) {
+            std::array<std::uint32_t, 3> x;
+            for (int dd = 0; dd < 3; ++dd) {
+                x[dd] = static_cast<std::uint32_t>((centroids[cell][dd] - lo[dd]) * cells_per_unit);
+            }
+            key[cell] = hilbertIndex(x, bits);
+        }
+        std::vector<int> order(num_cells);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&key](int a, int b) {
+            return std::make_tuple(key[a], a) < std::make_tuple(key[b], b);
+        });
+        return order;
+    }
+
+    std::vector<int> inversePermutation(const std::vector<int>& order)
+    {
+        std::vector<int> inverse(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            inverse[order[i]] = i;
+        }
+        return inverse;
+    }
+} // anonymous namespace
+
+void CpGridData::reorderCells(CellOrdering ordering, std::vector<int>& cell_order,
+                              std::vector<int>& face_order)
+{
+    if (ccobj_.size() > 1) {
+        EWOMS_THROW(std::logic_error, "Reordering the cells is only supported in sequential runs.");
+    }
+    const int nc = cell_to_face_.size();
+    const int nf = face_to_cell_.size();
+
+    switch (ordering) {
+    case CellOrdering::ReverseCuthillMcKee:
+        cell_order = reverseCuthillMcKee(cellNeighborGraph());
+        break;
+    case CellOrdering::Hilbert:
+        cell_order = hilbertOrder(geometry_.cellCentroids());
+        break;
+    default:
+        EWOMS_THROW(std::logic_error, "Unknown cell ordering " << static_cast<int>(ordering));
+    }
+    const std::vector<int> new_cell = inversePermutation(cell_order);
+
+    // Sort the faces by the lower and then the higher new index of their
+    // cells, boundary faces last among the faces of their cell.
+    std::vector<std::pair<int, int> > face_cells(nf);
+    for (int f = 0; f < nf; ++f) {
+        const auto cells = face_to_cell_[EntityRep<1>(f, true)];
+        const int c0 = new_cell[cells[0].index()];
+        const int c1 = cells.size() > 1 ? new_cell[cells[1].index()] : std::numeric_limits<int>::max();
+        face_cells[f] = std::make_pair(std::min(c0, c1), std::max(c0, c1));
+    }
+    face_order.resize(nf);
+    std::iota(face_order.begin(), face_order.end(), 0);
+    std::stable_sort(face_order.begin(), face_order.end(), [&face_cells](int a, int b) {
+        return face_cells[a] < face_cells[b];
+    });
+    const std::vector<int> new_face = inversePermutation(face_order);
+
+    // Topology.
+    {
+        std::vector<EntityRep<1> > data;
+        std::vector<int> sizes(nc);
+        data.reserve(cell_to_face_.dataSize());
+        for (int c = 0; c < nc; ++c) {
+            const auto row = cell_to_face_[EntityRep<0>(cell_order[c], true)];
+            sizes[c] = row.size();
+            for (int j = 0; j < row.size(); ++j) {
+                data.emplace_back(new_face[row[j].index()], row[j].orientation());
+            }
+        }
+        cell_to_face_ = OrientedEntityTable<0, 1>(data.begin(), data.end(), sizes.begin(), sizes.end());
+    }
+    {
+        std::vector<EntityRep<0> > data;
+        std::vector<int> sizes(nf);
+        data.reserve(face_to_cell_.dataSize());
+        for (int f = 0; f < nf; ++f) {
+            const auto row = face_to_cell_[EntityRep<1>(face_order[f], true)];
+            sizes[f] = row.size();
+            for (int j = 0; j < row.size(); ++j) {
+                data.emplace_back(new_cell[row[j].index()], row[j].orientation());
+            }
+        }
+        face_to_cell_ = OrientedEntityTable<1, 0>(data.begin(), data.end(), sizes.begin(), sizes.end());
+    }
+    {
+        std::vector<int> data;
+        std::vector<int> sizes(nf);
+        data.reserve(face_to_point_.dataSize());
+        for (int f = 0; f < nf; ++f) {
+            const auto row = face_to_point_[face_order[f]];
+            sizes[f] = row.size();
+            data.insert(data.end(), row.begin(), row.end());
+        }
+        face_to_point_ = Ewoms::SparseTable<int>(data.begin(), data.end(), sizes.begin(), sizes.end());
+    }
+    {
+        // Grids read in the legacy format have no cell corners.
+        std::vector<std::array<int, 8> > c2p(cell_to_point_.empty() ? 0 : nc);
+        std::vector<int> global_cell(global_cell_.empty() ? 0 : nc);
+        for (int c = 0; c < nc; ++c) {
+            if (!cell_to_point_.empty()) {
+                c2p[c] = cell_to_point_[cell_order[c]];
+            }
+            if (!global_cell_.empty()) {
+                global_cell[c] = global_cell_[cell_order[c]];
+            }
+        }
+        cell_to_point_.swap(c2p);
+        global_cell_.swap(global_cell);
+    }
+
+    // Face data.
+    {
+        std::vector<enum face_tag> tags(nf);
+        std::vector<PointType> normals(nf);
+        for (int f = 0; f < nf; ++f) {
+            tags[f] = face_tag_.get(face_order[f]);
+            normals[f] = face_normals_.get(face_order[f]);
+        }
+        face_tag_.assign(tags.begin(), tags.end());
+        face_normals_.assign(normals.begin(), normals.end());
+        if (!unique_boundary_ids_.empty()) {
+            std::vector<int> ids(nf);
+            for (int f = 0; f < nf; ++f) {
+                ids[f] = unique_boundary_ids_.get(face_order[f]);
+            }
+            unique_boundary_ids_.assign(ids.begin(), ids.end());
+        }
+    }
+
+    // Geometry.  The cell geometries refer to their corners in
+    // cell_to_point_, and are therefore made anew, on the copy of the
+    // points that the geometry policy takes over.
+    {
+        cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3> point_geom(geometry_.geomVector<3>());
+        const auto& face_geom = geometry_.geomVector<1>();
+        const auto& cell_geom = geometry_.geomVector<0>();
+        std::vector<cpgrid::Geometry<2, 3> > faces;
+        faces.reserve(nf);
+        for (int f = 0; f < nf; ++f) {
+            faces.push_back(face_geom.get(face_order[f]));
+        }
+        std::vector<cpgrid::Geometry<3, 3> > cells;
+        cells.reserve(nc);
+        for (int c = 0; c < nc; ++c) {
+            const auto& g = cell_geom.get(cell_order[c]);
+            if (cell_to_point_.empty()) {
+                cells.push_back(cpgrid::Geometry<3, 3>(g.center(), g.volume()));
+            } else {
+                cells.push_back(cpgrid::Geometry<3, 3>(g.center(), g.volume(), point_geom, &cell_to_point_[c][0]));
+            }
+        }
+        cpgrid::EntityVariable<cpgrid::Geometry<2, 3>, 1> new_face_geom;
+        new_face_geom.assign(faces.begin(), faces.end());
+        cpgrid::EntityVariable<cpgrid::Geometry<3, 3>, 0> new_cell_geom;
+        new_cell_geom.assign(cells.begin(), cells.end());
+        geometry_.setGeometries(std::move(new_cell_geom), std::move(new_face_geom), std::move(point_geom));
+    }
+    resetCellNeighborGraph();
+    can_update_eclipse_format_ = false;
+}
+
+} // namespace cpgrid
+} // namespace Dune
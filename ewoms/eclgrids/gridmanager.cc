@@ -149,7 +149,9 @@ namespace Ewoms
         }
 
         const double z_tolerance = inputGrid.isPinchActive() ? inputGrid.getPinchThresholdThickness() : 0.0;
-        ug_ = create_grid_cornerpoint(&g, z_tolerance);
+        // The zcorn vector is ours, so let the processing reorder it in
+        // place instead of making another copy of it.
+        ug_ = create_grid_cornerpoint_inplace(&g, zcorn.data(), z_tolerance);
         if (!ug_) {
             EWOMS_THROW(std::runtime_error, "Failed to construct grid.");
         }
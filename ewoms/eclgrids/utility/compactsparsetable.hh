@@ -0,0 +1,321 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EWOMS_COMPACTSPARSETABLE_HEADER
+#define EWOMS_COMPACTSPARSETABLE_HEADER
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <boost/range/iterator_range.hpp>
+#include <ewoms/eclio/errormacros.hh>
+
+#include <ostream>
+
+namespace Ewoms
+{
+
+    /// A CompactSparseTable stores a table with rows of varying size,
+    /// with the interface of SparseTable but smaller row bookkeeping.
+    ///
+    /// Instead of one int per row start, the starts of every 64th row
+    /// are stored in full, and the start of each row as a 16 bit offset
+    /// from the start of its block of 64 rows.  This takes a little over
+    /// 2 bytes per row instead of 4.  Row starts that do not fit the
+    /// offset, which needs more than 65535 entries in the rows before it
+    /// in the same block, are kept in a sorted list of exceptions.  The
+    /// table data itself is stored as in SparseTable, so rows are still
+    /// contiguous ranges of T.
+    template <typename T>
+    class CompactSparseTable
+    {
+    public:
+        /// Default constructor. Yields an empty CompactSparseTable.
+        CompactSparseTable()
+        {
+            pushRowStart(0);
+        }
+
+        /// A constructor taking all the data for the table and row sizes.
+        /// \param data_beg The start of the table data.
+        /// \param data_end One-beyond-end of the table data.
+        /// \param rowsize_beg The start of the row length data.
+        /// \param rowsize_end One beyond the end of the row length data.
+        template <typename DataIter, typename IntegerIter>
+        CompactSparseTable(DataIter data_beg, DataIter data_end,
+                           IntegerIter rowsize_beg, IntegerIter rowsize_end)
+            : data_(data_beg, data_end)
+        {
+            setRowStartsFromSizes(rowsize_beg, rowsize_end);
+        }
+
+        /// Sets the table to contain the given data, organized into
+        /// rows as indicated by the given row sizes.
+        /// \param data_beg The start of the table data.
+        /// \param data_end One-beyond-end of the table data.
+        /// \param rowsize_beg The start of the row length data.
+        /// \param rowsize_end One beyond the end of the row length data.
+        template <typename DataIter, typename IntegerIter>
+        void assign(DataIter data_beg, DataIter data_end,
+                    IntegerIter rowsize_beg, IntegerIter rowsize_end)
+        {
+            data_.assign(data_beg, data_end);
+            setRowStartsFromSizes(rowsize_beg, rowsize_end);
+        }
+
+        /// Request storage for table of given size.
+        /// \param rowsize_beg Start of row size data.
+        /// \param rowsize_end One beyond end of row size data.
+        template <typename IntegerIter>
+        void allocate(IntegerIter rowsize_beg, IntegerIter rowsize_end)
+        {
+            typedef typename std::vector<T>::size_type sz_t;
+
+            sz_t ndata = std::accumulate(rowsize_beg, rowsize_end, sz_t(0));
+            data_.resize(ndata);
+            setRowStartsFromSizes(rowsize_beg, rowsize_end);
+        }
+
+        /// Appends a row to the table.
+        template <typename DataIter>
+        void appendRow(DataIter row_beg, DataIter row_end)
+        {
+            data_.insert(data_.end(), row_beg, row_end);
+            pushRowStart(data_.size());
+        }
+
+        /// True if the table contains no rows.
+        bool empty() const
+        {
+            return row_offset_.size()==1;
+        }
+
+        /// Returns the number of rows in the table.
+        int size() const
+        {
+            return row_offset_.size() - 1;
+        }
+
+        /// Allocate storage for table of expected size
+        void reserve(int exptd_nrows, int exptd_ndata)
+        {
+            row_offset_.reserve(exptd_nrows + 1);
+            block_start_.reserve(exptd_nrows/block_size + 2);
+            data_.reserve(exptd_ndata);
+        }
+
+        /// Swap contents for other CompactSparseTable<T>
+        void swap(CompactSparseTable<T>& other)
+        {
+            data_.swap(other.data_);
+            block_start_.swap(other.block_start_);
+            row_offset_.swap(other.row_offset_);
+            large_starts_.swap(other.large_starts_);
+        }
+
+        /// Returns the number of data elements.
+        int dataSize() const
+        {
+            return data_.size();
+        }
+
+        /// Returns the size of a table row.
+        int rowSize(int row) const
+        {
+#ifndef NDEBUG
+            EWOMS_ERROR_IF(row < 0 || row >= size(), "Row index " << row << " is out of range");
+#endif
+            return rowStart(row + 1) - rowStart(row);
+        }
+
+        /// Makes the table empty().
+        void clear()
+        {
+            data_.clear();
+            block_start_.clear();
+            row_offset_.clear();
+            large_starts_.clear();
+            pushRowStart(0);
+        }
+
+        /// Defining the row type, returned by operator[].
+        typedef boost::iterator_range<const T*> row_type;
+        typedef boost::iterator_range<T*>       mutable_row_type;
+
+        /// Returns a row of the table.
+        row_type operator[](int row) const
+        {
+            assert(row >= 0 && row < size());
+            const T* start_ptr = data_.data();
+            return row_type(start_ptr + rowStart(row), start_ptr + rowStart(row + 1));
+        }
+
+        /// Returns a mutable row of the table.
+        mutable_row_type operator[](int row)
+        {
+            assert(row >= 0 && row < size());
+            T* start_ptr = data_.data();
+            return mutable_row_type(start_ptr + rowStart(row), start_ptr + rowStart(row + 1));
+        }
+
+        /// Iterator for iterating over the container as a whole,
+        /// i.e. row by row.
+        class Iterator
+        {
+        public:
+            Iterator(const CompactSparseTable& table, const int begin_row_index)
+                : table_(table)
+                , row_index_(begin_row_index)
+            {
+            }
+            Iterator& operator++()
+            {
+                ++row_index_;
+                return *this;
+            }
+            row_type operator*() const
+            {
+                return table_[row_index_];
+            }
+            bool operator==(const Iterator& other)
+            {
+                assert(&table_ == &other.table_);
+                return row_index_ == other.row_index_;
+            }
+            bool operator!=(const Iterator& other)
+            {
+                return !(*this == other);
+            }
+        private:
+            const CompactSparseTable& table_;
+            int row_index_;
+        };
+
+        /// Iterator access.
+        Iterator begin() const
+        {
+            return Iterator(*this, 0);
+        }
+        Iterator end() const
+        {
+            return Iterator(*this, size());
+        }
+
+        /// Equality.
+        bool operator==(const CompactSparseTable& other) const
+        {
+            return data_ == other.data_ && block_start_ == other.block_start_
+                && row_offset_ == other.row_offset_ && large_starts_ == other.large_starts_;
+        }
+
+        template<class charT, class traits>
+        void print(std::basic_ostream<charT, traits>& os) const
+        {
+            os << "Number of rows: " << size() << '\n';
+
+            os << "Row starts = [";
+            for (int row = 0; row <= size(); ++row) {
+                os << rowStart(row) << ' ';
+            }
+            os << "\b]\n";
+
+            os << "Data values = [";
+            std::copy(data_.begin(), data_.end(),
+                      std::ostream_iterator<T>(os, " "));
+            os << "\b]\n";
+        }
+        const T data(int i)const {
+            return data_[i];
+        }
+
+    private:
+        enum { block_size = 64 };
+        // Marks a row start that is found in large_starts_.
+        enum { large_offset = 0xffff };
+
+        std::vector<T> data_;
+        // The start of the first row of each block of block_size rows.
+        std::vector<int> block_start_;
+        // The start of each row relative to the start of its block, one
+        // more than the number of rows as in the compressed row format.
+        std::vector<std::uint16_t> row_offset_;
+        // The (row, start) of the rows marked with large_offset, by row.
+        std::vector<std::pair<int, int> > large_starts_;
+
+        int rowStart(int row) const
+        {
+            const std::uint16_t offset = row_offset_[row];
+            if (offset != large_offset) {
+                return block_start_[row / block_size] + offset;
+            }
+            return std::lower_bound(large_starts_.begin(), large_starts_.end(),
+                                    std::make_pair(row, 0))->second;
+        }
+
+        void pushRowStart(int start)
+        {
+            const int row = row_offset_.size();
+            if (row % block_size == 0) {
+                block_start_.push_back(start);
+            }
+            const int offset = start - block_start_.back();
+            if (offset < large_offset) {
+                row_offset_.push_back(offset);
+            } else {
+                row_offset_.push_back(large_offset);
+                large_starts_.emplace_back(row, start);
+            }
+        }
+
+        template <class IntegerIter>
+        void setRowStartsFromSizes(IntegerIter rowsize_beg, IntegerIter rowsize_end)
+        {
+#ifndef NDEBUG
+            // Check that all row sizes given are nonnegative.
+            for (auto it = rowsize_beg; it != rowsize_end; ++it) {
+                if (*it < 0) {
+                    EWOMS_THROW(std::runtime_error, "Negative row size given.");
+                }
+            }
+#endif
+            const int num_rows = rowsize_end - rowsize_beg;
+            block_start_.clear();
+            row_offset_.clear();
+            large_starts_.clear();
+            row_offset_.reserve(num_rows + 1);
+            block_start_.reserve(num_rows/block_size + 2);
+            int start = 0;
+            pushRowStart(start);
+            for (auto it = rowsize_beg; it != rowsize_end; ++it) {
+                start += *it;
+                pushRowStart(start);
+            }
+            if (start != int(data_.size())) {
+                EWOMS_THROW(std::runtime_error, "End of row start indices different from data size.");
+            }
+        }
+
+    };
+
+} // namespace Ewoms
+
+#endif // EWOMS_COMPACTSPARSETABLE_HEADER
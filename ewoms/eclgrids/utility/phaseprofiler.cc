@@ -0,0 +1,291 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <utility>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace Ewoms
+{
+
+    namespace time
+    {
+
+        namespace
+        {
+            // Separates the names in a path, and the paths.
+            const char name_separator = '\x1f';
+            const char path_separator = '\n';
+
+            void writeString(std::ostream& os, const std::string& s)
+            {
+                os << '"';
+                for (const char c : s) {
+                    if (c == '"' || c == '\\') {
+                        os << '\\' << c;
+                    } else if (static_cast<unsigned char>(c) < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof buf, "\\u%04x", static_cast<unsigned>(c));
+                        os << buf;
+                    } else {
+                        os << c;
+                    }
+                }
+                os << '"';
+            }
+
+            void writePhase(std::ostream& os, const PhaseProfiler::Phase& phase, const std::string& indent)
+            {
+                os << indent << "{\n";
+                const std::string in = indent + "  ";
+                os << in << "\"name\": ";
+                writeString(os, phase.name);
+                os << ",\n" << in << "\"calls\": " << phase.calls
+                   << ",\n" << in << "\"seconds\": " << phase.seconds
+                   << ",\n" << in << "\"memory_bytes\": " << phase.memory_bytes;
+                if (phase.ranks > 0) {
+                    os << ",\n" << in << "\"ranks\": " << phase.ranks;
+                    const PhaseProfiler::RankStatistics* stats[2] = { &phase.seconds_stats, &phase.memory_stats };
+                    const char* quantities[2] = { "seconds", "memory_bytes" };
+                    for (int q = 0; q < 2; ++q) {
+                        os << ",\n" << in << "\"" << quantities[q] << "_min\": " << stats[q]->min
+                           << ",\n" << in << "\"" << quantities[q] << "_max\": " << stats[q]->max
+                           << ",\n" << in << "\"" << quantities[q] << "_avg\": " << stats[q]->avg;
+                    }
+                }
+                os << ",\n" << in << "\"children\": [";
+                for (std::size_t i = 0; i < phase.children.size(); ++i) {
+                    os << (i == 0 ? "\n" : ",\n");
+                    writePhase(os, phase.children[i], in + "  ");
+                }
+                os << (phase.children.empty() ? "]\n" : "\n" + in + "]\n");
+                os << indent << "}";
+            }
+        } // anon namespace
+
+        const PhaseProfiler::Phase* PhaseProfiler::Phase::child(const std::string& child_name) const
+        {
+            for (const auto& c : children) {
+                if (c.name == child_name) {
+                    return &c;
+                }
+            }
+            return nullptr;
+        }
+
+        PhaseProfiler::Scope::Scope(const std::string& name, PhaseProfiler& profiler)
+            : profiler_(profiler),
+              memory_(PhaseProfiler::residentMemory()),
+              active_(true)
+        {
+            profiler_.enter(name);
+            watch_.start();
+        }
+
+        PhaseProfiler::Scope::~Scope()
+        {
+            stop();
+        }
+
+        void PhaseProfiler::Scope::stop()
+        {
+            if (active_) {
+                watch_.stop();
+                profiler_.leave(watch_.secsSinceStart(), PhaseProfiler::residentMemory() - memory_);
+                active_ = false;
+            }
+        }
+
+        PhaseProfiler::PhaseProfiler()
+        {
+            clear();
+        }
+
+        PhaseProfiler& PhaseProfiler::global()
+        {
+            static PhaseProfiler profiler;
+            return profiler;
+        }
+
+        void PhaseProfiler::clear()
+        {
+            assert(stack_.size() <= 1);
+            root_ = Phase();
+            stack_.assign(1, &root_);
+        }
+
+        void PhaseProfiler::writeJSON(std::ostream& os) const
+        {
+            os << "{\n  \"phases\": [";
+            for (std::size_t i = 0; i < root_.children.size(); ++i) {
+                os << (i == 0 ? "\n" : ",\n");
+                writePhase(os, root_.children[i], "    ");
+            }
+            os << (root_.children.empty() ? "]\n" : "\n  ]\n") << "}\n";
+        }
+
+        double PhaseProfiler::residentMemory()
+        {
+#if defined(__linux__)
+            // The second field of statm is the resident set in pages.
+            std::FILE* statm = std::fopen("/proc/self/statm", "r");
+            if (statm == nullptr) {
+                return 0.0;
+            }
+            long size = 0, resident = 0;
+            const int n = std::fscanf(statm, "%ld %ld", &size, &resident);
+            std::fclose(statm);
+            if (n != 2) {
+                return 0.0;
+            }
+            return static_cast<double>(resident) * sysconf(_SC_PAGESIZE);
+#else
+            return 0.0;
+#endif
+        }
+
+        void PhaseProfiler::enter(const std::string& name)
+        {
+            Phase& parent = *stack_.back();
+            for (auto& child : parent.children) {
+                if (child.name == name) {
+                    stack_.push_back(&child);
+                    return;
+                }
+            }
+            parent.children.emplace_back();
+            parent.children.back().name = name;
+            stack_.push_back(&parent.children.back());
+        }
+
+        void PhaseProfiler::leave(double seconds, double memory_bytes)
+        {
+            assert(stack_.size() > 1);
+            Phase& phase = *stack_.back();
+            ++phase.calls;
+            phase.seconds += seconds;
+            phase.memory_bytes += memory_bytes;
+            stack_.pop_back();
+        }
+
+        void PhaseProfiler::flatten(Phase& phase, const std::string& path,
+                                    std::vector<std::string>& paths, std::vector<Phase*>& phases)
+        {
+            for (auto& child : phase.children) {
+                const std::string child_path = path.empty() ? child.name : path + name_separator + child.name;
+                paths.push_back(child_path);
+                phases.push_back(&child);
+                flatten(child, child_path, paths, phases);
+            }
+        }
+
+        PhaseProfiler::Phase& PhaseProfiler::findOrAdd(const std::string& path)
+        {
+            Phase* phase = &root_;
+            std::string::size_type begin = 0;
+            while (begin <= path.size()) {
+                std::string::size_type end = path.find(name_separator, begin);
+                if (end == std::string::npos) {
+                    end = path.size();
+                }
+                const std::string name = path.substr(begin, end - begin);
+                Phase* next = nullptr;
+                for (auto& child : phase->children) {
+                    if (child.name == name) {
+                        next = &child;
+                        break;
+                    }
+                }
+                if (next == nullptr) {
+                    phase->children.emplace_back();
+                    phase->children.back().name = name;
+                    next = &phase->children.back();
+                }
+                phase = next;
+                begin = end + 1;
+            }
+            return *phase;
+        }
+
+        namespace
+        {
+            void orderChildren(PhaseProfiler::Phase& phase, const std::string& path,
+                               const std::map<std::string, int>& position)
+            {
+                std::vector<std::pair<int, PhaseProfiler::Phase*> > order;
+                for (auto& child : phase.children) {
+                    const std::string child_path = path.empty() ? child.name : path + name_separator + child.name;
+                    order.emplace_back(position.at(child_path), &child);
+                    orderChildren(child, child_path, position);
+                }
+                std::sort(order.begin(), order.end());
+                std::vector<PhaseProfiler::Phase> children;
+                children.reserve(order.size());
+                for (const auto& entry : order) {
+                    children.push_back(std::move(*entry.second));
+                }
+                phase.children.swap(children);
+            }
+        }
+
+        void PhaseProfiler::orderLike(const std::vector<std::string>& paths)
+        {
+            std::map<std::string, int> position;
+            for (int i = 0; i < static_cast<int>(paths.size()); ++i) {
+                position.insert(std::make_pair(paths[i], i));
+            }
+            orderChildren(root_, std::string(), position);
+        }
+
+        std::string PhaseProfiler::joinPaths(const std::vector<std::string>& paths)
+        {
+            std::string joined;
+            for (const auto& path : paths) {
+                joined += path;
+                joined += path_separator;
+            }
+            return joined;
+        }
+
+        void PhaseProfiler::splitPaths(const std::vector<char>& chars, std::vector<std::string>& paths)
+        {
+            std::string path;
+            for (const char c : chars) {
+                if (c == path_separator) {
+                    paths.push_back(path);
+                    path.clear();
+                } else {
+                    path += c;
+                }
+            }
+        }
+
+    } // namespace time
+
+} // namespace Ewoms
@@ -0,0 +1,223 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EWOMS_PHASEPROFILER_HEADER
+#define EWOMS_PHASEPROFILER_HEADER
+
+#include <ewoms/eclgrids/utility/stopwatch.hh>
+
+#include <cassert>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace Ewoms
+{
+
+    namespace time
+    {
+
+        /// Hierarchical record of the wall-clock time and the change of
+        /// resident memory of named phases, such as those of grid
+        /// construction and distribution.
+        ///
+        /// Phases are recorded by PhaseProfiler::Scope objects, and nest
+        /// like the scopes.  Repeated scopes of the same name within the
+        /// same phase accumulate.  Not thread-safe, phases are meant to be
+        /// entered by the main thread only.
+        class PhaseProfiler
+        {
+        public:
+            /// Statistics of a quantity across the ranks that have a phase.
+            struct RankStatistics
+            {
+                double min = 0.0;
+                double max = 0.0;
+                double avg = 0.0;
+            };
+
+            struct Phase
+            {
+                std::string name;
+                /// Number of times the phase was entered on this rank.
+                int calls = 0;
+                /// Total time spent in the phase on this rank.
+                double seconds = 0.0;
+                /// Total change of resident memory in the phase on this
+                /// rank, in bytes.  Zero where this is not available.
+                double memory_bytes = 0.0;
+                /// Number of ranks that have the phase, and the statistics
+                /// of seconds and memory_bytes across them.  Only set by
+                /// aggregate().
+                int ranks = 0;
+                RankStatistics seconds_stats;
+                RankStatistics memory_stats;
+                std::vector<Phase> children;
+
+                /// \return the child phase of the given name, or nullptr.
+                const Phase* child(const std::string& child_name) const;
+            };
+
+            /// Records a phase while in scope.
+            class Scope
+            {
+            public:
+                /// Enters the phase of the given name within the
+                /// innermost phase of the profiler that is in scope.
+                explicit Scope(const std::string& name,
+                               PhaseProfiler& profiler = PhaseProfiler::global());
+                /// Leaves the phase unless stop() was called.
+                ~Scope();
+
+                /// Leaves the phase before the end of the scope.  Scopes
+                /// must be left in the reverse order they were entered.
+                void stop();
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            private:
+                PhaseProfiler& profiler_;
+                StopWatch watch_;
+                double memory_;
+                bool active_;
+            };
+
+            PhaseProfiler();
+
+            /// The profiler of the process, used by the grid construction
+            /// and distribution.
+            static PhaseProfiler& global();
+
+            /// The root of the phases, its children are the outermost
+            /// phases.
+            const Phase& root() const
+            {
+                return root_;
+            }
+
+            /// Forget all phases.  Must not be called while in a Scope.
+            void clear();
+
+            /// Compute the statistics of all phases across the ranks of
+            /// comm.  Phases that only exist on other ranks are added with
+            /// zero calls, such that every rank holds the same tree.
+            /// Collective, must not be called while in a Scope.
+            /// \tparam Communication a Dune::CollectiveCommunication.
+            template <class Communication>
+            void aggregate(const Communication& comm);
+
+            /// Write the phases as JSON, an object with the array of the
+            /// outermost phases as "phases".
+            void writeJSON(std::ostream& os) const;
+
+            /// \return the resident memory of the process in bytes, or
+            /// zero if this is not available on the platform.
+            static double residentMemory();
+
+        private:
+            Phase root_;
+            std::vector<Phase*> stack_;
+
+            void enter(const std::string& name);
+            void leave(double seconds, double memory_bytes);
+
+            // Pre-order list of the phases, with their paths.
+            void flatten(Phase& phase, const std::string& path,
+                         std::vector<std::string>& paths, std::vector<Phase*>& phases);
+            Phase& findOrAdd(const std::string& path);
+            // Sort the children of every phase by the position of their
+            // paths in the given list, which must contain all paths.
+            void orderLike(const std::vector<std::string>& paths);
+            static std::string joinPaths(const std::vector<std::string>& paths);
+            static void splitPaths(const std::vector<char>& chars, std::vector<std::string>& paths);
+        };
+
+        template <class Communication>
+        void PhaseProfiler::aggregate(const Communication& comm)
+        {
+            assert(stack_.size() == 1);
+
+            // The union of the phases of all ranks, by path.
+            std::vector<std::string> paths;
+            std::vector<Phase*> phases;
+            flatten(root_, std::string(), paths, phases);
+            const std::string local = joinPaths(paths);
+            int length = local.size();
+            std::vector<int> lengths(comm.size());
+            comm.allgather(&length, 1, lengths.data());
+            std::vector<int> displ(comm.size() + 1, 0);
+            for (int r = 0; r < comm.size(); ++r) {
+                displ[r + 1] = displ[r] + lengths[r];
+            }
+            std::vector<char> all(displ.back() + 1);
+            comm.allgatherv(local.data(), length, all.data(), lengths.data(), displ.data());
+            all.pop_back();
+            std::vector<std::string> all_paths;
+            splitPaths(all, all_paths);
+            for (const auto& path : all_paths) {
+                findOrAdd(path);
+            }
+            // Phases added above come last among their siblings, which
+            // differs between ranks.  Order the siblings by the first
+            // occurrence of their path in the gathered list, which is the
+            // same on all ranks.
+            orderLike(all_paths);
+
+            // Everyone has the same tree now, and the same order.
+            paths.clear();
+            phases.clear();
+            flatten(root_, std::string(), paths, phases);
+            const int n = phases.size();
+            const double inf = std::numeric_limits<double>::infinity();
+            std::vector<double> min(2*n), max(2*n), sum(2*n), count(n);
+            for (int i = 0; i < n; ++i) {
+                const bool present = phases[i]->calls > 0;
+                const double values[2] = { phases[i]->seconds, phases[i]->memory_bytes };
+                for (int q = 0; q < 2; ++q) {
+                    min[2*i + q] = present ? values[q] : inf;
+                    max[2*i + q] = present ? values[q] : -inf;
+                    sum[2*i + q] = present ? values[q] : 0.0;
+                }
+                count[i] = present ? 1.0 : 0.0;
+            }
+            comm.min(min.data(), 2*n);
+            comm.max(max.data(), 2*n);
+            comm.sum(sum.data(), 2*n);
+            comm.sum(count.data(), n);
+            for (int i = 0; i < n; ++i) {
+                Phase& phase = *phases[i];
+                phase.ranks = static_cast<int>(count[i]);
+                RankStatistics* stats[2] = { &phase.seconds_stats, &phase.memory_stats };
+                for (int q = 0; q < 2; ++q) {
+                    *stats[q] = RankStatistics();
+                    if (phase.ranks > 0) {
+                        stats[q]->min = min[2*i + q];
+                        stats[q]->max = max[2*i + q];
+                        stats[q]->avg = sum[2*i + q] / phase.ranks;
+                    }
+                }
+            }
+        }
+
+    } // namespace time
+
+} // namespace Ewoms
+
+#endif // EWOMS_PHASEPROFILER_HEADER
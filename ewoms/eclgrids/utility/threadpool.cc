@@ -0,0 +1,184 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <ewoms/eclgrids/utility/threadpool.hh>
+#include <ewoms/eclio/errormacros.hh>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Ewoms
+{
+
+    struct ThreadPool::TaskRange
+    {
+        std::mutex mutex;
+        int begin = 0;
+        int end = 0;
+    };
+
+    ThreadPool::ThreadPool(int num_threads)
+        : loop_(0), running_(0), stop_(false), body_(nullptr),
+          schedule_(Schedule::Static), failed_(false)
+    {
+        if (num_threads < 0) {
+            EWOMS_THROW(std::invalid_argument, "Negative number of threads " << num_threads);
+        }
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        ranges_.reset(new TaskRange[num_threads]);
+        workers_.reserve(num_threads - 1);
+        for (int thread = 1; thread < num_threads; ++thread) {
+            workers_.emplace_back(&ThreadPool::workerLoop, this, thread);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(int num_tasks, const std::function<void(int, int)>& body,
+                                 Schedule schedule)
+    {
+        if (num_tasks <= 0) {
+            return;
+        }
+        // The workers are idle between loops, so the ranges can be set
+        // without their locks; taking mutex_ below publishes them.
+        const int num_threads = numThreads();
+        for (int thread = 0; thread < num_threads; ++thread) {
+            ranges_[thread].begin = static_cast<long>(num_tasks) * thread / num_threads;
+            ranges_[thread].end = static_cast<long>(num_tasks) * (thread + 1) / num_threads;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            body_ = &body;
+            schedule_ = schedule;
+            error_ = nullptr;
+            failed_ = false;
+            running_ = workers_.size();
+            ++loop_;
+        }
+        start_.notify_all();
+
+        runTasks(0);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return running_ == 0; });
+            body_ = nullptr;
+            error = error_;
+            error_ = nullptr;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void ThreadPool::workerLoop(int thread)
+    {
+        long loop = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [this, loop] { return stop_ || loop_ != loop; });
+                if (stop_) {
+                    return;
+                }
+                loop = loop_;
+            }
+            runTasks(thread);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--running_ == 0) {
+                    done_.notify_one();
+                }
+            }
+        }
+    }
+
+    void ThreadPool::runTasks(int thread)
+    {
+        int task;
+        while (!failed_ && (takeTask(thread, task)
+                            || (schedule_ == Schedule::WorkStealing && stealTask(thread, task)))) {
+            try {
+                (*body_)(task, thread);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                failed_ = true;
+            }
+        }
+    }
+
+    bool ThreadPool::takeTask(int thread, int& task)
+    {
+        TaskRange& own = ranges_[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin == own.end) {
+            return false;
+        }
+        task = own.begin++;
+        return true;
+    }
+
+    bool ThreadPool::stealTask(int thread, int& task)
+    {
+        const int num_threads = numThreads();
+        for (int offset = 1; offset < num_threads; ++offset) {
+            TaskRange& victim = ranges_[(thread + offset) % num_threads];
+            int begin, end;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                const int remaining = victim.end - victim.begin;
+                if (remaining == 0) {
+                    continue;
+                }
+                end = victim.end;
+                begin = end - (remaining + 1) / 2;
+                victim.end = begin;
+            }
+            // The own range is empty, so no other thread takes from it.
+            TaskRange& own = ranges_[thread];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            task = begin;
+            own.begin = begin + 1;
+            own.end = end;
+            return true;
+        }
+        return false;
+    }
+
+} // namespace Ewoms
@@ -0,0 +1,119 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef EWOMS_THREADPOOL_HEADER
+#define EWOMS_THREADPOOL_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Ewoms
+{
+
+    /// A fixed set of threads that run loops over numbered tasks.
+    ///
+    /// The threads are started once and wait between loops, so that a
+    /// loop costs a wake-up rather than a thread creation.  The calling
+    /// thread takes part in each loop as thread 0.  A task is typically a
+    /// chunk of entities of a grid, see Dune::CpGrid::leafChunks():
+    /// \code
+    /// Ewoms::ThreadPool pool;
+    /// const auto chunks = grid.leafChunks<0, Dune::Interior_Partition>(4*pool.numThreads(), true);
+    /// pool.parallelFor(chunks.size(), [&](int chunk, int thread) {
+    ///     for (const auto& element : chunks[chunk]) { ... }
+    /// }, Ewoms::ThreadPool::Schedule::WorkStealing);
+    /// \endcode
+    class ThreadPool
+    {
+    public:
+        /// How the tasks of a loop are handed to the threads.
+        enum class Schedule {
+            /// Each thread runs a contiguous block of tasks, the same
+            /// blocks for every loop of the same size.
+            Static,
+            /// Each thread starts on a contiguous block of tasks.  A
+            /// thread that runs out of tasks takes the later half of
+            /// the remaining tasks of another thread.
+            WorkStealing
+        };
+
+        /// Start the threads.
+        /// \param num_threads the number of threads running each loop,
+        ///        the calling thread included.  Zero means the number of
+        ///        hardware threads.
+        explicit ThreadPool(int num_threads = 0);
+
+        /// Stop the threads.
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// The number of threads running each loop.
+        int numThreads() const
+        {
+            return workers_.size() + 1;
+        }
+
+        /// Run a loop over tasks on all threads.
+        ///
+        /// Returns when all tasks are done.  If a task throws, the tasks
+        /// not yet started are skipped and the first exception is
+        /// rethrown here.  Loops must not be nested, nor run from more
+        /// than one thread at a time.
+        /// \param num_tasks the number of tasks.
+        /// \param body called as body(task, thread) for each task in
+        ///        [0, num_tasks), with the thread in [0, numThreads()).
+        /// \param schedule how the tasks are handed to the threads.
+        void parallelFor(int num_tasks, const std::function<void(int, int)>& body,
+                         Schedule schedule = Schedule::Static);
+
+    private:
+        struct TaskRange;
+
+        void workerLoop(int thread);
+        void runTasks(int thread);
+        bool takeTask(int thread, int& task);
+        bool stealTask(int thread, int& task);
+
+        std::vector<std::thread> workers_;
+        // The tasks not yet started of each thread.
+        std::unique_ptr<TaskRange[]> ranges_;
+
+        // The loop being run, guarded by mutex_.
+        std::mutex mutex_;
+        std::condition_variable start_;
+        std::condition_variable done_;
+        long loop_;
+        int running_;
+        bool stop_;
+        const std::function<void(int, int)>* body_;
+        Schedule schedule_;
+        std::exception_ptr error_;
+        std::atomic<bool> failed_;
+    };
+
+} // namespace Ewoms
+
+#endif // EWOMS_THREADPOOL_HEADER
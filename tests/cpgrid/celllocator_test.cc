@@ -0,0 +1,84 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <config.h>
+
+#define BOOST_TEST_MODULE CellLocatorTests
+#define BOOST_TEST_NO_MAIN
+#include <boost/test/unit_test.hpp>
+
+#include <ewoms/eclgrids/cpgrid.hh>
+#include <ewoms/eclgrids/cpgrid/celllocator.hh>
+
+#include <array>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(locateCartesian)
+{
+    Dune::CpGrid grid;
+    std::array<int, 3> dims = {{ 6, 5, 4 }};
+    std::array<double, 3> size = {{ 1.0, 2.0, 0.5 }};
+    grid.createCartesian(dims, size);
+    if (grid.numCells() == 0) {
+        // Only rank 0 holds the grid before loadBalance().
+        return;
+    }
+
+    Dune::cpgrid::CellLocator locator(grid);
+    typedef Dune::cpgrid::CellLocator::Vector Vector;
+
+    // Every centroid lies in its own cell, at the centre of the reference cube.
+    std::vector<Vector> centroids;
+    for (int cell = 0; cell < grid.numCells(); ++cell) {
+        Vector local;
+        BOOST_CHECK_EQUAL(locator.locate(grid.cellCentroid(cell), &local), cell);
+        for (int dd = 0; dd < 3; ++dd) {
+            BOOST_CHECK_CLOSE(local[dd], 0.5, 1e-8);
+        }
+        centroids.push_back(grid.cellCentroid(cell));
+    }
+
+    // Batched queries give the same answers.
+    const std::vector<int> cells = locator.locate(centroids);
+    BOOST_REQUIRE_EQUAL(cells.size(), centroids.size());
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        BOOST_CHECK_EQUAL(cells[i], int(i));
+    }
+
+    // Points shared by several cells belong to the lowest cell index,
+    // and points outside of the grid to none.
+    BOOST_CHECK_EQUAL(locator.locate(Vector(0.0)), 0);
+    Vector corner;
+    corner[0] = 1.0; corner[1] = 2.0; corner[2] = 0.5;
+    BOOST_CHECK_EQUAL(locator.locate(corner), 0);
+    BOOST_CHECK_EQUAL(locator.locate(Vector(-1.0)), -1);
+    corner[0] = 6.5;
+    BOOST_CHECK_EQUAL(locator.locate(corner), -1);
+}
+
+bool
+init_unit_test_func()
+{
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+    boost::unit_test::unit_test_main(&init_unit_test_func, argc, argv);
+}
@@ -25,6 +25,11 @@
 #include <boost/test/unit_test.hpp>
 
 #include <ewoms/eclgrids/cpgrid.hh>
+#include <ewoms/eclgrids/cpgrid/distributedpreprocess.hh>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 // Warning suppression for Dune includes.
 
@@ -738,6 +743,180 @@ BOOST_AUTO_TEST_CASE(intersectionOverlap)
     }
 }
 
+BOOST_AUTO_TEST_CASE(distributedPreprocessing)
+{
+    // A faulted corner-point grid of which each process only extracts the
+    // rows of cells it requires.
+    const int nx = 4, ny = 5, nz = 3;
+    std::vector<double> coord;
+    for (int j = 0; j <= ny; ++j) {
+        for (int i = 0; i <= nx; ++i) {
+            coord.insert(coord.end(), { 1.0*i, 1.0*j, 0.0, 1.0*i, 1.0*j, 10.0 });
+        }
+    }
+    std::vector<double> zcorn(8*nx*ny*nz);
+    for (int k = 0; k < 2*nz; ++k) {
+        for (int j = 0; j < 2*ny; ++j) {
+            for (int i = 0; i < 2*nx; ++i) {
+                const double throw_ = (i/2 >= 2) ? 0.5 : 0.0;
+                zcorn[i + 2*nx*(j + 2*ny*k)] = (k + 1)/2 + throw_*(j/2 + 1);
+            }
+        }
+    }
+    std::vector<int> actnum(nx*ny*nz, 1);
+    actnum[7] = 0;
+
+    grdecl global;
+    global.dims[0] = nx; global.dims[1] = ny; global.dims[2] = nz;
+    global.coord = coord.data();
+    global.zcorn = zcorn.data();
+    global.actnum = actnum.data();
+    global.mapaxes = nullptr;
+
+    processed_grid serial;
+    process_grdecl(&global, 0.0, &serial);
+
+    const auto comm = Dune::MPIHelper::getCollectiveCommunication();
+    const auto rows = Dune::cpgrid::requiredRows(ny, comm.rank(), comm.size());
+    const int nr = rows[1] - rows[0];
+
+    std::vector<double> local_zcorn(8*nx*nr*nz);
+    for (int k = 0; k < 2*nz; ++k) {
+        for (int j = 2*rows[0]; j < 2*rows[1]; ++j) {
+            std::copy_n(zcorn.begin() + 2*nx*(j + 2*ny*k), 2*nx,
+                        local_zcorn.begin() + 2*nx*((j - 2*rows[0]) + 2*nr*k));
+        }
+    }
+    std::vector<int> local_actnum(nx*nr*nz);
+    for (int k = 0; k < nz; ++k) {
+        for (int j = rows[0]; j < rows[1]; ++j) {
+            std::copy_n(actnum.begin() + nx*(j + ny*k), nx,
+                        local_actnum.begin() + nx*((j - rows[0]) + nr*k));
+        }
+    }
+
+    grdecl local = global;
+    local.dims[1] = nr;
+    local.coord = coord.data() + 6*(nx + 1)*rows[0];
+    local.zcorn = local_zcorn.data();
+    local.actnum = local_actnum.data();
+
+    const auto grid = Dune::cpgrid::processDistributed(local, ny, 0.0, comm);
+
+    BOOST_CHECK_EQUAL(grid.global_number_of_faces, serial.number_of_faces);
+    BOOST_CHECK_EQUAL(grid.global_number_of_nodes, serial.number_of_nodes);
+    BOOST_CHECK_EQUAL(comm.sum(static_cast<int>(grid.face_tags.size())), serial.number_of_faces);
+    BOOST_CHECK_EQUAL(comm.sum(grid.number_of_nodes), serial.number_of_nodes);
+    BOOST_CHECK_EQUAL(comm.sum(static_cast<int>(grid.global_cell.size())), serial.number_of_cells);
+
+    for (const auto& node : grid.face_nodes) {
+        BOOST_CHECK(node >= grid.first_node);
+        BOOST_CHECK(node < grid.first_node + grid.number_of_nodes + grid.number_of_halo_nodes);
+    }
+
+    // The halo nodes of a block are the first nodes of the next non-empty
+    // block, at the same coordinates.
+    const int num_procs = comm.size();
+    std::vector<int> node_counts(num_procs);
+    std::vector<int> first_nodes(num_procs);
+    int num_nodes = grid.number_of_nodes;
+    int first_node = grid.first_node;
+    comm.allgather(&num_nodes, 1, node_counts.data());
+    comm.allgather(&first_node, 1, first_nodes.data());
+    std::vector<int> coord_counts(num_procs);
+    std::vector<int> coord_displ(num_procs);
+    for (int p = 0; p < num_procs; ++p) {
+        coord_counts[p] = 3*node_counts[p];
+        coord_displ[p] = 3*first_nodes[p];
+    }
+    std::vector<double> owned_coordinates(grid.node_coordinates.begin(),
+                                          grid.node_coordinates.begin() + 3*grid.number_of_nodes);
+    std::vector<double> all_coordinates(3*grid.global_number_of_nodes);
+    comm.allgatherv(owned_coordinates.data(), 3*grid.number_of_nodes, all_coordinates.data(),
+                    coord_counts.data(), coord_displ.data());
+    if (grid.number_of_halo_nodes > 0) {
+        int next = comm.rank() + 1;
+        while (next < num_procs && node_counts[next] == 0) {
+            ++next;
+        }
+        BOOST_REQUIRE_LT(next, num_procs);
+        BOOST_CHECK_EQUAL(first_nodes[next], grid.first_node + grid.number_of_nodes);
+        BOOST_REQUIRE_LE(grid.number_of_halo_nodes, node_counts[next]);
+        for (int h = 0; h < grid.number_of_halo_nodes; ++h) {
+            const int local = grid.number_of_nodes + h;
+            const int global_id = grid.first_node + local;
+            for (int dd = 0; dd < 3; ++dd) {
+                BOOST_CHECK_EQUAL(grid.node_coordinates[3*local + dd], all_coordinates[3*global_id + dd]);
+            }
+        }
+    }
+
+    // Every face, in particular those crossing into the block from the
+    // one below, is a face of the serial grid with the same cells and
+    // nodes.
+    typedef std::pair<std::vector<int>, std::vector<double>> FaceKey;
+    std::vector<FaceKey> serial_faces;
+    for (int f = 0; f < serial.number_of_faces; ++f) {
+        FaceKey key;
+        key.first.push_back(serial.face_tag[f]);
+        for (int q = 0; q < 2; ++q) {
+            const int c = serial.face_neighbors[2*f + q];
+            key.first.push_back(c < 0 ? -1 : serial.local_cell_index[c]);
+        }
+        for (int k = serial.face_ptr[f]; k < serial.face_ptr[f + 1]; ++k) {
+            const double* x = serial.node_coordinates + 3*serial.face_nodes[k];
+            key.second.insert(key.second.end(), x, x + 3);
+        }
+        serial_faces.push_back(key);
+    }
+    std::sort(serial_faces.begin(), serial_faces.end());
+
+    const auto row = [nx, ny](int cell) { return (cell / nx) % ny; };
+    int crossing = 0;
+    const int nf = grid.face_tags.size();
+    for (int f = 0; f < nf; ++f) {
+        FaceKey key;
+        key.first.push_back(grid.face_tags[f]);
+        key.first.push_back(grid.face_neighbors[2*f + 0]);
+        key.first.push_back(grid.face_neighbors[2*f + 1]);
+        for (int k = grid.face_ptr[f]; k < grid.face_ptr[f + 1]; ++k) {
+            const double* x = grid.node_coordinates.data() + 3*(grid.face_nodes[k] - grid.first_node);
+            key.second.insert(key.second.end(), x, x + 3);
+        }
+        BOOST_CHECK(std::binary_search(serial_faces.begin(), serial_faces.end(), key));
+
+        const int c0 = grid.face_neighbors[2*f + 0];
+        const int c1 = grid.face_neighbors[2*f + 1];
+        if (c0 >= 0 && c1 >= 0 && std::min(row(c0), row(c1)) < grid.rows[0]) {
+            ++crossing;
+        }
+    }
+
+    // As many faces cross between blocks as the serial grid has between
+    // the rows where blocks start.
+    int expected_crossing = 0;
+    for (int f = 0; f < serial.number_of_faces; ++f) {
+        const int c0 = serial.face_neighbors[2*f + 0];
+        const int c1 = serial.face_neighbors[2*f + 1];
+        if (c0 < 0 || c1 < 0) {
+            continue;
+        }
+        const int r0 = row(serial.local_cell_index[c0]);
+        const int r1 = row(serial.local_cell_index[c1]);
+        for (int p = 1; p < num_procs; ++p) {
+            const auto owned = Dune::cpgrid::ownedRows(ny, p, num_procs);
+            if (owned[0] != owned[1] && owned[0] > 0 && std::min(r0, r1) < owned[0]
+                && std::max(r0, r1) >= owned[0]) {
+                ++expected_crossing;
+                break;
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(comm.sum(crossing), expected_crossing);
+
+    free_processed_grid(&serial);
+}
+
 bool
 init_unit_test_func()
 {
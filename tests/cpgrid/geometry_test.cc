@@ -31,6 +31,7 @@
 
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 using namespace Dune;
 
@@ -236,4 +237,35 @@ BOOST_AUTO_TEST_CASE(cellgeom)
         }
     }
 
+    // Batched mapping with convergence flags.
+    std::vector<GC> glob;
+    std::vector<LC> loc;
+    for (int i = 0; i < num_pts; ++i) {
+        if (testpts[i][0] < 1.0) {
+            loc.push_back(testpts[i]);
+            glob.push_back(g.global(testpts[i]));
+        }
+    }
+    std::vector<LC> mapped;
+    BOOST_CHECK(g.local(glob, mapped));
+    BOOST_REQUIRE_EQUAL(mapped.size(), loc.size());
+    const cpgrid::TrilinearMap map = g.trilinearMap();
+    for (std::size_t i = 0; i < loc.size(); ++i) {
+        LC diff = mapped[i];
+        diff -= loc[i];
+        BOOST_CHECK_SMALL(diff.two_norm(), tolerance);
+        GC gdiff = map.global(loc[i]);
+        gdiff -= glob[i];
+        BOOST_CHECK_SMALL(gdiff.two_norm(), tolerance);
+    }
+
+    // A cell collapsed to a point has no inverse mapping.
+    cpgrid::EntityVariable<cpgrid::Geometry<0, 3>, 3> pg2;
+    pg2.reserve(8);
+    for (int i = 0; i < 8; ++i) {
+        pg2.push_back(cpgrid::Geometry<0, 3>(GC(0.0)));
+    }
+    g = Geometry(GC(0.0), 0.0, pg2, cor_idx);
+    LC lc;
+    BOOST_CHECK(!g.local(GC(1.0), lc));
 }
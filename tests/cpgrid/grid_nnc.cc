@@ -29,9 +29,25 @@
 #include <ewoms/eclio/parser/parser.hh>
 #include <ewoms/eclio/parser/eclipsestate/eclipsestate.hh>
 #include <ewoms/eclgrids/cpgrid.hh>
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
+#ifdef HAVE_DUNE_ISTL
+#include <dune/common/fmatrix.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#endif
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
 #include <vector>
 #include <utility>
 
+#include <dirent.h>
+#include <unistd.h>
+
 namespace std
 {
     ostream& operator<<(ostream& os, const pair<int, int>& x)
@@ -47,6 +63,57 @@ using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<Dune::CpGrid::Le
 using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<Dune::CpGrid::LeafGridView, Dune::MCMGElementLayout >;
 #endif
 
+namespace
+{
+    // A new empty directory, removed with its files at the end of the scope.
+    class TemporaryDirectory
+    {
+    public:
+        TemporaryDirectory()
+        {
+            char name[] = "/tmp/grid_nnc_XXXXXX";
+            BOOST_REQUIRE(mkdtemp(name) != nullptr);
+            path_ = name;
+        }
+
+        ~TemporaryDirectory()
+        {
+            if (DIR* dir = opendir(path_.c_str())) {
+                while (const dirent* entry = readdir(dir)) {
+                    const std::string file = entry->d_name;
+                    if (file != "." && file != "..") {
+                        std::remove((path_ + "/" + file).c_str());
+                    }
+                }
+                closedir(dir);
+            }
+            rmdir(path_.c_str());
+        }
+
+        const std::string& path() const
+        {
+            return path_;
+        }
+
+    private:
+        std::string path_;
+    };
+
+    const Ewoms::time::PhaseProfiler::Phase* findPhase(const Ewoms::time::PhaseProfiler::Phase& phase,
+                                                       const std::string& name)
+    {
+        for (const auto& child : phase.children) {
+            if (child.name == name) {
+                return &child;
+            }
+            if (const auto* found = findPhase(child, name)) {
+                return found;
+            }
+        }
+        return nullptr;
+    }
+}
+
 struct Fixture
 {
     Fixture()
@@ -65,7 +132,8 @@ struct Fixture
                   const int ex_intercount,
                   const int ex_bdycount,
                   const std::vector<std::pair<int, int>>& ex_nb,
-                  const bool use_deck_porv = false)
+                  const bool use_deck_porv = false,
+                  const std::string& grid_cache_directory = "")
     {
         Ewoms::EclipseState es(parser.parseFile(filename));
         std::vector<double> porv;
@@ -75,6 +143,7 @@ struct Fixture
         }
 
         Dune::CpGrid grid;
+        grid.setGridCacheDirectory(grid_cache_directory);
         grid.processEclipseFormat(&es.getInputGrid(), false, false, false, porv, nnc);
         const auto& gv = grid.leafGridView();
 #if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
@@ -109,6 +178,237 @@ struct Fixture
         //BOOST_TEST(nb == ex_nb, boost::test_tools::per_element());
 	BOOST_CHECK_EQUAL_COLLECTIONS(nb.begin(), nb.end(),
                                       ex_nb.begin(), ex_nb.end());
+
+        // The neighbour graph is built once, also when first asked for by
+        // several threads at once.
+        std::vector<const Dune::cpgrid::CellNeighborGraph*> first_use(4, nullptr);
+        {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&grid, &first_use, t] { first_use[t] = &grid.cellNeighborGraph(); });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        // The neighbour graph has the same connections, through the same faces.
+        const auto& graph = grid.cellNeighborGraph();
+        for (const auto* g : first_use) {
+            BOOST_CHECK(g == &graph);
+        }
+        BOOST_CHECK_EQUAL(graph.numCells(), ex_elemcount);
+        BOOST_CHECK_EQUAL(graph.numConnections(), intercount - bdycount);
+        std::vector<std::pair<int, int>> graph_nb;
+        for (int cell = 0; cell < graph.numCells(); ++cell) {
+            for (int slot = graph.rowStart(cell); slot < graph.rowStart(cell + 1); ++slot) {
+                const int face = graph.face(slot);
+                const int other = graph.neighbor(slot);
+                BOOST_CHECK((grid.faceCell(face, 0) == cell && grid.faceCell(face, 1) == other) ||
+                            (grid.faceCell(face, 1) == cell && grid.faceCell(face, 0) == other));
+                if (cell < other) {
+                    graph_nb.push_back(std::make_pair(cell, other));
+                }
+            }
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(graph_nb.begin(), graph_nb.end(),
+                                      ex_nb.begin(), ex_nb.end());
+#ifdef HAVE_DUNE_ISTL
+        Dune::BCRSMatrix<Dune::FieldMatrix<double, 1, 1>> matrix;
+        graph.setupSparsityPattern(matrix);
+        BOOST_CHECK_EQUAL(matrix.N(), static_cast<std::size_t>(ex_elemcount));
+        BOOST_CHECK_EQUAL(matrix.nonzeroes(), ex_elemcount + 2*ex_nb.size());
+#endif
+    }
+
+    void testReorder(const std::string& filename,
+                     const Ewoms::NNC& nnc,
+                     const Dune::cpgrid::CellOrdering ordering)
+    {
+        Ewoms::EclipseState es(parser.parseFile(filename));
+        std::vector<double> porv;
+        Dune::CpGrid grid;
+        grid.processEclipseFormat(&es.getInputGrid(), false, false, false, porv, nnc);
+        Dune::CpGrid reordered;
+        reordered.processEclipseFormat(&es.getInputGrid(), false, false, false, porv, nnc);
+        std::vector<int> cell_order;
+        std::vector<int> face_order;
+        reordered.reorderCells(ordering, cell_order, face_order);
+
+        // Both orders are permutations.
+        const int nc = grid.numCells();
+        const int nf = grid.numFaces();
+        BOOST_REQUIRE_EQUAL(reordered.numCells(), nc);
+        BOOST_REQUIRE_EQUAL(reordered.numFaces(), nf);
+        std::vector<int> new_cell(nc, -1);
+        std::vector<int> new_face(nf, -1);
+        for (int c = 0; c < nc; ++c) {
+            BOOST_REQUIRE(cell_order[c] >= 0 && cell_order[c] < nc);
+            BOOST_REQUIRE_EQUAL(new_cell[cell_order[c]], -1);
+            new_cell[cell_order[c]] = c;
+        }
+        for (int f = 0; f < nf; ++f) {
+            BOOST_REQUIRE(face_order[f] >= 0 && face_order[f] < nf);
+            BOOST_REQUIRE_EQUAL(new_face[face_order[f]], -1);
+            new_face[face_order[f]] = f;
+        }
+
+        // The data follows the cells and faces.
+        for (int c = 0; c < nc; ++c) {
+            const int old = cell_order[c];
+            BOOST_CHECK_EQUAL(reordered.globalCell()[c], grid.globalCell()[old]);
+            BOOST_CHECK_EQUAL(reordered.cellVolume(c), grid.cellVolume(old));
+            BOOST_CHECK_EQUAL(reordered.cellVolumes()[c], grid.cellVolume(old));
+            BOOST_CHECK(reordered.cellCentroid(c) == grid.cellCentroid(old));
+            BOOST_CHECK_EQUAL(reordered.numCellFaces(c), grid.numCellFaces(old));
+            for (int j = 0; j < grid.numCellFaces(old); ++j) {
+                BOOST_CHECK_EQUAL(reordered.cellFace(c, j), new_face[grid.cellFace(old, j)]);
+            }
+            for (int corner = 0; corner < 8; ++corner) {
+                BOOST_CHECK_EQUAL(reordered.cellVertex(c, corner), grid.cellVertex(old, corner));
+            }
+        }
+        int last_first_cell = -1;
+        for (int f = 0; f < nf; ++f) {
+            const int old = face_order[f];
+            BOOST_CHECK_EQUAL(reordered.faceArea(f), grid.faceArea(old));
+            BOOST_CHECK(reordered.faceNormal(f) == grid.faceNormal(old));
+            int first_cell = nc;
+            for (int local = 0; local < 2; ++local) {
+                const int old_cell = grid.faceCell(old, local);
+                const int cell = reordered.faceCell(f, local);
+                BOOST_CHECK_EQUAL(cell, old_cell < 0 ? -1 : new_cell[old_cell]);
+                if (cell >= 0) {
+                    first_cell = std::min(first_cell, cell);
+                }
+            }
+            // The faces are sorted by their first cell.
+            BOOST_CHECK(first_cell >= last_first_cell);
+            last_first_cell = first_cell;
+        }
+    }
+
+    // Lower the layer interfaces within a box of cells, and the bottom of
+    // the grid if the box reaches it.
+    static void changeBox(std::vector<double>& zcorn, const std::array<int, 3>& dims,
+                          const std::array<int, 3>& box_begin, const std::array<int, 3>& box_end)
+    {
+        const int nx = dims[0], ny = dims[1], nz = dims[2];
+        for (int k = box_begin[2]; k < box_end[2]; ++k) {
+            if (k + 1 < box_end[2] || k + 1 == nz) {
+                for (int j = 2*box_begin[1]; j < 2*box_end[1]; ++j) {
+                    for (int i = 2*box_begin[0]; i < 2*box_end[0]; ++i) {
+                        const int top = i + 2*nx*(j + 2*ny*(2*k));
+                        const int bottom = top + 4*nx*ny;
+                        if (k + 1 == nz) {
+                            zcorn[bottom] += 0.5*(zcorn[bottom] - zcorn[top]);
+                        } else {
+                            const int below = bottom + 8*nx*ny;
+                            zcorn[bottom] += 0.25*(zcorn[below] - zcorn[bottom]);
+                            zcorn[bottom + 4*nx*ny] = zcorn[bottom];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Update a box of cells of a grid processed with NNCs, and compare
+    // with a grid processed from the changed input.
+    void testUpdate(const std::string& filename,
+                    const Ewoms::NNC& nnc,
+                    const std::array<int, 3>& box_begin,
+                    const std::array<int, 3>& box_end,
+                    const bool use_deck_porv)
+    {
+        Ewoms::EclipseState es(parser.parseFile(filename));
+        const auto& ecl_grid = es.getInputGrid();
+        std::vector<double> porv;
+        if (use_deck_porv) {
+            porv = es.fieldProps().porv(true);
+        }
+        const std::array<int, 3> dims = {{ int(ecl_grid.getNX()), int(ecl_grid.getNY()),
+                                           int(ecl_grid.getNZ()) }};
+
+        Dune::CpGrid grid;
+        grid.processEclipseFormat(&ecl_grid, false, false, false, porv, nnc);
+
+        // The update starts from the data the grid was processed from,
+        // after MINPV processing.
+        std::vector<double> coord = ecl_grid.getCOORD();
+        std::vector<double> zcorn = grid.zcornData().empty() ? ecl_grid.getZCORN() : grid.zcornData();
+        std::vector<int> actnum(ecl_grid.getCartesianSize(), 0);
+        for (const int global : grid.globalCell()) {
+            actnum[global] = 1;
+        }
+        changeBox(zcorn, dims, box_begin, box_end);
+        grdecl g;
+        std::copy(dims.begin(), dims.end(), g.dims);
+        g.coord = coord.data();
+        g.zcorn = zcorn.data();
+        g.actnum = actnum.data();
+        g.mapaxes = nullptr;
+        grid.updateEclipseFormat(g, box_begin, box_end);
+
+        std::vector<double> changed_zcorn = ecl_grid.getZCORN();
+        changeBox(changed_zcorn, dims, box_begin, box_end);
+        const Ewoms::EclipseGrid changed_grid(ecl_grid, changed_zcorn.data(), ecl_grid.getACTNUM());
+        Dune::CpGrid expected;
+        expected.processEclipseFormat(&changed_grid, false, false, false, porv, nnc);
+
+        const int nc = expected.numCells();
+        const int nf = expected.numFaces();
+        BOOST_REQUIRE_EQUAL(grid.numCells(), nc);
+        BOOST_REQUIRE_EQUAL(grid.numFaces(), nf);
+        BOOST_CHECK(grid.globalCell() == expected.globalCell());
+
+        // The faces may be numbered differently, match them by their
+        // cells and centroid.
+        const double tol = 1.0e-12;
+        std::multimap<std::pair<int, int>, int> expected_faces;
+        for (int f = 0; f < nf; ++f) {
+            expected_faces.emplace(std::make_pair(expected.faceCell(f, 0), expected.faceCell(f, 1)), f);
+        }
+        std::vector<int> face_map(nf, -1);
+        for (int f = 0; f < nf; ++f) {
+            const auto range = expected_faces.equal_range(std::make_pair(grid.faceCell(f, 0), grid.faceCell(f, 1)));
+            double best = 1.0e100;
+            for (auto it = range.first; it != range.second; ++it) {
+                auto d = grid.faceCentroid(f);
+                d -= expected.faceCentroid(it->second);
+                if (d.two_norm() < best) {
+                    best = d.two_norm();
+                    face_map[f] = it->second;
+                }
+            }
+            BOOST_REQUIRE_NE(face_map[f], -1);
+            const int e = face_map[f];
+            BOOST_CHECK_SMALL(best, tol*std::max(1.0, expected.faceCentroid(e).two_norm()));
+            BOOST_CHECK_SMALL(grid.faceArea(f) - expected.faceArea(e), tol*std::max(1.0, expected.faceArea(e)));
+            auto dn = grid.faceNormal(f);
+            dn -= expected.faceNormal(e);
+            BOOST_CHECK_SMALL(dn.two_norm(), tol);
+        }
+        std::vector<int> mapped(face_map);
+        std::sort(mapped.begin(), mapped.end());
+        BOOST_CHECK(std::adjacent_find(mapped.begin(), mapped.end()) == mapped.end());
+
+        for (int c = 0; c < nc; ++c) {
+            BOOST_REQUIRE_EQUAL(grid.numCellFaces(c), expected.numCellFaces(c));
+            std::vector<int> faces, expected_cell_faces;
+            for (int j = 0; j < grid.numCellFaces(c); ++j) {
+                faces.push_back(face_map[grid.cellFace(c, j)]);
+                expected_cell_faces.push_back(expected.cellFace(c, j));
+            }
+            std::sort(faces.begin(), faces.end());
+            std::sort(expected_cell_faces.begin(), expected_cell_faces.end());
+            BOOST_CHECK(faces == expected_cell_faces);
+
+            BOOST_CHECK_SMALL(grid.cellVolume(c) - expected.cellVolume(c), tol*expected.cellVolume(c));
+            auto d = grid.cellCentroid(c);
+            d -= expected.cellCentroid(c);
+            BOOST_CHECK_SMALL(d.two_norm(), tol*std::max(1.0, expected.cellCentroid(c).two_norm()));
+        }
     }
 };
 
@@ -138,6 +438,21 @@ BOOST_FIXTURE_TEST_CASE(NNCAtNewFace, Fixture)
     testCase("FIVE.DATA", nnc, 5, 30 + 2, 22, { {0,1}, {1,2}, {2,3}, {2,4}, {3,4} });
 }
 
+BOOST_FIXTURE_TEST_CASE(NNCAtNewFaceCached, Fixture)
+{
+    Ewoms::NNC nnc;
+    nnc.addNNC(2, 4, 1.0);
+    // The first grid is processed and cached, the second read from the cache.
+    TemporaryDirectory cache;
+    auto& profiler = Ewoms::time::PhaseProfiler::global();
+    for (int run = 0; run < 2; ++run) {
+        profiler.clear();
+        testCase("FIVE.DATA", nnc, 5, 30 + 2, 22, { {0,1}, {1,2}, {2,3}, {2,4}, {3,4} }, false, cache.path());
+        BOOST_CHECK(findPhase(profiler.root(), "readGridCache") != nullptr);
+        BOOST_CHECK_EQUAL(findPhase(profiler.root(), "processGrdecl") != nullptr, run == 0);
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(NNCAtSeveralFaces, Fixture)
 {
     Ewoms::NNC nnc;
@@ -226,4 +541,35 @@ BOOST_FIXTURE_TEST_CASE(NNCWithPINCHAndMore, Fixture)
     testCase("FIVE_PINCH.DATA", nnc, 4, 24 + 2 + 1, 18 + 1, { {0,1}, {1,2}, {1,3}, {2,3} }, true);
 }
 
+BOOST_FIXTURE_TEST_CASE(ReorderReverseCuthillMcKee, Fixture)
+{
+    Ewoms::NNC nnc;
+    nnc.addNNC(1, 4, 1.0);
+    testReorder("FIVE_ACTNUM.DATA", nnc, Dune::cpgrid::CellOrdering::ReverseCuthillMcKee);
+    testReorder("FIVE_PINCH.DATA", nnc, Dune::cpgrid::CellOrdering::ReverseCuthillMcKee);
+}
+
+BOOST_FIXTURE_TEST_CASE(ReorderHilbert, Fixture)
+{
+    Ewoms::NNC nnc;
+    nnc.addNNC(1, 4, 1.0);
+    testReorder("FIVE_ACTNUM.DATA", nnc, Dune::cpgrid::CellOrdering::Hilbert);
+    testReorder("FIVE_PINCH.DATA", nnc, Dune::cpgrid::CellOrdering::Hilbert);
+}
+
+BOOST_FIXTURE_TEST_CASE(UpdateWithNNC, Fixture)
+{
+    Ewoms::NNC nnc;
+    nnc.addNNC(205, 277, 1.0);
+    nnc.addNNC(244, 208, 1.0); // in the box
+    testUpdate("CORNERPOINT_ACTNUM.DATA", nnc, {{ 3, 4, 1 }}, {{ 6, 6, 3 }}, false);
+}
+
+BOOST_FIXTURE_TEST_CASE(UpdateWithPINCH, Fixture)
+{
+    Ewoms::NNC nnc;
+    nnc.addNNC(2, 4, 1.0); // in the box
+    testUpdate("FIVE_PINCH.DATA", nnc, {{ 0, 0, 4 }}, {{ 1, 1, 5 }}, true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
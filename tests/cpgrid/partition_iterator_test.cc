@@ -24,10 +24,15 @@
 
 #include <dune/common/version.hh>
 #include <ewoms/eclgrids/cpgrid.hh>
+#include <ewoms/eclgrids/utility/threadpool.hh>
 #include <dune/grid/common/gridenums.hh>
 #include <dune/geometry/referenceelements.hh>
 #include <dune/common/fvector.hh>
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 #if HAVE_DUNE_GRID_CHECKS
 
 #include <dune/grid/test/checkpartition.hh>
@@ -76,6 +81,95 @@ void testPartitionIteratorsOnSequentialGrid(const Dune::CpGrid& grid)
     BOOST_REQUIRE((ait==grid.leafend<codim,Dune::All_Partition>()));
 }
 
+template<int codim, Dune::PartitionIteratorType pitype>
+void testPartitionIteratorsFollowRule(const Dune::CpGrid& grid)
+{
+    // The entities visited are those of the rule, in the same order.
+    std::vector<int> expected;
+    Dune::cpgrid::PartitionIteratorRule<pitype> rule;
+    for(auto it=grid.leafbegin<codim,Dune::All_Partition>();
+        it!=grid.leafend<codim,Dune::All_Partition>(); ++it)
+    {
+        if(!rule.isInvalid(*it))
+            expected.push_back(it->index());
+    }
+    std::vector<int> visited;
+    for(auto it=grid.leafbegin<codim,pitype>(); it!=grid.leafend<codim,pitype>(); ++it)
+    {
+        visited.push_back(it->index());
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(visited.begin(), visited.end(),
+                                  expected.begin(), expected.end());
+}
+
+template<int codim>
+void testPartitionIteratorsFollowRule(const Dune::CpGrid& grid)
+{
+    testPartitionIteratorsFollowRule<codim,Dune::Interior_Partition>(grid);
+    testPartitionIteratorsFollowRule<codim,Dune::InteriorBorder_Partition>(grid);
+    testPartitionIteratorsFollowRule<codim,Dune::Overlap_Partition>(grid);
+}
+
+template<int codim, Dune::PartitionIteratorType pitype>
+void testLeafChunks(const Dune::CpGrid& grid, int num_chunks, bool weigh_by_faces)
+{
+    // The chunks together visit the entities of the partition in order.
+    std::vector<int> expected;
+    for(auto it=grid.leafbegin<codim,pitype>(); it!=grid.leafend<codim,pitype>(); ++it)
+        expected.push_back(it->index());
+    const auto chunks=grid.leafChunks<codim,pitype>(num_chunks, weigh_by_faces);
+    BOOST_REQUIRE_EQUAL(chunks.size(), static_cast<std::size_t>(num_chunks));
+    std::vector<int> visited;
+    int max_weight=0, total_weight=0;
+    for(const auto& chunk: chunks)
+    {
+        int weight=0;
+        for(const auto& entity: chunk)
+        {
+            visited.push_back(entity.index());
+            weight+=weigh_by_faces ? grid.numCellFaces(entity.index()) : 1;
+        }
+        max_weight=std::max(max_weight, weight);
+        total_weight+=weight;
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(visited.begin(), visited.end(),
+                                  expected.begin(), expected.end());
+    // No chunk has more than its share and one entity more.
+    const int max_entity_weight=weigh_by_faces ? 6 : 1;
+    BOOST_CHECK_LE(max_weight, (total_weight+num_chunks-1)/num_chunks+max_entity_weight);
+}
+
+template<Dune::PartitionIteratorType pitype>
+void testLeafChunks(const Dune::CpGrid& grid)
+{
+    for(int num_chunks: {1, 3, 16, 5000})
+    {
+        testLeafChunks<0,pitype>(grid, num_chunks, false);
+        testLeafChunks<0,pitype>(grid, num_chunks, true);
+        testLeafChunks<3,pitype>(grid, num_chunks, false);
+    }
+}
+
+void testThreadedLoop(const Dune::CpGrid& grid)
+{
+    // Summing the cell volumes by chunks on several threads gives the
+    // same result as a sequential loop.
+    double expected=0.0;
+    for(auto it=grid.leafbegin<0,Dune::Interior_Partition>(); it!=grid.leafend<0,Dune::Interior_Partition>(); ++it)
+        expected+=it->geometry().volume();
+    Ewoms::ThreadPool pool(3);
+    const auto chunks=grid.leafChunks<0,Dune::Interior_Partition>(4*pool.numThreads(), true);
+    for(auto schedule: {Ewoms::ThreadPool::Schedule::Static, Ewoms::ThreadPool::Schedule::WorkStealing})
+    {
+        std::vector<double> sums(chunks.size(), 0.0);
+        pool.parallelFor(chunks.size(), [&](int chunk, int) {
+            for(const auto& element: chunks[chunk])
+                sums[chunk]+=element.geometry().volume();
+        }, schedule);
+        BOOST_CHECK_CLOSE(std::accumulate(sums.begin(), sums.end(), 0.0), expected, 1e-10);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(partitionIteratorTest)
 {
     int m_argc = boost::unit_test::framework::master_test_suite().argc;
@@ -107,6 +201,13 @@ BOOST_AUTO_TEST_CASE(partitionIteratorTest)
     testPartitionIteratorsBasic<0>(grid, parallel);
     testPartitionIteratorsBasic<1>(grid, parallel);
     testPartitionIteratorsBasic<3>(grid, parallel);
+    testPartitionIteratorsFollowRule<0>(grid);
+    testPartitionIteratorsFollowRule<3>(grid);
+    testLeafChunks<Dune::Interior_Partition>(grid);
+    testLeafChunks<Dune::Overlap_Partition>(grid);
+    testLeafChunks<Dune::All_Partition>(grid);
+    testLeafChunks<Dune::Ghost_Partition>(grid);
+    testThreadedLoop(grid);
     if(!parallel)
     {
         testPartitionIteratorsOnSequentialGrid<0>(grid);
@@ -0,0 +1,134 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * Microbenchmark of findconnections() on a single pillar pair across a
+ * fault with a large throw.
+ *
+ * Usage: facetopology_benchmark [nz ...]
+ *
+ * For each number of layers nz, the cells on one side of the fault are
+ * displaced by nz/8 layers, such that each cell overlaps several cells
+ * on the other side and every layer boundary intersects one on the
+ * other side.  The time per pillar pair should grow linearly in nz.
+ */
+#include <config.h>
+
+#include <ewoms/eclgrids/cpgpreprocess/preprocess.h>
+extern "C" {
+#include <ewoms/eclgrids/cpgpreprocess/facetopology.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Point numbers along one pillar of the cells on either side of the
+    // fault, with the z-values of side b displaced by 'shift'.
+    void pillar(int nz, double shift, int base, std::vector<int>& a, std::vector<int>& b)
+    {
+        std::vector<double> z;
+        for (int k = 0; k <= nz; ++k) {
+            z.push_back(k);
+            z.push_back(k + shift);
+        }
+        std::sort(z.begin(), z.end());
+
+        const auto point = [&z, base](double zk) {
+            return base + static_cast<int>(std::lower_bound(z.begin(), z.end(), zk) - z.begin());
+        };
+
+        a.assign(2*nz + 2, 0);
+        b.assign(2*nz + 2, 0);
+        a.front() = b.front() = INT_MIN;
+        a.back()  = b.back()  = INT_MAX;
+        for (int c = 0; c < nz; ++c) {
+            for (int k = 0; k < 2; ++k) {
+                a[2*c + 1 + k] = point(c + k);
+                b[2*c + 1 + k] = point(c + k + shift);
+            }
+        }
+    }
+
+    void run(int nz)
+    {
+        const int n = 2*nz + 2;
+        const double throw_ = nz / 8;
+
+        // Slightly different throws on the two pillars make the layer
+        // boundaries on either side of the fault intersect.
+        std::vector<int> a1, a2, b1, b2;
+        pillar(nz, throw_ + 0.3, 0, a1, b1);
+        pillar(nz, throw_ - 0.3, 4*n, a2, b2);
+        int* pts[4] = { a1.data(), a2.data(), b1.data(), b2.data() };
+
+        std::vector<int> work(2*n, -1);
+        std::vector<int> intersections(16*n);
+        std::vector<int> face_nodes(64*n), face_ptr(8*n), face_neighbors(16*n);
+        std::vector<face_tag> tags(8*n);
+
+        processed_grid out;
+        out.face_nodes = face_nodes.data();
+        out.face_ptr = face_ptr.data();
+        out.face_neighbors = face_neighbors.data();
+        out.face_tag = tags.data();
+        out.number_of_nodes_on_pillars = 8*n;
+
+        const int reps = std::max(1, 2000000 / n);
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) {
+            out.number_of_faces = 0;
+            out.face_ptr[0] = 0;
+            out.number_of_nodes = out.number_of_nodes_on_pillars;
+            findconnections(n, pts, intersections.data(), work.data(), &out);
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        const double us = elapsed.count() / reps;
+        std::cout << "nz = " << std::setw(6) << nz
+                  << "  faces = " << std::setw(6) << out.number_of_faces
+                  << "  intersections = " << std::setw(6)
+                  << out.number_of_nodes - out.number_of_nodes_on_pillars
+                  << "  " << std::setw(9) << std::fixed << std::setprecision(2) << us
+                  << " us/pillar pair  " << std::setw(6) << std::setprecision(1)
+                  << 1000.0*us / out.number_of_faces << " ns/face\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> layers;
+    for (int i = 1; i < argc; ++i) {
+        layers.push_back(std::atoi(argv[i]));
+    }
+    if (layers.empty()) {
+        layers = { 100, 400, 1600, 6400 };
+    }
+
+    for (const auto nz : layers) {
+        run(nz);
+    }
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * Microbenchmark of the intersection loop of a finite-volume assembly
+ * on a Cartesian CpGrid.
+ *
+ * Usage: intersection_benchmark [n ...]
+ *
+ * For each n, an n x n x n grid is built (the default of 100 gives one
+ * million cells) and all intersections of all cells are visited in a loop
+ * shaped like a two-point flux assembly: the face area and normal and, for
+ * interior faces, the index of the outside cell.  The loop is timed
+ * twice: once asking only for what the flux needs, and once copying the
+ * face geometry and evaluating every neighbourhood query up front, as an
+ * eagerly updated intersection would.  The time per intersection of both
+ * loops is reported.
+ */
+#include <config.h>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <ewoms/eclgrids/cpgrid.hh>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+    typedef Dune::CpGrid::LeafGridView GridView;
+
+    template <class Body>
+    double timeLoop(const GridView& gridView, long& count, double& sum, Body body)
+    {
+        const auto& indexSet = gridView.indexSet();
+        count = 0;
+        sum = 0.0;
+        const auto start = std::chrono::steady_clock::now();
+        for (auto elemIt = gridView.begin<0>(); elemIt != gridView.end<0>(); ++elemIt) {
+            const int inside = indexSet.index(*elemIt);
+            const auto isEnd = gridView.iend(*elemIt);
+            for (auto isIt = gridView.ibegin(*elemIt); isIt != isEnd; ++isIt) {
+                sum += body(indexSet, inside, *isIt);
+                ++count;
+            }
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    void run(int n)
+    {
+        Dune::CpGrid grid;
+        std::array<int, 3> dims = {{ n, n, n }};
+        std::array<double, 3> size = {{ 1.0, 1.0, 1.0 }};
+        grid.createCartesian(dims, size);
+        const GridView gridView = grid.leafGridView();
+
+        // A stand-in for a two-point flux between the cells of a face.
+        auto flux = [](const GridView::IndexSet& indexSet, int inside,
+                       const GridView::Intersection& is) {
+            const double area_flux = is.geometry().volume() * is.centerUnitOuterNormal()[2];
+            if (is.neighbor()) {
+                return area_flux * (indexSet.index(is.outside()) - inside);
+            }
+            return area_flux;
+        };
+
+        // The same flux, computed from a copy of the face geometry and with
+        // all neighbourhood queries answered before they are needed.
+        auto eagerFlux = [](const GridView::IndexSet& indexSet, int inside,
+                            const GridView::Intersection& is) {
+            const auto geom = is.geometry();
+            const bool boundary = is.boundary();
+            const bool neighbor = !boundary && is.neighbor();
+            const int outside = neighbor ? indexSet.index(is.outside()) : inside;
+            const double area_flux = geom.volume() * is.centerUnitOuterNormal()[2];
+            if (neighbor) {
+                return area_flux * (outside - inside);
+            }
+            return area_flux;
+        };
+
+        long count = 0;
+        double sum = 0.0;
+        const double ns = timeLoop(gridView, count, sum, flux);
+        long eagerCount = 0;
+        double eagerSum = 0.0;
+        const double eagerNs = timeLoop(gridView, eagerCount, eagerSum, eagerFlux);
+        if (eagerCount != count || eagerSum != sum) {
+            std::cerr << "The two loops disagree for n = " << n << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::cout << "n = " << std::setw(4) << n
+                  << "  cells = " << std::setw(9) << grid.numCells()
+                  << "  intersections = " << std::setw(9) << count
+                  << std::fixed << std::setprecision(2)
+                  << "  lazy " << std::setw(7) << ns / count << " ns"
+                  << "  eager " << std::setw(7) << eagerNs / count << " ns"
+                  << "  (checksum " << sum << ")\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::atoi(argv[i]));
+    }
+    if (sizes.empty()) {
+        sizes = { 100 };
+    }
+
+    for (const auto n : sizes) {
+        run(n);
+    }
+
+    return 0;
+}
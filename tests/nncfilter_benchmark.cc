@@ -0,0 +1,152 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+ * Microbenchmark of the NNC handling in the topology construction of
+ * CpGrid, on a regular box grid with synthetic NNC sets.
+ *
+ * Usage: nncfilter_benchmark [num_nncs ...]
+ *
+ * A quarter of the NNCs repeat an existing face, in either orientation,
+ * a quarter repeat another NNC in the opposite orientation, and the rest
+ * connect random cells.  The time spent in filterNNCs and buildTopo per
+ * NNC should stay roughly constant as the number of NNCs grows.
+ */
+#include <config.h>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <ewoms/eclgrids/cpgrid/cpgriddata.hh>
+#include <ewoms/eclgrids/cpgpreprocess/preprocess.h>
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
+
+#include <array>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    const int nx = 60, ny = 60, nz = 30;
+
+    // Find the phase of the given name anywhere below phase.
+    const Ewoms::time::PhaseProfiler::Phase*
+    findPhase(const Ewoms::time::PhaseProfiler::Phase& phase, const std::string& name)
+    {
+        for (const auto& child : phase.children) {
+            if (child.name == name) {
+                return &child;
+            }
+            if (const auto* found = findPhase(child, name)) {
+                return found;
+            }
+        }
+        return nullptr;
+    }
+
+    void run(const grdecl& g, int num_nncs)
+    {
+        const int num_cells = nx*ny*nz;
+        std::mt19937 gen(num_nncs);
+        std::uniform_int_distribution<int> cell(0, num_cells - 1);
+        std::array<std::set<std::pair<int, int>>, 2> nnc;
+        auto& explicit_nnc = nnc[1];
+        while (static_cast<int>(explicit_nnc.size()) < num_nncs) {
+            const int c1 = cell(gen);
+            switch (explicit_nnc.size() % 4) {
+            case 0:
+                if (c1 % nx != nx - 1) {
+                    explicit_nnc.insert({ c1, c1 + 1 });
+                }
+                break;
+            case 1:
+                if (c1 % nx != 0) {
+                    explicit_nnc.insert({ c1, c1 - 1 });
+                }
+                break;
+            default: {
+                const int c2 = cell(gen);
+                explicit_nnc.insert({ c1, c2 });
+                explicit_nnc.insert({ c2, c1 });
+            }
+            }
+        }
+
+        auto& profiler = Ewoms::time::PhaseProfiler::global();
+        profiler.clear();
+        Dune::cpgrid::CpGridData data;
+        data.processEclipseFormat(g, nnc, 0.0, false);
+
+        const auto* filter = findPhase(profiler.root(), "filterNNCs");
+        const auto* topo = findPhase(profiler.root(), "buildTopo");
+        std::cout << "nncs = " << std::setw(8) << num_nncs
+                  << "  cells = " << std::setw(8) << data.size(0)
+                  << "  filterNNCs " << std::setw(9) << std::fixed << std::setprecision(2)
+                  << 1e3*filter->seconds << " ms  " << std::setw(6) << std::setprecision(1)
+                  << 1e9*filter->seconds / num_nncs << " ns/nnc"
+                  << "  buildTopo " << std::setw(9) << std::setprecision(2)
+                  << 1e3*topo->seconds << " ms\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    std::vector<int> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back(std::atoi(argv[i]));
+    }
+    if (counts.empty()) {
+        counts = { 10000, 100000, 1000000 };
+    }
+
+    // A regular box grid of unit cells.
+    std::vector<double> coord;
+    for (int j = 0; j <= ny; ++j) {
+        for (int i = 0; i <= nx; ++i) {
+            const double pillar[6] = { double(i), double(j), 0.0, double(i), double(j), double(nz) };
+            coord.insert(coord.end(), pillar, pillar + 6);
+        }
+    }
+    std::vector<double> zcorn(8*nx*ny*nz);
+    for (int k = 0; k < 2*nz; ++k) {
+        for (int j = 0; j < 2*ny; ++j) {
+            for (int i = 0; i < 2*nx; ++i) {
+                zcorn[i + 2*nx*(j + 2*ny*k)] = (k + 1)/2;
+            }
+        }
+    }
+    grdecl g;
+    g.dims[0] = nx;
+    g.dims[1] = ny;
+    g.dims[2] = nz;
+    g.coord = coord.data();
+    g.zcorn = zcorn.data();
+    g.actnum = nullptr;
+    g.mapaxes = nullptr;
+
+    for (const auto num_nncs : counts) {
+        run(g, num_nncs);
+    }
+
+    return 0;
+}
@@ -96,6 +96,33 @@ void testGridIteration( const GridView& gridView, const int nElem )
         std::cout << "number of elements is wrong: " << numElem << ", expected " << nElem << std::endl;
 }
 
+void testGeometryArrays(const Dune::CpGrid& grid)
+{
+    const auto volumes = grid.cellVolumes();
+    const auto cell_centroids = grid.cellCentroids();
+    if (int(volumes.size()) != grid.numCells() || int(cell_centroids.size()) != grid.numCells())
+        std::cout << "cell geometry arrays have the wrong size\n";
+    const auto& gridView = grid.leafGridView();
+    for (auto elemIt = gridView.begin<0>(); elemIt != gridView.end<0>(); ++elemIt) {
+        const int cell = gridView.indexSet().index(*elemIt);
+        const auto& elemGeom = elemIt->geometry();
+        if (volumes[cell] != elemGeom.volume() || cell_centroids[cell] != elemGeom.center())
+            std::cout << "cell geometry arrays differ for cell " << cell << "\n";
+    }
+
+    const auto areas = grid.faceAreas();
+    const auto face_centroids = grid.faceCentroids();
+    const auto normals = grid.faceNormals();
+    if (int(areas.size()) != grid.numFaces() || int(face_centroids.size()) != grid.numFaces()
+        || int(normals.size()) != grid.numFaces())
+        std::cout << "face geometry arrays have the wrong size\n";
+    for (int face = 0; face < grid.numFaces(); ++face) {
+        if (areas[face] != grid.faceArea(face) || face_centroids[face] != grid.faceCentroid(face)
+            || normals[face] != grid.faceNormal(face))
+            std::cout << "face geometry arrays differ for face " << face << "\n";
+    }
+}
+
 template <class Grid>
 void testGrid(Grid& grid, const std::string& name, const size_t nElem, const size_t nVertices)
 {
@@ -113,6 +140,7 @@ void testGrid(Grid& grid, const std::string& name, const size_t nElem, const siz
     std::cout << name << std::endl;
 
     testGridIteration( grid.leafGridView(), nElem );
+    testGeometryArrays( grid );
 
     std::cout << "create vertex mapper\n";
 
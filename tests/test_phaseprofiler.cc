@@ -0,0 +1,262 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <config.h>
+
+#define BOOST_TEST_MODULE PhaseProfilerTest
+#include <boost/test/unit_test.hpp>
+
+#include <ewoms/eclgrids/utility/phaseprofiler.hh>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Ewoms::time::PhaseProfiler;
+
+namespace
+{
+    // The part of the CollectiveCommunication interface used by
+    // PhaseProfiler::aggregate(), for a single process.
+    struct SerialCommunication
+    {
+        int size() const { return 1; }
+        template <class T>
+        int allgather(const T* in, int len, T* out) const
+        {
+            std::copy(in, in + len, out);
+            return 0;
+        }
+        template <class T>
+        int allgatherv(const T* in, int len, T* out, int*, int*) const
+        {
+            std::copy(in, in + len, out);
+            return 0;
+        }
+        template <class T> int min(T*, int) const { return 0; }
+        template <class T> int max(T*, int) const { return 0; }
+        template <class T> int sum(T*, int) const { return 0; }
+    };
+
+    // The same interface for ranks run as threads of one process.  Each
+    // collective writes the data of the rank to its slot and reads the
+    // slots of all ranks between two barriers.
+    class ThreadCommunication
+    {
+    public:
+        struct Shared
+        {
+            explicit Shared(int size)
+                : slots(size), size(size), arrived(0), generation(0)
+            {
+            }
+
+            void barrier()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                const long gen = generation;
+                if (++arrived == size) {
+                    arrived = 0;
+                    ++generation;
+                    cv.notify_all();
+                } else {
+                    cv.wait(lock, [this, gen] { return generation != gen; });
+                }
+            }
+
+            std::vector<std::vector<char> > slots;
+            int size;
+            std::mutex mutex;
+            std::condition_variable cv;
+            int arrived;
+            long generation;
+        };
+
+        ThreadCommunication(Shared& shared, int rank)
+            : shared_(shared), rank_(rank)
+        {
+        }
+
+        int size() const { return shared_.size; }
+
+        template <class T>
+        int allgather(const T* in, int len, T* out) const
+        {
+            publish(in, len);
+            for (int r = 0; r < size(); ++r) {
+                std::memcpy(out + r*len, shared_.slots[r].data(), len*sizeof(T));
+            }
+            shared_.barrier();
+            return 0;
+        }
+        template <class T>
+        int allgatherv(const T* in, int len, T* out, int* lengths, int* displ) const
+        {
+            publish(in, len);
+            for (int r = 0; r < size(); ++r) {
+                std::memcpy(out + displ[r], shared_.slots[r].data(), lengths[r]*sizeof(T));
+            }
+            shared_.barrier();
+            return 0;
+        }
+        template <class T> int min(T* inout, int len) const
+        {
+            return reduce(inout, len, [](T a, T b) { return std::min(a, b); });
+        }
+        template <class T> int max(T* inout, int len) const
+        {
+            return reduce(inout, len, [](T a, T b) { return std::max(a, b); });
+        }
+        template <class T> int sum(T* inout, int len) const
+        {
+            return reduce(inout, len, [](T a, T b) { return a + b; });
+        }
+
+    private:
+        template <class T>
+        void publish(const T* in, int len) const
+        {
+            const char* bytes = reinterpret_cast<const char*>(in);
+            shared_.slots[rank_].assign(bytes, bytes + len*sizeof(T));
+            shared_.barrier();
+        }
+        template <class T, class Op>
+        int reduce(T* inout, int len, Op op) const
+        {
+            publish(inout, len);
+            std::vector<T> result(len);
+            std::memcpy(result.data(), shared_.slots[0].data(), len*sizeof(T));
+            for (int r = 1; r < size(); ++r) {
+                const T* other = reinterpret_cast<const T*>(shared_.slots[r].data());
+                for (int i = 0; i < len; ++i) {
+                    result[i] = op(result[i], other[i]);
+                }
+            }
+            shared_.barrier();
+            std::copy(result.begin(), result.end(), inout);
+            return 0;
+        }
+
+        Shared& shared_;
+        int rank_;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(nesting)
+{
+    PhaseProfiler profiler;
+    {
+        PhaseProfiler::Scope outer("outer", profiler);
+        for (int i = 0; i < 3; ++i) {
+            PhaseProfiler::Scope inner("inner", profiler);
+        }
+        PhaseProfiler::Scope first("first", profiler);
+        first.stop();
+        PhaseProfiler::Scope second("second", profiler);
+    }
+    PhaseProfiler::Scope other("other", profiler);
+    other.stop();
+
+    const auto& root = profiler.root();
+    BOOST_REQUIRE_EQUAL(root.children.size(), 2);
+    const auto* outer = root.child("outer");
+    BOOST_REQUIRE(outer != nullptr);
+    BOOST_CHECK_EQUAL(outer->calls, 1);
+    BOOST_REQUIRE_EQUAL(outer->children.size(), 3);
+    BOOST_CHECK_EQUAL(outer->children[0].name, "inner");
+    BOOST_CHECK_EQUAL(outer->children[0].calls, 3);
+    BOOST_CHECK_EQUAL(outer->children[1].name, "first");
+    BOOST_CHECK_EQUAL(outer->children[2].name, "second");
+    BOOST_CHECK(outer->child("second")->children.empty());
+    BOOST_CHECK(outer->seconds >= outer->children[0].seconds);
+    BOOST_CHECK(root.child("missing") == nullptr);
+
+    profiler.clear();
+    BOOST_CHECK(profiler.root().children.empty());
+}
+
+BOOST_AUTO_TEST_CASE(aggregate_and_json)
+{
+    PhaseProfiler profiler;
+    {
+        PhaseProfiler::Scope outer("outer", profiler);
+        PhaseProfiler::Scope inner("in\"ner", profiler);
+    }
+    profiler.aggregate(SerialCommunication());
+
+    const auto& outer = *profiler.root().child("outer");
+    BOOST_CHECK_EQUAL(outer.ranks, 1);
+    BOOST_CHECK_EQUAL(outer.seconds_stats.min, outer.seconds);
+    BOOST_CHECK_EQUAL(outer.seconds_stats.max, outer.seconds);
+    BOOST_CHECK_EQUAL(outer.seconds_stats.avg, outer.seconds);
+    BOOST_CHECK_EQUAL(outer.memory_stats.avg, outer.memory_bytes);
+    BOOST_CHECK_EQUAL(outer.children[0].ranks, 1);
+
+    std::ostringstream json;
+    profiler.writeJSON(json);
+    const std::string s = json.str();
+    BOOST_CHECK(s.find("\"phases\"") != std::string::npos);
+    BOOST_CHECK(s.find("\"name\": \"outer\"") != std::string::npos);
+    BOOST_CHECK(s.find("\"name\": \"in\\\"ner\"") != std::string::npos);
+    BOOST_CHECK(s.find("\"seconds_max\"") != std::string::npos);
+    BOOST_CHECK_EQUAL(std::count(s.begin(), s.end(), '{'), std::count(s.begin(), s.end(), '}'));
+    BOOST_CHECK_EQUAL(std::count(s.begin(), s.end(), '['), std::count(s.begin(), s.end(), ']'));
+}
+
+BOOST_AUTO_TEST_CASE(aggregate_different_phases)
+{
+    // Rank 0 runs a phase that rank 1 does not, and rank 1 a nested phase
+    // that rank 0 does not.  Rank 1 sees its own phases first.
+    PhaseProfiler profilers[2];
+    {
+        PhaseProfiler::Scope only0("buildGrid", profilers[0]);
+    }
+    for (auto& profiler : profilers) {
+        PhaseProfiler::Scope both("distributeGlobalGrid", profiler);
+        if (&profiler == &profilers[1]) {
+            PhaseProfiler::Scope only1("scatterGrid", profiler);
+        }
+    }
+
+    ThreadCommunication::Shared shared(2);
+    std::thread rank1([&] { profilers[1].aggregate(ThreadCommunication(shared, 1)); });
+    profilers[0].aggregate(ThreadCommunication(shared, 0));
+    rank1.join();
+
+    for (const auto& profiler : profilers) {
+        const auto& root = profiler.root();
+        BOOST_REQUIRE_EQUAL(root.children.size(), 2);
+        BOOST_CHECK_EQUAL(root.children[0].name, "buildGrid");
+        BOOST_CHECK_EQUAL(root.children[0].ranks, 1);
+        BOOST_CHECK_EQUAL(root.children[1].name, "distributeGlobalGrid");
+        BOOST_CHECK_EQUAL(root.children[1].ranks, 2);
+        BOOST_REQUIRE_EQUAL(root.children[1].children.size(), 1);
+        BOOST_CHECK_EQUAL(root.children[1].children[0].name, "scatterGrid");
+        BOOST_CHECK_EQUAL(root.children[1].children[0].ranks, 1);
+    }
+    const auto& build0 = *profilers[0].root().child("buildGrid");
+    const auto& build1 = *profilers[1].root().child("buildGrid");
+    BOOST_CHECK_EQUAL(build1.calls, 0);
+    BOOST_CHECK_EQUAL(build1.seconds_stats.max, build0.seconds);
+    BOOST_CHECK_EQUAL(build0.seconds_stats.max, build0.seconds);
+}
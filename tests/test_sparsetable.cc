@@ -22,14 +22,21 @@
 
 #define BOOST_TEST_MODULE SparseTableTest
 #include <boost/test/unit_test.hpp>
+#include <boost/mpl/list.hpp>
 
 #include <ewoms/eclgrids/utility/sparsetable.hh>
+#include <ewoms/eclgrids/utility/compactsparsetable.hh>
+
+#include <numeric>
+#include <vector>
 
 using namespace Ewoms;
 
-BOOST_AUTO_TEST_CASE(construction_and_queries)
+typedef boost::mpl::list<SparseTable<int>, CompactSparseTable<int> > TableTypes;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(construction_and_queries, Table, TableTypes)
 {
-    const SparseTable<int> st1;
+    const Table st1;
     BOOST_CHECK(st1.empty());
     BOOST_CHECK_EQUAL(st1.size(), 0);
     BOOST_CHECK_EQUAL(st1.dataSize(), 0);
@@ -47,7 +54,7 @@ BOOST_AUTO_TEST_CASE(construction_and_queries)
     const int elem[num_elem] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
     const int num_rows = 5;
     const int rowsizes[num_rows] = { 1, 0, 2, 4, 3 };
-    const SparseTable<int> st2(elem, elem + num_elem, rowsizes, rowsizes + num_rows);
+    const Table st2(elem, elem + num_elem, rowsizes, rowsizes + num_rows);
     BOOST_CHECK(!st2.empty());
     BOOST_CHECK_EQUAL(st2.size(), num_rows);
     BOOST_CHECK_EQUAL(st2.dataSize(), num_elem);
@@ -58,17 +65,17 @@ BOOST_AUTO_TEST_CASE(construction_and_queries)
     BOOST_CHECK_EQUAL(st2[3][1], 4);
     BOOST_CHECK_EQUAL(st2[4][2], 9);
     BOOST_CHECK(int(st2[4].size()) == rowsizes[4]);
-    const SparseTable<int> st2_again(elem, elem + num_elem, rowsizes, rowsizes + num_rows);
+    const Table st2_again(elem, elem + num_elem, rowsizes, rowsizes + num_rows);
     BOOST_CHECK(st2 == st2_again);
-    SparseTable<int> st2_byassign;
+    Table st2_byassign;
     st2_byassign.assign(elem, elem + num_elem, rowsizes, rowsizes + num_rows);
     BOOST_CHECK(st2 == st2_byassign);
     const int last_row_size = rowsizes[num_rows - 1];
-    SparseTable<int> st2_append(elem, elem + num_elem - last_row_size, rowsizes, rowsizes + num_rows - 1);
+    Table st2_append(elem, elem + num_elem - last_row_size, rowsizes, rowsizes + num_rows - 1);
     BOOST_CHECK_EQUAL(st2_append.dataSize(), num_elem - last_row_size);
     st2_append.appendRow(elem + num_elem - last_row_size, elem + num_elem);
     BOOST_CHECK(st2 == st2_append);
-    SparseTable<int> st2_append2;
+    Table st2_append2;
     st2_append2.appendRow(elem, elem + 1);
     st2_append2.appendRow(elem + 1, elem + 1);
     st2_append2.appendRow(elem + 1, elem + 3);
@@ -76,29 +83,29 @@ BOOST_AUTO_TEST_CASE(construction_and_queries)
     st2_append2.appendRow(elem + 7, elem + 10);
     BOOST_CHECK(st2 == st2_append2);
     st2_append2.clear();
-    SparseTable<int> st_empty;
+    Table st_empty;
     BOOST_CHECK(st2_append2 == st_empty);
 
-    SparseTable<int> st2_allocate;
+    Table st2_allocate;
     st2_allocate.allocate(rowsizes, rowsizes + num_rows);
     BOOST_CHECK_EQUAL(st2_allocate.size(), num_rows);
     BOOST_CHECK_EQUAL(st2_allocate.dataSize(), num_elem);
     int s = 0;
     for (int i = 0; i < num_rows; ++i) {
-        SparseTable<int>::mutable_row_type row = st2_allocate[i];
+        typename Table::mutable_row_type row = st2_allocate[i];
         for (int j = 0; j < rowsizes[i]; ++j, ++s)
             row[j] = elem[s];
     }
     BOOST_CHECK(st2 == st2_allocate);
 
     // One element too few.
-    BOOST_CHECK_THROW(const SparseTable<int> st3(elem, elem + num_elem - 1, rowsizes, rowsizes + num_rows), std::exception);
+    BOOST_CHECK_THROW(const Table st3(elem, elem + num_elem - 1, rowsizes, rowsizes + num_rows), std::exception);
 
     // A few elements too many.
-    BOOST_CHECK_THROW(const SparseTable<int> st4(elem, elem + num_elem, rowsizes, rowsizes + num_rows - 1), std::exception);
+    BOOST_CHECK_THROW(const Table st4(elem, elem + num_elem, rowsizes, rowsizes + num_rows - 1), std::exception);
 
     // Need at least one row.
-    BOOST_CHECK_THROW(const SparseTable<int> st5(elem, elem + num_elem, rowsizes, rowsizes), std::exception);
+    BOOST_CHECK_THROW(const Table st5(elem, elem + num_elem, rowsizes, rowsizes), std::exception);
 
     // Test iteration over rows with a range-for loop.
     int row_index = 0;
@@ -115,6 +122,32 @@ BOOST_AUTO_TEST_CASE(construction_and_queries)
     BOOST_CHECK_THROW(st2.rowSize(st2.size()), std::exception);
     // No negative row sizes.
     const int err_rs[num_rows] = { 1, 0, -1, 7, 3 };
-    BOOST_CHECK_THROW(const SparseTable<int> st6(elem, elem + num_elem, err_rs, err_rs + num_rows), std::exception);
+    BOOST_CHECK_THROW(const Table st6(elem, elem + num_elem, err_rs, err_rs + num_rows), std::exception);
 #endif
 }
+
+BOOST_AUTO_TEST_CASE(compact_rows_across_blocks)
+{
+    // Many short rows, and a few long ones that push the row starts in
+    // their blocks beyond the 16 bit offsets.
+    std::vector<int> rowsizes;
+    for (int i = 0; i < 1000; ++i) {
+        rowsizes.push_back((i % 97 == 5) ? 70000 + i : i % 7);
+    }
+    std::vector<int> elem(std::accumulate(rowsizes.begin(), rowsizes.end(), 0));
+    std::iota(elem.begin(), elem.end(), 0);
+
+    const SparseTable<int> st(elem.begin(), elem.end(), rowsizes.begin(), rowsizes.end());
+    const CompactSparseTable<int> cst(elem.begin(), elem.end(), rowsizes.begin(), rowsizes.end());
+    CompactSparseTable<int> cst_append;
+    for (int i = 0; i < st.size(); ++i) {
+        cst_append.appendRow(st[i].begin(), st[i].end());
+    }
+    BOOST_CHECK(cst == cst_append);
+    BOOST_REQUIRE_EQUAL(cst.size(), st.size());
+    BOOST_CHECK_EQUAL(cst.dataSize(), st.dataSize());
+    for (int i = 0; i < st.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(cst.rowSize(i), st.rowSize(i));
+        BOOST_CHECK_EQUAL_COLLECTIONS(cst[i].begin(), cst[i].end(), st[i].begin(), st[i].end());
+    }
+}
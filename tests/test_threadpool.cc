@@ -0,0 +1,99 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the eWoms project.
+
+  eWoms is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  eWoms is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with eWoms.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <config.h>
+
+#define NVERBOSE // to suppress our messages when throwing
+
+#define BOOST_TEST_MODULE ThreadPoolTest
+#include <boost/test/unit_test.hpp>
+
+#include <ewoms/eclgrids/utility/threadpool.hh>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace Ewoms;
+
+namespace
+{
+    // Run a loop in which the early tasks take longer, and check that
+    // each task is run once, on a valid thread.
+    void checkLoop(ThreadPool& pool, int num_tasks, ThreadPool::Schedule schedule)
+    {
+        std::vector<std::atomic<int> > count(num_tasks);
+        for (auto& c : count) {
+            c = 0;
+        }
+        std::atomic<int> bad_thread(0);
+        pool.parallelFor(num_tasks, [&](int task, int thread) {
+            if (thread < 0 || thread >= pool.numThreads()) {
+                ++bad_thread;
+            }
+            volatile double sum = 0.0;
+            for (int i = 0; i < 100 * (num_tasks - task); ++i) {
+                sum = sum + i;
+            }
+            ++count[task];
+        }, schedule);
+        BOOST_CHECK_EQUAL(bad_thread, 0);
+        for (int task = 0; task < num_tasks; ++task) {
+            BOOST_CHECK_EQUAL(count[task], 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(every_task_once)
+{
+    for (int num_threads : { 1, 2, 4, 7 }) {
+        ThreadPool pool(num_threads);
+        BOOST_CHECK_EQUAL(pool.numThreads(), num_threads);
+        for (int num_tasks : { 0, 1, 3, 100, 1000 }) {
+            checkLoop(pool, num_tasks, ThreadPool::Schedule::Static);
+            checkLoop(pool, num_tasks, ThreadPool::Schedule::WorkStealing);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(static_blocks)
+{
+    // The static schedule gives each thread one contiguous block.
+    ThreadPool pool(3);
+    std::vector<int> thread_of_task(9, -1);
+    pool.parallelFor(9, [&](int task, int thread) {
+        thread_of_task[task] = thread;
+    });
+    const std::vector<int> expected = { 0, 0, 0, 1, 1, 1, 2, 2, 2 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(thread_of_task.begin(), thread_of_task.end(),
+                                  expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(exceptions)
+{
+    ThreadPool pool(4);
+    BOOST_CHECK_THROW(pool.parallelFor(100, [](int task, int) {
+        if (task == 42) {
+            throw std::runtime_error("task 42");
+        }
+    }, ThreadPool::Schedule::WorkStealing), std::runtime_error);
+
+    // The pool is still usable afterwards.
+    checkLoop(pool, 100, ThreadPool::Schedule::Static);
+    BOOST_CHECK_THROW(ThreadPool(-1), std::invalid_argument);
+}
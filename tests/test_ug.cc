@@ -31,6 +31,8 @@
 
 /* --- our own headers --- */
 #include <algorithm>
+#include <cmath>
+#include <utility>
 #include <vector>
 #include <ewoms/eclgrids/unstructuredgrid.h>
 #include <ewoms/eclgrids/cornerpoint_grid.h>  /* compute_geometry */
@@ -190,3 +192,610 @@ BOOST_AUTO_TEST_CASE(TOPS_Fully_Specified) {
     for (std::size_t g = 0; g < 300; g++)
         BOOST_CHECK_EQUAL(actnum[g], 1);
 }
+
+BOOST_AUTO_TEST_CASE(ThreadedPreprocessing) {
+    const std::string filename = "CORNERPOINT_ACTNUM.DATA";
+    Ewoms::Parser parser;
+    Ewoms::Deck deck = parser.parseFile( filename);
+
+    const auto& dimens = deck.getKeyword("DIMENS");
+    const auto& coord = deck.getKeyword("COORD");
+    const auto& zcorn = deck.getKeyword("ZCORN");
+    const auto& actnum = deck.getKeyword("ACTNUM");
+
+    struct grdecl g;
+    g.dims[0] = dimens.getRecord(0).getItem("NX").get< int >(0);
+    g.dims[1] = dimens.getRecord(0).getItem("NY").get< int >(0);
+    g.dims[2] = dimens.getRecord(0).getItem("NZ").get< int >(0);
+
+    g.coord  = coord.getSIDoubleData().data();
+    g.zcorn  = zcorn.getSIDoubleData().data();
+    g.actnum = actnum.getIntData().data();
+    g.mapaxes = NULL;
+
+    struct processed_grid serial;
+    process_grdecl(&g, 0.0, &serial);
+
+    for (int num_threads : { 2, 3, 8, 0 }) {
+        struct processed_grid threaded;
+        process_grdecl_threaded(&g, 0.0, num_threads, &threaded);
+
+        BOOST_REQUIRE_EQUAL(threaded.number_of_faces, serial.number_of_faces);
+        BOOST_REQUIRE_EQUAL(threaded.number_of_nodes, serial.number_of_nodes);
+        BOOST_REQUIRE_EQUAL(threaded.number_of_cells, serial.number_of_cells);
+
+        const int nf = serial.number_of_faces;
+        BOOST_CHECK(std::equal(serial.face_ptr, serial.face_ptr + nf + 1, threaded.face_ptr));
+        BOOST_CHECK(std::equal(serial.face_nodes, serial.face_nodes + serial.face_ptr[nf], threaded.face_nodes));
+        BOOST_CHECK(std::equal(serial.face_neighbors, serial.face_neighbors + 2*nf, threaded.face_neighbors));
+        BOOST_CHECK(std::equal(serial.face_tag, serial.face_tag + nf, threaded.face_tag));
+        BOOST_CHECK(std::equal(serial.node_coordinates, serial.node_coordinates + 3*serial.number_of_nodes,
+                               threaded.node_coordinates));
+        BOOST_CHECK(std::equal(serial.local_cell_index, serial.local_cell_index + serial.number_of_cells,
+                               threaded.local_cell_index));
+
+        free_processed_grid(&threaded);
+    }
+
+    free_processed_grid(&serial);
+}
+
+BOOST_AUTO_TEST_CASE(InPlacePreprocessing) {
+    const std::string filename = "CORNERPOINT_ACTNUM.DATA";
+    Ewoms::Parser parser;
+    Ewoms::Deck deck = parser.parseFile( filename);
+
+    const auto& dimens = deck.getKeyword("DIMENS");
+    const auto& coord = deck.getKeyword("COORD");
+    const auto& actnum = deck.getKeyword("ACTNUM");
+    const std::vector<double> zcorn = deck.getKeyword("ZCORN").getSIDoubleData();
+
+    struct grdecl g;
+    g.dims[0] = dimens.getRecord(0).getItem("NX").get< int >(0);
+    g.dims[1] = dimens.getRecord(0).getItem("NY").get< int >(0);
+    g.dims[2] = dimens.getRecord(0).getItem("NZ").get< int >(0);
+
+    g.coord  = coord.getSIDoubleData().data();
+    g.zcorn  = zcorn.data();
+    g.actnum = actnum.getIntData().data();
+    g.mapaxes = NULL;
+
+    struct processed_grid expected;
+    process_grdecl(&g, 0.0, &expected);
+
+    std::vector<double> work = zcorn;
+    g.zcorn = work.data();
+    struct processed_grid inplace;
+    BOOST_REQUIRE(process_grdecl_inplace(&g, work.data(), 0.0, 0, &inplace));
+
+    // The ZCORN values are back in their original order.
+    BOOST_CHECK(work == zcorn);
+
+    BOOST_REQUIRE_EQUAL(inplace.number_of_faces, expected.number_of_faces);
+    BOOST_REQUIRE_EQUAL(inplace.number_of_nodes, expected.number_of_nodes);
+    BOOST_REQUIRE_EQUAL(inplace.number_of_cells, expected.number_of_cells);
+
+    const int nf = expected.number_of_faces;
+    BOOST_CHECK(std::equal(expected.face_ptr, expected.face_ptr + nf + 1, inplace.face_ptr));
+    BOOST_CHECK(std::equal(expected.face_nodes, expected.face_nodes + expected.face_ptr[nf], inplace.face_nodes));
+    BOOST_CHECK(std::equal(expected.face_neighbors, expected.face_neighbors + 2*nf, inplace.face_neighbors));
+    BOOST_CHECK(std::equal(expected.node_coordinates, expected.node_coordinates + 3*expected.number_of_nodes,
+                           inplace.node_coordinates));
+    BOOST_CHECK(std::equal(expected.local_cell_index, expected.local_cell_index + expected.number_of_cells,
+                           inplace.local_cell_index));
+
+    // A work array that is not the grid's ZCORN is refused.
+    std::vector<double> other = zcorn;
+    struct processed_grid refused;
+    BOOST_CHECK(!process_grdecl_inplace(&g, other.data(), 0.0, 0, &refused));
+    BOOST_CHECK(create_grid_cornerpoint_inplace(&g, other.data(), 0.0) == nullptr);
+    BOOST_CHECK(other == zcorn);
+
+    free_processed_grid(&inplace);
+    free_processed_grid(&expected);
+}
+
+namespace {
+    struct SlabCollector {
+        int next_face = 0;
+        int next_node = 0;
+        std::vector<double> coordinates;
+        std::vector<int> face_ptr { 0 };
+        std::vector<int> face_nodes;
+        std::vector<int> face_neighbors;
+        std::vector<int> face_tag;
+        std::vector<int> cells;
+
+        static void sink(void* ctx, const struct processed_slab* slab)
+        {
+            auto& self = *static_cast<SlabCollector*>(ctx);
+
+            BOOST_REQUIRE_EQUAL(slab->first_face, self.next_face);
+            BOOST_REQUIRE_EQUAL(slab->first_node, self.next_node);
+            self.next_face += slab->number_of_faces;
+            self.next_node += slab->number_of_nodes;
+
+            self.coordinates.insert(self.coordinates.end(), slab->node_coordinates,
+                                    slab->node_coordinates + 3*slab->number_of_nodes);
+            for (int f = 0; f < slab->number_of_faces; ++f) {
+                self.face_nodes.insert(self.face_nodes.end(),
+                                       slab->face_nodes + slab->face_ptr[f],
+                                       slab->face_nodes + slab->face_ptr[f + 1]);
+                self.face_ptr.push_back(self.face_nodes.size());
+                self.face_neighbors.push_back(slab->face_neighbors[2*f + 0]);
+                self.face_neighbors.push_back(slab->face_neighbors[2*f + 1]);
+                self.face_tag.push_back(slab->face_tag[f]);
+            }
+            self.cells.insert(self.cells.end(), slab->global_cell,
+                              slab->global_cell + slab->number_of_cells);
+        }
+    };
+
+    // Faces identified by tag, Cartesian neighbours and node coordinates.
+    using FaceKey = std::pair<std::vector<int>, std::vector<double>>;
+
+    FaceKey faceKey(int tag, int c0, int c1, const int* nodes_begin, const int* nodes_end,
+                    const double* coordinates)
+    {
+        FaceKey key { { tag, c0, c1 }, { } };
+        for (auto n = nodes_begin; n != nodes_end; ++n) {
+            key.second.insert(key.second.end(), coordinates + 3*(*n), coordinates + 3*(*n) + 3);
+        }
+        return key;
+    }
+
+    // The number of pillar nodes as the CpGrid update recovers it from
+    // a processed grid: one past the largest node of a horizontal face.
+    int recoveredPillarNodeCount(const struct processed_grid& grid)
+    {
+        int count = 0;
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            if (grid.face_tag[f] == K_FACE) {
+                for (int k = grid.face_ptr[f]; k < grid.face_ptr[f + 1]; ++k) {
+                    count = std::max(count, grid.face_nodes[k] + 1);
+                }
+            }
+        }
+        return count;
+    }
+
+    // Whether any face refers to a node in [begin, end).
+    bool hasFaceNodeIn(const struct processed_grid& grid, int begin, int end)
+    {
+        const int* nodes = grid.face_nodes;
+        return std::any_of(nodes, nodes + grid.face_ptr[grid.number_of_faces],
+                           [begin, end](int n) { return begin <= n && n < end; });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(StreamingPreprocessing) {
+    const std::string filename = "CORNERPOINT_ACTNUM.DATA";
+    Ewoms::Parser parser;
+    Ewoms::Deck deck = parser.parseFile( filename);
+
+    const auto& dimens = deck.getKeyword("DIMENS");
+    const auto& coord = deck.getKeyword("COORD");
+    const auto& zcorn = deck.getKeyword("ZCORN");
+    const auto& actnum = deck.getKeyword("ACTNUM");
+
+    struct grdecl g;
+    g.dims[0] = dimens.getRecord(0).getItem("NX").get< int >(0);
+    g.dims[1] = dimens.getRecord(0).getItem("NY").get< int >(0);
+    g.dims[2] = dimens.getRecord(0).getItem("NZ").get< int >(0);
+
+    g.coord  = coord.getSIDoubleData().data();
+    g.zcorn  = zcorn.getSIDoubleData().data();
+    g.actnum = actnum.getIntData().data();
+    g.mapaxes = NULL;
+
+    struct processed_grid serial;
+    process_grdecl(&g, 0.0, &serial);
+
+    std::vector<FaceKey> expected;
+    for (int f = 0; f < serial.number_of_faces; ++f) {
+        const int* n = serial.face_neighbors + 2*f;
+        expected.push_back(faceKey(serial.face_tag[f],
+                                   n[0] < 0 ? -1 : serial.local_cell_index[n[0]],
+                                   n[1] < 0 ? -1 : serial.local_cell_index[n[1]],
+                                   serial.face_nodes + serial.face_ptr[f],
+                                   serial.face_nodes + serial.face_ptr[f + 1],
+                                   serial.node_coordinates));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    for (int slab_rows : { 1, 2, g.dims[1] }) {
+        SlabCollector collector;
+        process_grdecl_streaming(&g, 0.0, slab_rows, 1, &SlabCollector::sink, &collector);
+
+        BOOST_REQUIRE_EQUAL(collector.next_face, serial.number_of_faces);
+        BOOST_REQUIRE_EQUAL(collector.next_node, serial.number_of_nodes);
+        std::vector<int> cells(serial.local_cell_index, serial.local_cell_index + serial.number_of_cells);
+        std::sort(collector.cells.begin(), collector.cells.end());
+        BOOST_CHECK(cells == collector.cells);
+
+        std::vector<FaceKey> faces;
+        for (int f = 0; f < collector.next_face; ++f) {
+            faces.push_back(faceKey(collector.face_tag[f],
+                                    collector.face_neighbors[2*f + 0],
+                                    collector.face_neighbors[2*f + 1],
+                                    collector.face_nodes.data() + collector.face_ptr[f],
+                                    collector.face_nodes.data() + collector.face_ptr[f + 1],
+                                    collector.coordinates.data()));
+        }
+        std::sort(faces.begin(), faces.end());
+        BOOST_CHECK(faces == expected);
+    }
+
+    free_processed_grid(&serial);
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalPreprocessing) {
+    const std::string filename = "CORNERPOINT_ACTNUM.DATA";
+    Ewoms::Parser parser;
+    Ewoms::Deck deck = parser.parseFile( filename);
+
+    const auto& dimens = deck.getKeyword("DIMENS");
+    std::vector<double> coord = deck.getKeyword("COORD").getSIDoubleData();
+    std::vector<double> zcorn = deck.getKeyword("ZCORN").getSIDoubleData();
+    std::vector<int> actnum = deck.getKeyword("ACTNUM").getIntData();
+
+    struct grdecl g;
+    g.dims[0] = dimens.getRecord(0).getItem("NX").get< int >(0);
+    g.dims[1] = dimens.getRecord(0).getItem("NY").get< int >(0);
+    g.dims[2] = dimens.getRecord(0).getItem("NZ").get< int >(0);
+
+    g.coord  = coord.data();
+    g.zcorn  = zcorn.data();
+    g.actnum = actnum.data();
+    g.mapaxes = NULL;
+
+    struct processed_grid updated;
+    process_grdecl(&g, 0.0, &updated);
+
+    // Move the interface between layers one and two within the box
+    // and deactivate a cell.
+    const int nx = g.dims[0], ny = g.dims[1];
+    const int lo[3] = { 3, 4, 1 };
+    const int hi[3] = { 6, 6, 3 };
+    for (int j = 2*lo[1]; j < 2*hi[1]; ++j) {
+        for (int i = 2*lo[0]; i < 2*hi[0]; ++i) {
+            const int above = i + 2*nx*(j + 2*ny*3);
+            const int below = above + 4*nx*ny;
+            const int bottom = below + 4*nx*ny;
+            zcorn[above] = zcorn[below] = zcorn[below] + (0.1 + 0.05*(i % 3))*(zcorn[bottom] - zcorn[below]);
+        }
+    }
+    actnum[4 + nx*(5 + ny*2)] = 0;
+
+    int* face_origin = nullptr;
+    int* cell_origin = nullptr;
+    process_grdecl_update(&g, 0.0, lo, hi, 0, &updated, &face_origin, &cell_origin);
+
+    struct processed_grid expected;
+    process_grdecl(&g, 0.0, &expected);
+
+    BOOST_REQUIRE_EQUAL(updated.number_of_cells, expected.number_of_cells);
+    BOOST_CHECK(std::equal(expected.local_cell_index, expected.local_cell_index + expected.number_of_cells,
+                           updated.local_cell_index));
+    BOOST_CHECK_EQUAL(updated.number_of_nodes, expected.number_of_nodes);
+    BOOST_REQUIRE_EQUAL(updated.number_of_faces, expected.number_of_faces);
+    BOOST_CHECK(std::is_sorted(updated.face_tag, updated.face_tag + updated.number_of_faces));
+
+    auto faceKeys = [](const struct processed_grid& grid) {
+        std::vector<FaceKey> faces;
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            const int* n = grid.face_neighbors + 2*f;
+            faces.push_back(faceKey(grid.face_tag[f],
+                                    n[0] < 0 ? -1 : grid.local_cell_index[n[0]],
+                                    n[1] < 0 ? -1 : grid.local_cell_index[n[1]],
+                                    grid.face_nodes + grid.face_ptr[f],
+                                    grid.face_nodes + grid.face_ptr[f + 1],
+                                    grid.node_coordinates));
+        }
+        std::sort(faces.begin(), faces.end());
+        return faces;
+    };
+    BOOST_CHECK(faceKeys(updated) == faceKeys(expected));
+
+    // Only faces and cells around the box are recomputed.
+    const int kept_faces = std::count_if(face_origin, face_origin + updated.number_of_faces,
+                                         [](int f) { return f != -1; });
+    const int kept_cells = std::count_if(cell_origin, cell_origin + updated.number_of_cells,
+                                         [](int c) { return c != -1; });
+    BOOST_CHECK_GT(kept_faces, updated.number_of_faces / 2);
+    BOOST_CHECK_GT(kept_cells, updated.number_of_cells / 2);
+
+    // The pillar node count recovered from the faces is exact here.
+    BOOST_CHECK_EQUAL(recoveredPillarNodeCount(expected), expected.number_of_nodes_on_pillars);
+    BOOST_CHECK_EQUAL(recoveredPillarNodeCount(updated), updated.number_of_nodes_on_pillars);
+
+    free(cell_origin);
+    free(face_origin);
+    free_processed_grid(&expected);
+    free_processed_grid(&updated);
+}
+
+BOOST_AUTO_TEST_CASE(RecoveredPillarNodeCount) {
+    // Layers of unit cells, in which the bottom cell of one column is
+    // collapsed onto its top in the second case, and collapsed below the
+    // bottom of the grid in the third case.  The pillar nodes of collapsed
+    // cells are on no face, and only those may be left out of the count
+    // recovered from the faces, as happens in the third case.
+    const int nx = 3, ny = 2, nz = 4;
+    std::vector<double> coord;
+    for (int j = 0; j <= ny; ++j) {
+        for (int i = 0; i <= nx; ++i) {
+            coord.insert(coord.end(), { 1.0*i, 1.0*j, 0.0, 1.0*i + 0.1, 1.0*j, 10.0 });
+        }
+    }
+    std::vector<int> actnum(nx*ny*nz, 1);
+
+    for (int variant = 0; variant < 3; ++variant) {
+        std::vector<double> zcorn(8*nx*ny*nz);
+        for (int k2 = 0; k2 < 2*nz; ++k2) {
+            for (int j2 = 0; j2 < 2*ny; ++j2) {
+                for (int i2 = 0; i2 < 2*nx; ++i2) {
+                    double z = (k2 + 1)/2;
+                    if (i2/2 == nx - 1 && j2/2 == ny - 1 && k2 >= 2*nz - 2) {
+                        z = (variant == 1) ? nz - 1 : (variant == 2) ? nz + 1 : z;
+                    }
+                    zcorn[i2 + 2*nx*(j2 + 2*ny*k2)] = z;
+                }
+            }
+        }
+
+        struct grdecl g;
+        g.dims[0] = nx;
+        g.dims[1] = ny;
+        g.dims[2] = nz;
+        g.coord  = coord.data();
+        g.zcorn  = zcorn.data();
+        g.actnum = actnum.data();
+        g.mapaxes = NULL;
+
+        struct processed_grid pg;
+        process_grdecl(&g, 0.0, &pg);
+
+        const int recovered = recoveredPillarNodeCount(pg);
+        BOOST_CHECK_LE(recovered, pg.number_of_nodes_on_pillars);
+        BOOST_CHECK(!hasFaceNodeIn(pg, recovered, pg.number_of_nodes_on_pillars));
+        if (variant == 2) {
+            BOOST_CHECK_LT(recovered, pg.number_of_nodes_on_pillars);
+        } else {
+            BOOST_CHECK_EQUAL(recovered, pg.number_of_nodes_on_pillars);
+        }
+
+        free_processed_grid(&pg);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(HexahedralGeometry) {
+    // Number of cells not divisible by the batch size of the geometry
+    // kernels, such that the last batch is partial.
+    const char *deckData =
+        "RUNSPEC\n"
+        "\n"
+        "DIMENS\n"
+        " 5 3 7 /\n"
+        "GRID\n"
+        "DXV\n"
+        "5*0.25 /\n"
+        "DYV\n"
+        "3*0.5 /\n"
+        "DZV\n"
+        "7*2.0 /\n"
+        "TOPS\n"
+        "15*10.0 /\n"
+        "PORO\n"
+        "   105*0.15 /\n"
+        "EDIT\n"
+        "\n";
+
+    Ewoms::Parser parser;
+    Ewoms::Deck deck = parser.parseString(deckData);
+    Ewoms::EclipseState es(deck);
+    Ewoms::GridManager gridM(es.getInputGrid());
+    const UnstructuredGrid* g = gridM.c_grid();
+
+    BOOST_REQUIRE_EQUAL(g->number_of_cells, 105);
+
+    const double tol = 1.0e-10;
+    for (int f = 0; f < g->number_of_faces; ++f) {
+        BOOST_REQUIRE_EQUAL(g->face_nodepos[f + 1] - g->face_nodepos[f], 4);
+
+        // Face areas follow from the direction of the normal.
+        const double* n = g->face_normals + 3*f;
+        const double expected[] = { 0.5*2.0, 0.25*2.0, 0.25*0.5 };
+        const int axis = std::max_element(n, n + 3, [](double a, double b) {
+            return std::abs(a) < std::abs(b);
+        }) - n;
+        BOOST_CHECK_CLOSE(g->face_areas[f], expected[axis], tol);
+        BOOST_CHECK_CLOSE(std::abs(n[axis]), expected[axis], tol);
+    }
+
+    for (int c = 0; c < g->number_of_cells; ++c) {
+        const int gc = g->global_cell ? g->global_cell[c] : c;
+        const int i = gc % 5, j = (gc / 5) % 3, k = gc / 15;
+        const double* x = g->cell_centroids + 3*c;
+
+        BOOST_CHECK_CLOSE(g->cell_volumes[c], 0.25, tol);
+        BOOST_CHECK_CLOSE(x[0], 0.25*(i + 0.5), tol);
+        BOOST_CHECK_CLOSE(x[1], 0.5*(j + 0.5), tol);
+        BOOST_CHECK_CLOSE(x[2], 10.0 + 2.0*(k + 0.5), tol);
+    }
+}
+
+namespace {
+    // Reference face geometry by the triangle fan around the average
+    // node, one face at a time.
+    void fanFaceGeometry(const UnstructuredGrid& g, int f,
+                         double normal[3], double centroid[3], double& area)
+    {
+        const int* nodes = g.face_nodes + g.face_nodepos[f];
+        const int num_nodes = g.face_nodepos[f + 1] - g.face_nodepos[f];
+        const double* x = g.node_coordinates;
+
+        double mid[3] = { 0.0, 0.0, 0.0 };
+        for (int k = 0; k < num_nodes; ++k) {
+            for (int i = 0; i < 3; ++i) mid[i] += x[3*nodes[k] + i];
+        }
+        for (int i = 0; i < 3; ++i) mid[i] /= num_nodes;
+
+        double u[3], v[3], w[3];
+        double n[3] = { 0.0, 0.0, 0.0 }, c[3] = { 0.0, 0.0, 0.0 };
+        area = 0.0;
+        for (int i = 0; i < 3; ++i) u[i] = x[3*nodes[num_nodes - 1] + i] - mid[i];
+        for (int k = 0; k < num_nodes; ++k) {
+            for (int i = 0; i < 3; ++i) v[i] = x[3*nodes[k] + i] - mid[i];
+            w[0] = u[1]*v[2] - u[2]*v[1];
+            w[1] = u[2]*v[0] - u[0]*v[2];
+            w[2] = u[0]*v[1] - u[1]*v[0];
+            const double a = 0.5*std::sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+            area += a;
+            for (int i = 0; i < 3; ++i) {
+                n[i] += w[i];
+                c[i] += a*(mid[i] + (u[i] + v[i])/3.0);
+                u[i] = v[i];
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            normal[i] = 0.5*n[i];
+            centroid[i] = c[i]/area;
+        }
+    }
+
+    // Reference cell geometry by the tetrahedra between the cell centre
+    // and the face triangle fans, one cell at a time.
+    void fanCellGeometry(const UnstructuredGrid& g, int c,
+                         double centroid[3], double& volume)
+    {
+        const double* x = g.node_coordinates;
+
+        double mid[3] = { 0.0, 0.0, 0.0 };
+        const int num_faces = g.cell_facepos[c + 1] - g.cell_facepos[c];
+        for (int j = g.cell_facepos[c]; j < g.cell_facepos[c + 1]; ++j) {
+            for (int i = 0; i < 3; ++i) mid[i] += g.face_centroids[3*g.cell_faces[j] + i];
+        }
+        for (int i = 0; i < 3; ++i) mid[i] /= num_faces;
+
+        double cc[3] = { 0.0, 0.0, 0.0 };
+        volume = 0.0;
+        for (int j = g.cell_facepos[c]; j < g.cell_facepos[c + 1]; ++j) {
+            const int f = g.cell_faces[j];
+            const int* nodes = g.face_nodes + g.face_nodepos[f];
+            const int num_nodes = g.face_nodepos[f + 1] - g.face_nodepos[f];
+
+            double fmid[3] = { 0.0, 0.0, 0.0 };
+            for (int k = 0; k < num_nodes; ++k) {
+                for (int i = 0; i < 3; ++i) fmid[i] += x[3*nodes[k] + i];
+            }
+            for (int i = 0; i < 3; ++i) fmid[i] /= num_nodes;
+
+            double u[3], v[3], w[3];
+            for (int i = 0; i < 3; ++i) u[i] = x[3*nodes[num_nodes - 1] + i] - fmid[i];
+            for (int k = 0; k < num_nodes; ++k) {
+                for (int i = 0; i < 3; ++i) v[i] = x[3*nodes[k] + i] - fmid[i];
+                w[0] = u[1]*v[2] - u[2]*v[1];
+                w[1] = u[2]*v[0] - u[0]*v[2];
+                w[2] = u[0]*v[1] - u[1]*v[0];
+
+                double tet = 0.0, sign = 0.0;
+                for (int i = 0; i < 3; ++i) {
+                    tet += w[i]*(fmid[i] - mid[i]);
+                    sign += w[i]*g.face_normals[3*f + i];
+                }
+                tet /= 6.0;
+                if (sign < 0.0) tet = -tet;
+                if (g.face_cells[2*f] != c) tet = -tet;
+                volume += tet;
+
+                for (int i = 0; i < 3; ++i) {
+                    cc[i] += 0.75*tet*(fmid[i] + (u[i] + v[i])/3.0 - mid[i]);
+                    u[i] = v[i];
+                }
+            }
+        }
+        for (int i = 0; i < 3; ++i) centroid[i] = mid[i] + cc[i]/volume;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BatchedGeometryMatchesTriangleFans) {
+    // Skewed pillars, non-planar layer interfaces and a fault between
+    // the third and fourth column whose throw changes sign from pillar to
+    // pillar, such that the grid has both quadrilateral and general
+    // polygonal faces.
+    const int nx = 5, ny = 3, nz = 7;
+    std::vector<double> coord;
+    for (int j = 0; j <= ny; ++j) {
+        for (int i = 0; i <= nx; ++i) {
+            coord.insert(coord.end(), { 0.25*i + 0.05*j, 0.5*j, 0.0,
+                                        0.25*i + 0.1*j + 0.03*i, 0.5*j + 0.02*i, 30.0 });
+        }
+    }
+    std::vector<double> zcorn(8*nx*ny*nz);
+    for (int k2 = 0; k2 < 2*nz; ++k2) {
+        for (int j2 = 0; j2 < 2*ny; ++j2) {
+            for (int i2 = 0; i2 < 2*nx; ++i2) {
+                const int pi = (i2 + 1)/2, pj = (j2 + 1)/2, level = (k2 + 1)/2;
+                const double throw_ = (i2/2 >= 3) ? (pj % 2 ? 0.9 : -0.6) : 0.0;
+                zcorn[i2 + 2*nx*(j2 + 2*ny*k2)] = 10.0 + 2.0*level + 0.1*pi + 0.05*pj
+                    + 0.02*((pi*pj + level) % 3) + throw_;
+            }
+        }
+    }
+    std::vector<int> actnum(nx*ny*nz, 1);
+
+    struct grdecl gd;
+    gd.dims[0] = nx;
+    gd.dims[1] = ny;
+    gd.dims[2] = nz;
+    gd.coord  = coord.data();
+    gd.zcorn  = zcorn.data();
+    gd.actnum = actnum.data();
+    gd.mapaxes = NULL;
+
+    UnstructuredGrid* g = create_grid_cornerpoint(&gd, 0.0);
+    BOOST_REQUIRE(g != nullptr);
+
+    // The kernels batch four quadrilaterals or hexahedra at a time; make
+    // sure that the last batch of each is partial and that some faces
+    // are left to the scalar path.
+    int quads = 0, hexes = 0;
+    for (int f = 0; f < g->number_of_faces; ++f) {
+        quads += g->face_nodepos[f + 1] - g->face_nodepos[f] == 4;
+    }
+    for (int c = 0; c < g->number_of_cells; ++c) {
+        bool hex = g->cell_facepos[c + 1] - g->cell_facepos[c] == 6;
+        for (int j = g->cell_facepos[c]; hex && j < g->cell_facepos[c + 1]; ++j) {
+            const int f = g->cell_faces[j];
+            hex = g->face_nodepos[f + 1] - g->face_nodepos[f] == 4;
+        }
+        hexes += hex;
+    }
+    BOOST_REQUIRE_LT(quads, g->number_of_faces);
+    BOOST_REQUIRE_NE(quads % 4, 0);
+    BOOST_REQUIRE_NE(hexes % 4, 0);
+
+    // Relative to the magnitude of each quantity.
+    const double tol = 1.0e-12;
+    auto norm = [](const double* a) { return std::sqrt(a[0]*a[0] + a[1]*a[1] + a[2]*a[2]); };
+    for (int f = 0; f < g->number_of_faces; ++f) {
+        double normal[3], centroid[3], area;
+        fanFaceGeometry(*g, f, normal, centroid, area);
+        BOOST_CHECK_SMALL(g->face_areas[f] - area, tol*area);
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK_SMALL(g->face_normals[3*f + i] - normal[i], tol*norm(normal));
+            BOOST_CHECK_SMALL(g->face_centroids[3*f + i] - centroid[i], tol*norm(centroid));
+        }
+    }
+    for (int c = 0; c < g->number_of_cells; ++c) {
+        double centroid[3], volume;
+        fanCellGeometry(*g, c, centroid, volume);
+        BOOST_CHECK_SMALL(g->cell_volumes[c] - volume, tol*volume);
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK_SMALL(g->cell_centroids[3*c + i] - centroid[i], tol*norm(centroid));
+        }
+    }
+
+    destroy_grid(g);
+}